@@ -0,0 +1,294 @@
+#include "Benchmark.h"
+#include "Core/AssetManager.h"
+#include "Core/TextureAtlas.h"
+#include "Core/TextureCompression.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+static const char* MASTER_MATERIAL = "Resources/Assets/Materials/MM_glitch.json";
+static const char* INSTANCE_MATERIAL = "Resources/Assets/Materials/MI_default_red.json";
+
+static void BM_GetMaterialAsset_Hit(BenchmarkState& state)
+{
+    AssetManager& assets = AssetManager::GetInstance();
+    std::shared_ptr<MaterialAsset> loaded = assets.GetMaterialAsset(MASTER_MATERIAL);
+    if (!loaded)
+    {
+        state.SkipWithError("failed to load MM_glitch.json");
+        return;
+    }
+
+    for (auto _ : state)
+    {
+        DoNotOptimize(assets.GetMaterialAsset(MASTER_MATERIAL));
+    }
+    state.SetItemsProcessed(state.Iterations());
+}
+ENGINE_BENCHMARK(BM_GetMaterialAsset_Hit);
+
+// Every iteration releases the asset and collects it, so the lookup misses and reloads the file
+static void MaterialAssetMissBenchmark(BenchmarkState& state, const char* path)
+{
+    AssetManager& assets = AssetManager::GetInstance();
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        assets.GarbageCollect();
+        state.ResumeTiming();
+
+        std::shared_ptr<MaterialAsset> loaded = assets.GetMaterialAsset(path);
+        if (!loaded)
+        {
+            state.SkipWithError(std::string("failed to load ") + path);
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.Iterations());
+}
+
+static void BM_GetMaterialAsset_Miss(BenchmarkState& state)
+{
+    MaterialAssetMissBenchmark(state, MASTER_MATERIAL);
+}
+ENGINE_BENCHMARK(BM_GetMaterialAsset_Miss);
+
+// Material instances also resolve their parent on a miss
+static void BM_GetMaterialAsset_MissInstance(BenchmarkState& state)
+{
+    MaterialAssetMissBenchmark(state, INSTANCE_MATERIAL);
+}
+ENGINE_BENCHMARK(BM_GetMaterialAsset_MissInstance);
+
+// File read and JSON parse of a master material, without the AssetManager
+static void BM_MaterialAsset_Load(BenchmarkState& state)
+{
+    for (auto _ : state)
+    {
+        MaterialAsset asset(MASTER_MATERIAL);
+        DoNotOptimize(asset.GetUniforms());
+    }
+    state.SetItemsProcessed(state.Iterations());
+}
+ENGINE_BENCHMARK(BM_MaterialAsset_Load);
+
+// JSON parse only, from a string already in memory
+static void BM_MaterialAsset_ParseJson(BenchmarkState& state)
+{
+    std::ifstream file(MASTER_MATERIAL);
+    if (!file.is_open())
+    {
+        state.SkipWithError("failed to open MM_glitch.json");
+        return;
+    }
+    std::stringstream stream;
+    stream << file.rdbuf();
+    const std::string source = stream.str();
+
+    for (auto _ : state)
+    {
+        nlohmann::json data = nlohmann::json::parse(source);
+        DoNotOptimize(data);
+    }
+    state.SetBytesProcessed(state.Iterations() * static_cast<int64_t>(source.size()));
+}
+ENGINE_BENCHMARK(BM_MaterialAsset_ParseJson);
+
+// Shader and texture are already cached after the first call: this measures the Material
+// construction and the resolution of its parameters
+static void BM_CreateMaterialFromAsset(BenchmarkState& state)
+{
+    AssetManager& assets = AssetManager::GetInstance();
+    std::shared_ptr<MaterialAsset> asset = assets.GetMaterialAsset(MASTER_MATERIAL);
+    if (!asset || !assets.CreateMaterialFromAsset(asset))
+    {
+        state.SkipWithError("failed to create a material from MM_glitch.json");
+        return;
+    }
+
+    for (auto _ : state)
+    {
+        DoNotOptimize(assets.CreateMaterialFromAsset(asset));
+    }
+    state.SetItemsProcessed(state.Iterations());
+}
+ENGINE_BENCHMARK(BM_CreateMaterialFromAsset);
+
+// Cached path used every draw by the renderer
+static void BM_GetMaterial_Cached(BenchmarkState& state)
+{
+    AssetManager& assets = AssetManager::GetInstance();
+    std::shared_ptr<MaterialAsset> asset = assets.GetMaterialAsset(MASTER_MATERIAL);
+    if (!asset || !assets.GetMaterial(asset))
+    {
+        state.SkipWithError("failed to create a material from MM_glitch.json");
+        return;
+    }
+
+    for (auto _ : state)
+    {
+        DoNotOptimize(assets.GetMaterial(asset));
+    }
+    state.SetItemsProcessed(state.Iterations());
+}
+ENGINE_BENCHMARK(BM_GetMaterial_Cached);
+
+// Packs sprite-sized rectangles (8 to 64 px, padding included) into one atlas page, starting
+// over when it is full. Reports how much of the page is used when an insert first fails.
+static void BM_SkylinePacker_Insert(BenchmarkState& state)
+{
+    std::vector<std::pair<int, int>> sizes(4096);
+    uint32_t seed = 12345;
+    for (auto& size : sizes)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        size.first = 8 + static_cast<int>((seed >> 8) % 57);
+        seed = seed * 1664525u + 1013904223u;
+        size.second = 8 + static_cast<int>((seed >> 8) % 57);
+    }
+
+    SkylinePacker packer;
+    AtlasRect rect;
+    size_t next = 0;
+    int64_t fullPages = 0;
+    double occupancy = 0.0;
+    for (auto _ : state)
+    {
+        const std::pair<int, int>& size = sizes[next++ % sizes.size()];
+        if (!packer.Insert(size.first, size.second, rect))
+        {
+            occupancy += static_cast<double>(packer.GetUsedArea()) / (static_cast<double>(ATLAS_PAGE_SIZE) * ATLAS_PAGE_SIZE);
+            fullPages++;
+            packer.Reset();
+        }
+        DoNotOptimize(rect);
+    }
+    state.SetItemsProcessed(state.Iterations());
+    if (fullPages > 0)
+    {
+        state.counters["page_occupancy"] = occupancy / fullPages;
+    }
+}
+ENGINE_BENCHMARK(BM_SkylinePacker_Insert);
+
+// Cooker side cost of compressing a 256x256 gradient with noise, mip chain included. The
+// counter is the PSNR of level 0 after decoding.
+static void TextureCompressionBenchmark(BenchmarkState& state, bool opaque)
+{
+    TextureImage image;
+    image.width = 256;
+    image.height = 256;
+    image.pixels.resize(image.GetSize());
+    uint32_t seed = 12345;
+    for (int y = 0; y < image.height; ++y)
+    {
+        for (int x = 0; x < image.width; ++x)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            unsigned char* texel = image.pixels.data() + (static_cast<size_t>(y) * image.width + x) * 4;
+            texel[0] = static_cast<unsigned char>(x);
+            texel[1] = static_cast<unsigned char>(y);
+            texel[2] = static_cast<unsigned char>((x + y) / 2 + ((seed >> 24) & 15));
+            texel[3] = opaque ? 255 : static_cast<unsigned char>(255 - x);
+        }
+    }
+
+    std::vector<unsigned char> encoded;
+    for (auto _ : state)
+    {
+        encoded = TextureCompression::Encode(image);
+        DoNotOptimize(encoded.data());
+    }
+    state.SetBytesProcessed(state.Iterations() * static_cast<int64_t>(image.GetSize()));
+
+    TextureImage compressed;
+    if (TextureCompression::Read(encoded.data(), encoded.size(), compressed))
+    {
+        TextureImage decoded = TextureCompression::Decompress(compressed);
+        double squaredError = 0.0;
+        for (size_t i = 0; i < image.GetSize(); ++i)
+        {
+            double difference = static_cast<double>(image.pixels[i]) - decoded.pixels[i];
+            squaredError += difference * difference;
+        }
+        double meanSquaredError = std::max(squaredError / static_cast<double>(image.GetSize()), 1e-9);
+        state.counters["psnr_db"] = 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+        state.counters["compression_ratio"] = static_cast<double>(image.GetSize()) / static_cast<double>(compressed.levels[0].size);
+    }
+}
+
+static void BM_TextureCompression_EncodeBC1(BenchmarkState& state)
+{
+    TextureCompressionBenchmark(state, true);
+}
+ENGINE_BENCHMARK(BM_TextureCompression_EncodeBC1);
+
+static void BM_TextureCompression_EncodeBC3(BenchmarkState& state)
+{
+    TextureCompressionBenchmark(state, false);
+}
+ENGINE_BENCHMARK(BM_TextureCompression_EncodeBC3);
+
+// Worker side cost of the mip chain of a streamed 1024x1024 SMOOTH texture
+static void BM_Texture_GenerateMipmaps(BenchmarkState& state)
+{
+    TextureImage source;
+    source.width = 1024;
+    source.height = 1024;
+    source.pixels.resize(source.GetSize());
+    for (size_t i = 0; i < source.pixels.size(); ++i)
+    {
+        source.pixels[i] = static_cast<unsigned char>(i * 7);
+    }
+
+    for (auto _ : state)
+    {
+        TextureImage image;
+        image.width = source.width;
+        image.height = source.height;
+        image.mapped = source.pixels.data();
+        Texture::GenerateMipmaps(image);
+        DoNotOptimize(image.pixels.data());
+    }
+    state.SetBytesProcessed(state.Iterations() * static_cast<int64_t>(source.GetSize()));
+}
+ENGINE_BENCHMARK(BM_Texture_GenerateMipmaps);
+
+// Cost of a shader cache miss before any compile: sources read, includes and defines applied,
+// content key computed. A variant that turns out identical to a cached program stops here.
+static void BM_Shader_LoadSourcesAndKey(BenchmarkState& state)
+{
+    const std::map<unsigned int, std::string> paths = {
+        { GL_VERTEX_SHADER, "Resources/Assets/Shaders/Basic/Quad.vert" },
+        { GL_FRAGMENT_SHADER, "Resources/Assets/Shaders/Basic/Quad.frag" }
+    };
+    const std::vector<std::string> defines = { "GLITCH", "TEXTURED", "TINTED" };
+
+    size_t bytes = 0;
+    for (auto _ : state)
+    {
+        ShaderSources sources = Shader::LoadSources(paths, defines);
+        DoNotOptimize(Shader::ComputeContentKey(sources));
+        bytes = sources[0].second.size() + sources[1].second.size();
+    }
+    state.SetBytesProcessed(state.Iterations() * static_cast<int64_t>(bytes));
+}
+ENGINE_BENCHMARK(BM_Shader_LoadSourcesAndKey);
+
+// Content key alone, over the same sources
+static void BM_Shader_ComputeContentKey(BenchmarkState& state)
+{
+    const ShaderSources sources = Shader::LoadSources({
+        { GL_VERTEX_SHADER, "Resources/Assets/Shaders/Basic/Quad.vert" },
+        { GL_FRAGMENT_SHADER, "Resources/Assets/Shaders/Basic/Quad.frag" }
+    }, { "GLITCH", "TEXTURED", "TINTED" });
+
+    for (auto _ : state)
+    {
+        DoNotOptimize(Shader::ComputeContentKey(sources));
+    }
+    state.SetBytesProcessed(state.Iterations() * static_cast<int64_t>(sources[0].second.size() + sources[1].second.size()));
+}
+ENGINE_BENCHMARK(BM_Shader_ComputeContentKey);
@@ -0,0 +1,568 @@
+#include "Benchmark.h"
+#include "Core/SpriteTransform.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <regex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+static double RealSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double CpuSeconds()
+{
+    return static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+}
+
+// BenchmarkState
+
+BenchmarkState::BenchmarkState(int64_t maxIterations) : maxIterations(maxIterations), remaining(maxIterations)
+{
+}
+
+bool BenchmarkState::Iterator::operator!=(const Iterator&)
+{
+    if (remaining > 0)
+    {
+        return true;
+    }
+    state->remaining = 0;
+    state->FinishKeepRunning();
+    return false;
+}
+
+BenchmarkState::Iterator BenchmarkState::begin()
+{
+    StartKeepRunning();
+    return { this, (errorOccurred || skipped) ? 0 : maxIterations };
+}
+
+BenchmarkState::Iterator BenchmarkState::end()
+{
+    return { this, 0 };
+}
+
+bool BenchmarkState::KeepRunning()
+{
+    if (!started)
+    {
+        StartKeepRunning();
+    }
+    if (remaining > 0 && !errorOccurred && !skipped)
+    {
+        --remaining;
+        return true;
+    }
+    FinishKeepRunning();
+    return false;
+}
+
+void BenchmarkState::PauseTiming()
+{
+    if (running)
+    {
+        realTime += RealSeconds() - realStart;
+        cpuTime += CpuSeconds() - cpuStart;
+        running = false;
+    }
+}
+
+void BenchmarkState::ResumeTiming()
+{
+    if (!running)
+    {
+        realStart = RealSeconds();
+        cpuStart = CpuSeconds();
+        running = true;
+    }
+}
+
+void BenchmarkState::SetItemsProcessed(int64_t items)
+{
+    itemsProcessed = items;
+}
+
+void BenchmarkState::SetBytesProcessed(int64_t bytes)
+{
+    bytesProcessed = bytes;
+}
+
+void BenchmarkState::SetLabel(const std::string& label)
+{
+    this->label = label;
+}
+
+void BenchmarkState::SkipWithError(const std::string& message)
+{
+    errorOccurred = true;
+    errorMessage = message;
+    remaining = 0;
+}
+
+void BenchmarkState::SkipWithMessage(const std::string& message)
+{
+    skipped = true;
+    errorMessage = message;
+    remaining = 0;
+}
+
+int64_t BenchmarkState::Iterations() const
+{
+    return maxIterations - remaining;
+}
+
+void BenchmarkState::StartKeepRunning()
+{
+    started = true;
+    ResumeTiming();
+}
+
+void BenchmarkState::FinishKeepRunning()
+{
+    if (!finished)
+    {
+        PauseTiming();
+        finished = true;
+    }
+}
+
+// Registry
+
+struct RegisteredBenchmark
+{
+    std::string name;
+    BenchmarkFunction function;
+};
+
+static std::vector<RegisteredBenchmark>& GetRegistry()
+{
+    static std::vector<RegisteredBenchmark> registry;
+    return registry;
+}
+
+bool RegisterBenchmark(const char* name, BenchmarkFunction function)
+{
+    GetRegistry().push_back({ name, function });
+    return true;
+}
+
+// Runner
+
+struct BenchmarkResult
+{
+    std::string name;
+    int64_t iterations = 0;
+    double realTimeNs = 0.0;    // per iteration
+    double cpuTimeNs = 0.0;     // per iteration
+    double itemsPerSecond = 0.0;
+    double bytesPerSecond = 0.0;
+    std::string label;
+    std::map<std::string, double> counters;
+    bool errorOccurred = false;
+    bool skipped = false;
+    std::string errorMessage;   // also the skip message
+};
+
+class BenchmarkRunner
+{
+public:
+    static BenchmarkResult Run(const RegisteredBenchmark& benchmark, double minTime)
+    {
+        const int64_t MAX_ITERATIONS = 1000000000;
+
+        int64_t iterations = 1;
+        while (true)
+        {
+            BenchmarkState state(iterations);
+            benchmark.function(state);
+            state.FinishKeepRunning();
+
+            if (!state.errorOccurred && !state.skipped && state.Iterations() != iterations)
+            {
+                state.SkipWithError("benchmark returned before running all iterations");
+            }
+
+            // Same growth policy as Google Benchmark: aim 40% past the minimum time, at most 10x per step
+            bool enough = state.realTime >= minTime || iterations >= MAX_ITERATIONS;
+            if (state.errorOccurred || state.skipped || enough)
+            {
+                return MakeResult(benchmark.name, state);
+            }
+
+            double multiplier = (state.realTime > 1e-9) ? minTime * 1.4 / state.realTime : 10.0;
+            multiplier = std::clamp(multiplier, 1.0, 10.0);
+            int64_t next = static_cast<int64_t>(std::ceil(static_cast<double>(iterations) * multiplier));
+            iterations = std::min(std::max(next, iterations + 1), MAX_ITERATIONS);
+        }
+    }
+
+private:
+    static BenchmarkResult MakeResult(const std::string& name, const BenchmarkState& state)
+    {
+        BenchmarkResult result;
+        result.name = name;
+        result.iterations = state.Iterations();
+        result.label = state.label;
+        result.counters = state.counters;
+        result.errorOccurred = state.errorOccurred;
+        result.skipped = state.skipped;
+        result.errorMessage = state.errorMessage;
+
+        if (result.iterations > 0)
+        {
+            result.realTimeNs = state.realTime * 1e9 / static_cast<double>(result.iterations);
+            result.cpuTimeNs = state.cpuTime * 1e9 / static_cast<double>(result.iterations);
+        }
+        if (state.realTime > 0.0)
+        {
+            result.itemsPerSecond = static_cast<double>(state.itemsProcessed) / state.realTime;
+            result.bytesPerSecond = static_cast<double>(state.bytesProcessed) / state.realTime;
+        }
+        return result;
+    }
+};
+
+// Reporters
+
+static nlohmann::json MakeContext(const char* executable)
+{
+    std::time_t now = std::time(nullptr);
+    char date[64];
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    nlohmann::json context;
+    context["date"] = date;
+    context["executable"] = executable;
+    context["num_cpus"] = std::thread::hardware_concurrency();
+    context["simd_level"] = GetSimdLevelName(GetSupportedSimdLevel());
+    context["gl_backend"] = "null";
+#ifdef NDEBUG
+    context["library_build_type"] = "release";
+#else
+    context["library_build_type"] = "debug";
+#endif
+    return context;
+}
+
+static void WriteJson(std::ostream& out, const char* executable, const std::vector<BenchmarkResult>& results)
+{
+    nlohmann::json report;
+    report["context"] = MakeContext(executable);
+    report["benchmarks"] = nlohmann::json::array();
+
+    for (const BenchmarkResult& result : results)
+    {
+        nlohmann::json entry;
+        entry["name"] = result.name;
+        entry["iterations"] = result.iterations;
+        entry["real_time"] = result.realTimeNs;
+        entry["cpu_time"] = result.cpuTimeNs;
+        entry["time_unit"] = "ns";
+        if (result.itemsPerSecond > 0.0)
+        {
+            entry["items_per_second"] = result.itemsPerSecond;
+        }
+        if (result.bytesPerSecond > 0.0)
+        {
+            entry["bytes_per_second"] = result.bytesPerSecond;
+        }
+        if (!result.label.empty())
+        {
+            entry["label"] = result.label;
+        }
+        for (const auto& [counter, value] : result.counters)
+        {
+            entry[counter] = value;
+        }
+        if (result.errorOccurred)
+        {
+            entry["error_occurred"] = true;
+            entry["error_message"] = result.errorMessage;
+        }
+        if (result.skipped)
+        {
+            entry["skipped"] = true;
+            entry["skip_message"] = result.errorMessage;
+        }
+        report["benchmarks"].push_back(entry);
+    }
+    out << report.dump(2) << std::endl;
+}
+
+static std::string CsvEscape(const std::string& value)
+{
+    std::string escaped = "\"";
+    for (char c : value)
+    {
+        if (c == '"')
+        {
+            escaped += '"';
+        }
+        escaped += c;
+    }
+    return escaped + "\"";
+}
+
+static void WriteCsv(std::ostream& out, const std::vector<BenchmarkResult>& results)
+{
+    // User counters become extra columns, empty where a benchmark does not report them
+    std::set<std::string> counterNames;
+    for (const BenchmarkResult& result : results)
+    {
+        for (const auto& [counter, value] : result.counters)
+        {
+            counterNames.insert(counter);
+        }
+    }
+
+    out << "name,iterations,real_time,cpu_time,time_unit,bytes_per_second,items_per_second,label,error_occurred,error_message";
+    for (const std::string& counter : counterNames)
+    {
+        out << "," << CsvEscape(counter);
+    }
+    out << "\n";
+
+    for (const BenchmarkResult& result : results)
+    {
+        out << CsvEscape(result.name) << "," << result.iterations << "," << result.realTimeNs << "," << result.cpuTimeNs << ",ns,";
+        if (result.bytesPerSecond > 0.0)
+        {
+            out << result.bytesPerSecond;
+        }
+        out << ",";
+        if (result.itemsPerSecond > 0.0)
+        {
+            out << result.itemsPerSecond;
+        }
+        out << "," << CsvEscape(result.label) << "," << (result.errorOccurred ? "true" : "false") << "," << CsvEscape(result.errorMessage);
+        for (const std::string& counter : counterNames)
+        {
+            out << ",";
+            auto it = result.counters.find(counter);
+            if (it != result.counters.end())
+            {
+                out << it->second;
+            }
+        }
+        out << "\n";
+    }
+    out.flush();
+}
+
+static void WriteConsoleHeader(std::ostream& out, size_t nameWidth)
+{
+    out << std::left << std::setw(static_cast<int>(nameWidth)) << "Benchmark" << std::right
+        << std::setw(15) << "Time" << std::setw(15) << "CPU" << std::setw(13) << "Iterations" << std::endl;
+    out << std::string(nameWidth + 43, '-') << std::endl;
+}
+
+static void WriteConsoleLine(std::ostream& out, size_t nameWidth, const BenchmarkResult& result)
+{
+    out << std::left << std::setw(static_cast<int>(nameWidth)) << result.name << std::right;
+    if (result.errorOccurred)
+    {
+        out << " ERROR OCCURRED: '" << result.errorMessage << "'" << std::endl;
+        return;
+    }
+    if (result.skipped)
+    {
+        out << " SKIPPED: '" << result.errorMessage << "'" << std::endl;
+        return;
+    }
+
+    out << std::fixed << std::setprecision(1)
+        << std::setw(12) << result.realTimeNs << " ns" << std::setw(12) << result.cpuTimeNs << " ns" << std::setw(13) << result.iterations;
+    if (result.itemsPerSecond > 0.0)
+    {
+        out << " items/s=" << std::setprecision(4) << std::defaultfloat << result.itemsPerSecond;
+    }
+    if (result.bytesPerSecond > 0.0)
+    {
+        out << " bytes/s=" << std::setprecision(4) << std::defaultfloat << result.bytesPerSecond;
+    }
+    for (const auto& [counter, value] : result.counters)
+    {
+        out << " " << counter << "=" << std::setprecision(4) << std::defaultfloat << value;
+    }
+    if (!result.label.empty())
+    {
+        out << " " << result.label;
+    }
+    out << std::defaultfloat << std::endl;
+}
+
+// Command line
+
+struct BenchmarkOptions
+{
+    std::string filter = ".";
+    double minTime = 0.5;
+    std::string format = "console";
+    std::string outPath;
+    std::string outFormat = "json";
+    bool listTests = false;
+};
+
+static bool ParseFlag(const std::string& argument, const std::string& flag, std::string& value)
+{
+    const std::string prefix = "--" + flag + "=";
+    if (argument.rfind(prefix, 0) != 0)
+    {
+        return false;
+    }
+    value = argument.substr(prefix.size());
+    return true;
+}
+
+static bool ParseOptions(int argc, char** argv, BenchmarkOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        std::string value;
+        if (ParseFlag(argument, "benchmark_filter", value))
+        {
+            options.filter = value;
+        }
+        else if (ParseFlag(argument, "benchmark_min_time", value))
+        {
+            // Accepts both "0.5" and "0.5s"
+            if (!value.empty() && value.back() == 's')
+            {
+                value.pop_back();
+            }
+            options.minTime = std::stod(value);
+        }
+        else if (ParseFlag(argument, "benchmark_format", value))
+        {
+            options.format = value;
+        }
+        else if (ParseFlag(argument, "benchmark_out", value))
+        {
+            options.outPath = value;
+        }
+        else if (ParseFlag(argument, "benchmark_out_format", value))
+        {
+            options.outFormat = value;
+        }
+        else if (argument == "--benchmark_list_tests" || argument == "--benchmark_list_tests=true")
+        {
+            options.listTests = true;
+        }
+        else
+        {
+            std::cerr << "ERROR: Unknown benchmark option: " << argument << std::endl;
+            return false;
+        }
+    }
+
+    if (options.format != "console" && options.format != "json" && options.format != "csv")
+    {
+        std::cerr << "ERROR: Unknown benchmark format: " << options.format << std::endl;
+        return false;
+    }
+    if (options.outFormat != "json" && options.outFormat != "csv")
+    {
+        std::cerr << "ERROR: Unknown benchmark output format: " << options.outFormat << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int RunBenchmarks(int argc, char** argv, std::ostream& report)
+{
+    BenchmarkOptions options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        return EXIT_FAILURE;
+    }
+
+    std::regex filter;
+    try
+    {
+        filter = std::regex(options.filter);
+    }
+    catch (const std::regex_error& e)
+    {
+        std::cerr << "ERROR: Invalid benchmark filter '" << options.filter << "': " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<const RegisteredBenchmark*> selected;
+    size_t nameWidth = 10;
+    for (const RegisteredBenchmark& benchmark : GetRegistry())
+    {
+        if (std::regex_search(benchmark.name, filter))
+        {
+            selected.push_back(&benchmark);
+            nameWidth = std::max(nameWidth, benchmark.name.size() + 2);
+        }
+    }
+
+    if (options.listTests)
+    {
+        for (const RegisteredBenchmark* benchmark : selected)
+        {
+            report << benchmark->name << std::endl;
+        }
+        return EXIT_SUCCESS;
+    }
+
+    const bool console = options.format == "console";
+    if (console)
+    {
+        WriteConsoleHeader(report, nameWidth);
+    }
+
+    std::vector<BenchmarkResult> results;
+    bool success = true;
+    for (const RegisteredBenchmark* benchmark : selected)
+    {
+        BenchmarkResult result = BenchmarkRunner::Run(*benchmark, options.minTime);
+        success &= !result.errorOccurred;
+        if (console)
+        {
+            WriteConsoleLine(report, nameWidth, result);
+        }
+        results.push_back(std::move(result));
+    }
+
+    if (options.format == "json")
+    {
+        WriteJson(report, argv[0], results);
+    }
+    else if (options.format == "csv")
+    {
+        WriteCsv(report, results);
+    }
+
+    if (!options.outPath.empty())
+    {
+        std::ofstream out(options.outPath);
+        if (!out.is_open())
+        {
+            std::cerr << "ERROR: Failed to open benchmark output file: " << options.outPath << std::endl;
+            return EXIT_FAILURE;
+        }
+        if (options.outFormat == "csv")
+        {
+            WriteCsv(out, results);
+        }
+        else
+        {
+            WriteJson(out, argv[0], results);
+        }
+    }
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <streambuf>
+#include <string>
+
+// Minimal benchmark harness with the same shape as Google Benchmark: functions registered with
+// ENGINE_BENCHMARK receive a BenchmarkState and loop over it, the runner picks the iteration
+// count so each benchmark runs for at least --benchmark_min_time seconds.
+//
+// Command line:
+//   --benchmark_filter=<regex>          runs only the matching benchmarks
+//   --benchmark_min_time=<seconds>      minimum measured time per benchmark (default 0.5)
+//   --benchmark_format=console|json|csv report printed on stdout
+//   --benchmark_out=<file>              also writes the report to a file
+//   --benchmark_out_format=json|csv     format of the file report (default json)
+//   --benchmark_list_tests              prints the registered names and exits
+class BenchmarkState
+{
+public:
+    explicit BenchmarkState(int64_t maxIterations);
+
+    // Range-for support: for (auto _ : state) { ... }
+    struct Iterator
+    {
+        BenchmarkState* state;
+        int64_t remaining;
+
+        bool operator!=(const Iterator&);
+        void operator++()
+        {
+            --remaining;
+        }
+        // Marked unused so "for (auto _ : state)" does not trigger -Wunused-variable
+#if defined(__GNUC__) || defined(__clang__)
+        struct __attribute__((unused)) Value
+#else
+        struct Value
+#endif
+        {
+        };
+        Value operator*() const
+        {
+            return {};
+        }
+    };
+    Iterator begin();
+    Iterator end();
+
+    // Classic loop: while (state.KeepRunning()) { ... }
+    bool KeepRunning();
+
+    // Excludes setup work inside the loop from the measured time
+    void PauseTiming();
+    void ResumeTiming();
+
+    void SetItemsProcessed(int64_t items);
+    void SetBytesProcessed(int64_t bytes);
+    void SetLabel(const std::string& label);
+    // Marks the run as failed. The benchmark should return right after.
+    void SkipWithError(const std::string& message);
+    // Skips the benchmark without failing the run (e.g. an instruction set the CPU lacks)
+    void SkipWithMessage(const std::string& message);
+
+    int64_t Iterations() const;
+
+    // Free-form values reported next to the timings, written as-is
+    std::map<std::string, double> counters;
+
+private:
+    friend class BenchmarkRunner;
+
+    int64_t maxIterations;
+    int64_t remaining;
+    bool started = false;
+    bool running = false;
+    bool finished = false;
+
+    double realTime = 0.0;  // seconds
+    double cpuTime = 0.0;   // seconds
+    double realStart = 0.0;
+    double cpuStart = 0.0;
+
+    int64_t itemsProcessed = 0;
+    int64_t bytesProcessed = 0;
+    std::string label;
+    bool errorOccurred = false;
+    std::string errorMessage;
+    bool skipped = false;
+
+    void StartKeepRunning();
+    void FinishKeepRunning();
+};
+
+using BenchmarkFunction = void (*)(BenchmarkState&);
+
+bool RegisterBenchmark(const char* name, BenchmarkFunction function);
+
+// Runs the registered benchmarks according to the command line, returns the process exit code.
+// The report and the test list go to 'report' only, so engine logs on std::cout cannot mix in.
+int RunBenchmarks(int argc, char** argv, std::ostream& report);
+
+#define ENGINE_BENCHMARK(function) static const bool function##Registered = RegisterBenchmark(#function, function)
+
+// Discards everything written to std::cout while alive. Set up before any engine thread starts
+// and restored only once they are idle: swapping the buffer while a thread writes is a data race.
+class ScopedSilentOutput
+{
+public:
+    ScopedSilentOutput() : previous(std::cout.rdbuf(&discard))
+    {
+    }
+    ~ScopedSilentOutput()
+    {
+        std::cout.rdbuf(previous);
+    }
+
+private:
+    struct DiscardBuffer : std::streambuf
+    {
+        int overflow(int c) override
+        {
+            return c;
+        }
+    };
+    DiscardBuffer discard;
+    std::streambuf* previous;
+};
+
+// Keeps the compiler from discarding a value computed only for the benchmark
+template<typename T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static const volatile void* sink;
+    sink = &value;
+#endif
+}
@@ -0,0 +1,68 @@
+#include "Benchmark.h"
+#include "Core/Engine.h"
+#include "Core/AssetManager.h"
+#include "Core/NullGL.h"
+
+// Full frames on the null GL backend: ECS, sprite packing, material setup and draw submission,
+// without a GPU or a window. One iteration is one frame.
+static const int GRID_SIZE = 100;
+static const unsigned int WARMUP_FRAMES = 10;
+
+// One instanced draw for the sprite grid plus the two debug quads drawn by the engine
+static const uint64_t EXPECTED_DRAWS_PER_FRAME = 3;
+
+static void BM_HeadlessFrame(BenchmarkState& state)
+{
+    Engine engine(1280, 720, "Headless", EngineMode::Headless);
+    flecs::world& world = engine.GetWorld();
+
+    unsigned int spriteMaterial = AssetManager::GetInstance().RegisterMaterial("Resources/Assets/Materials/MM_sprite.json");
+    if (spriteMaterial == 0)
+    {
+        state.SkipWithError("failed to load MM_sprite.json");
+        return;
+    }
+
+    for (int y = 0; y < GRID_SIZE; ++y)
+    {
+        for (int x = 0; x < GRID_SIZE; ++x)
+        {
+            world.entity()
+                .set<Position>({ x * 12.0f, y * 12.0f })
+                .set<Rotation>({ static_cast<float>(x + y) })
+                .set<Scale>({ 8.0f, 8.0f })
+                .set<SpriteRef>({ 0 })
+                .set<MaterialRef>({ spriteMaterial });
+        }
+    }
+
+    // Lets the texture decode finish and the upload queue drain before measuring
+    AssetManager::GetInstance().WaitForAllLoads();
+    engine.RunFrames(WARMUP_FRAMES);
+    ResetNullGLStats();
+
+    uint64_t stateChangesSaved = 0;
+    for (auto _ : state)
+    {
+        engine.RunFrames(1);
+        stateChangesSaved += engine.GetRenderQueueStats().stateChangesSaved;
+    }
+
+    const GLCallStats& stats = GetNullGLStats();
+    const double frames = static_cast<double>(state.Iterations());
+    state.counters["gl_calls"] = stats.calls / frames;
+    state.counters["draws"] = stats.drawCalls / frames;
+    state.counters["instances"] = stats.instances / frames;
+    state.counters["state_changes"] = stats.stateChanges / frames;
+    state.counters["state_changes_saved"] = stateChangesSaved / frames;
+    state.counters["uniform_updates"] = stats.uniformUpdates / frames;
+    state.counters["bytes_uploaded"] = stats.bytesUploaded / frames;
+    state.SetItemsProcessed(state.Iterations() * GRID_SIZE * GRID_SIZE);
+
+    // Batching regression: every sprite sharing the material must stay in a single draw
+    if (stats.drawCalls != EXPECTED_DRAWS_PER_FRAME * static_cast<uint64_t>(state.Iterations()))
+    {
+        state.SkipWithError("sprites are no longer batched in a single draw");
+    }
+}
+ENGINE_BENCHMARK(BM_HeadlessFrame);
@@ -0,0 +1,36 @@
+#include <iostream>
+#include <cstdlib>
+#include "Benchmark.h"
+#include "Core/NullGL.h"
+#include "Core/AssetManager.h"
+
+// Verifica di correttezza dei kernel SIMD: tempi di un kernel sbagliato non hanno senso
+bool CheckSpriteTransformKernels();
+
+int main(int argc, char** argv)
+{
+    if (!CheckSpriteTransformKernels())
+    {
+        return EXIT_FAILURE;
+    }
+
+    // Shader, texture e materiali vengono creati sul backend GL nullo: nessuna GPU richiesta.
+    // I percorsi delle risorse sono relativi, la cartella Resources viene copiata accanto all'eseguibile.
+    if (!LoadNullGL())
+    {
+        std::cerr << "ERROR: Failed to initialize the null GL backend" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Il motore scrive su std::cout anche dai worker degli asset, in momenti qualsiasi: i log
+    // vengono scartati per tutta l'esecuzione e il report va sullo stdout originale
+    std::ostream report(std::cout.rdbuf());
+    int result;
+    {
+        ScopedSilentOutput silence;
+        result = RunBenchmarks(argc, argv, report);
+        // Nessun worker deve scrivere mentre std::cout torna al suo buffer
+        AssetManager::GetInstance().WaitForAllLoads();
+    }
+    return result;
+}
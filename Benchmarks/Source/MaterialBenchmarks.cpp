@@ -0,0 +1,109 @@
+#include "Benchmark.h"
+#include "Core/AssetManager.h"
+#include "Core/NullGL.h"
+#include "Core/RenderQueue.h"
+
+static const char* MATERIAL_PATH = "Resources/Assets/Materials/MM_glitch.json";
+
+static std::shared_ptr<Material> LoadMaterial()
+{
+    AssetManager& assets = AssetManager::GetInstance();
+    return assets.GetMaterial(assets.GetMaterialAsset(MATERIAL_PATH));
+}
+
+// Lookup by name through the per-shader cache, the path taken by the string based setters
+static void BM_Shader_GetUniformLocation(BenchmarkState& state)
+{
+    std::shared_ptr<Material> material = LoadMaterial();
+    if (!material)
+    {
+        state.SkipWithError("failed to create a material from MM_glitch.json");
+        return;
+    }
+
+    const Shader& shader = *material->GetShader();
+    const std::string names[] = { "uColor", "texture_diffuse", "model" };
+    for (const std::string& name : names)
+    {
+        shader.GetUniformLocation(name);
+    }
+
+    size_t index = 0;
+    for (auto _ : state)
+    {
+        DoNotOptimize(shader.GetUniformLocation(names[index]));
+        index = (index + 1) % 3;
+    }
+    state.SetItemsProcessed(state.Iterations());
+}
+ENGINE_BENCHMARK(BM_Shader_GetUniformLocation);
+
+// Material setup of one draw against the null GL backend, GL calls per Use() as counters
+static void BM_Material_Use(BenchmarkState& state)
+{
+    std::shared_ptr<Material> material = LoadMaterial();
+    if (!material)
+    {
+        state.SkipWithError("failed to create a material from MM_glitch.json");
+        return;
+    }
+
+    ResetNullGLStats();
+    for (auto _ : state)
+    {
+        material->Use();
+    }
+
+    const GLCallStats& stats = GetNullGLStats();
+    const double uses = static_cast<double>(state.Iterations());
+    state.counters["gl_calls"] = stats.calls / uses;
+    state.counters["state_changes"] = stats.stateChanges / uses;
+    state.counters["uniform_updates"] = stats.uniformUpdates / uses;
+    state.SetItemsProcessed(state.Iterations());
+}
+ENGINE_BENCHMARK(BM_Material_Use);
+
+// Sort and replay of draws submitted in the worst order, alternating two materials
+static void BM_RenderQueue_Flush(BenchmarkState& state)
+{
+    const int commandCount = 1024;
+    AssetManager& assets = AssetManager::GetInstance();
+    std::shared_ptr<Material> materials[] = {
+        LoadMaterial(),
+        assets.GetMaterial(assets.GetMaterialAsset("Resources/Assets/Materials/MM_default.json"))
+    };
+    if (!materials[0] || !materials[1])
+    {
+        state.SkipWithError("failed to create the materials");
+        return;
+    }
+
+    RenderQueue queue;
+    RenderQueueStats totals;
+    for (auto _ : state)
+    {
+        for (int i = 0; i < commandCount; ++i)
+        {
+            const Material& material = *materials[i % 2];
+            DrawCommand command;
+            command.sortKey = RenderQueue::MakeSortKey(0, static_cast<uint16_t>(material.GetShader()->GetID()),
+                material.GetTextureSetKey(), static_cast<uint32_t>(commandCount - i));
+            command.material = &material;
+            command.indexCount = 6;
+            queue.Submit(command);
+        }
+        queue.Flush(nullptr);
+
+        const RenderQueueStats& stats = queue.GetLastFlushStats();
+        totals.materialChanges += stats.materialChanges;
+        totals.stateChanges += stats.stateChanges;
+        totals.stateChangesSaved += stats.stateChangesSaved;
+    }
+
+    const double flushes = static_cast<double>(state.Iterations());
+    state.counters["material_changes"] = totals.materialChanges / flushes;
+    state.counters["state_changes"] = totals.stateChanges / flushes;
+    state.counters["state_changes_saved"] = totals.stateChangesSaved / flushes;
+    state.SetItemsProcessed(state.Iterations() * commandCount);
+}
+ENGINE_BENCHMARK(BM_RenderQueue_Flush);
@@ -0,0 +1,149 @@
+#include "Benchmark.h"
+#include "Core/SpriteTransform.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Sprite count large enough to leave the L1 but small enough to stay in the L2/L3, like a real frame
+static const size_t SPRITE_COUNT = 1 << 16;
+static const uint32_t SPRITE_TABLE_SIZE = 64;
+
+struct SpriteColumns
+{
+    std::vector<Position> positions;
+    std::vector<Rotation> rotations;
+    std::vector<Scale> scales;
+    std::vector<SpriteRef> sprites;
+};
+
+static SpriteColumns MakeColumns(size_t count)
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-4000.0f, 4000.0f);
+    std::uniform_real_distribution<float> rotation(-720.0f, 720.0f);
+    std::uniform_real_distribution<float> scale(-256.0f, 256.0f);
+    std::uniform_int_distribution<unsigned int> sprite(0, SPRITE_TABLE_SIZE * 2);
+
+    SpriteColumns columns;
+    for (size_t i = 0; i < count; ++i)
+    {
+        columns.positions.push_back({ position(rng), position(rng) });
+        columns.rotations.push_back({ rotation(rng) });
+        columns.scales.push_back({ scale(rng), scale(rng) });
+        columns.sprites.push_back({ sprite(rng) });
+    }
+    return columns;
+}
+
+// Compares the quad corners produced from the packed instance, as Sprite.vert rebuilds them,
+// with the glm translate/rotate/scale reference used before the compact format
+static bool CheckAgainstReference(const SpriteColumns& columns, const std::vector<InstancedData>& instances, SimdLevel level)
+{
+    const glm::vec2 corners[4] = { { 0.5f, 0.5f }, { 0.5f, -0.5f }, { -0.5f, 0.5f }, { -0.5f, -0.5f } };
+
+    for (size_t i = 0; i < instances.size(); ++i)
+    {
+        const InstancedData& instance = instances[i];
+
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, glm::vec3(columns.positions[i].x, columns.positions[i].y, 0.0f));
+        model = glm::rotate(model, glm::radians(columns.rotations[i].value), glm::vec3(0.0f, 0.0f, 1.0f));
+        model = glm::scale(model, glm::vec3(columns.scales[i].x, columns.scales[i].y, 1.0f));
+
+        glm::vec2 scale = glm::unpackHalf2x16(instance.scale);
+        float c = std::cos(instance.rotation);
+        float s = std::sin(instance.rotation);
+
+        // Half floats keep 11 significant bits
+        float tolerance = 1e-3f * (std::abs(columns.scales[i].x) + std::abs(columns.scales[i].y)) + 1e-2f;
+
+        for (const glm::vec2& corner : corners)
+        {
+            glm::vec4 expected = model * glm::vec4(corner.x, corner.y, 0.0f, 1.0f);
+
+            glm::vec2 scaled = glm::vec2(corner.x * scale.x, corner.y * scale.y);
+            glm::vec2 actual = glm::vec2(c * scaled.x - s * scaled.y, s * scaled.x + c * scaled.y) + instance.position;
+
+            if (std::abs(expected.x - actual.x) > tolerance || std::abs(expected.y - actual.y) > tolerance)
+            {
+                std::cerr << "FAILED: " << GetSimdLevelName(level) << " sprite " << i << " expected (" << expected.x << ", " << expected.y
+                    << ") got (" << actual.x << ", " << actual.y << ")" << std::endl;
+                return false;
+            }
+        }
+
+        unsigned int expectedIndex = columns.sprites[i].spriteID < SPRITE_TABLE_SIZE ? columns.sprites[i].spriteID : 0;
+        if (instance.spriteIndex != expectedIndex || instance.tint != DEFAULT_SPRITE_TINT)
+        {
+            std::cerr << "FAILED: " << GetSimdLevelName(level) << " sprite " << i << " has wrong sprite index or tint" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CheckSpriteTransformKernels()
+{
+    // Odd count so the scalar tail after the 8-wide loop is exercised too
+    SpriteColumns columns = MakeColumns(SPRITE_COUNT + 5);
+    std::vector<InstancedData> instances(columns.positions.size());
+
+    bool success = true;
+    for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2 })
+    {
+        if (level > GetSupportedSimdLevel())
+        {
+            continue;
+        }
+
+        PackSpriteInstancesFunc kernel = GetPackSpriteInstances(level);
+        kernel(columns.positions.data(), columns.rotations.data(), columns.scales.data(), columns.sprites.data(),
+            instances.size(), SPRITE_TABLE_SIZE, DEFAULT_SPRITE_TINT, instances.data());
+
+        success &= CheckAgainstReference(columns, instances, level);
+    }
+    return success;
+}
+
+static void PackSpriteInstancesBenchmark(BenchmarkState& state, SimdLevel level)
+{
+    if (level > GetSupportedSimdLevel())
+    {
+        state.SkipWithMessage(std::string(GetSimdLevelName(level)) + " not supported by this CPU");
+        return;
+    }
+
+    static const SpriteColumns columns = MakeColumns(SPRITE_COUNT);
+    std::vector<InstancedData> instances(columns.positions.size());
+    PackSpriteInstancesFunc kernel = GetPackSpriteInstances(level);
+
+    for (auto _ : state)
+    {
+        kernel(columns.positions.data(), columns.rotations.data(), columns.scales.data(), columns.sprites.data(),
+            instances.size(), SPRITE_TABLE_SIZE, DEFAULT_SPRITE_TINT, instances.data());
+        DoNotOptimize(instances.data());
+    }
+    state.SetItemsProcessed(state.Iterations() * static_cast<int64_t>(instances.size()));
+    state.SetBytesProcessed(state.Iterations() * static_cast<int64_t>(instances.size() * sizeof(InstancedData)));
+}
+
+static void BM_PackSpriteInstances_Scalar(BenchmarkState& state)
+{
+    PackSpriteInstancesBenchmark(state, SimdLevel::Scalar);
+}
+ENGINE_BENCHMARK(BM_PackSpriteInstances_Scalar);
+
+static void BM_PackSpriteInstances_SSE41(BenchmarkState& state)
+{
+    PackSpriteInstancesBenchmark(state, SimdLevel::SSE41);
+}
+ENGINE_BENCHMARK(BM_PackSpriteInstances_SSE41);
+
+static void BM_PackSpriteInstances_AVX2(BenchmarkState& state)
+{
+    PackSpriteInstancesBenchmark(state, SimdLevel::AVX2);
+}
+ENGINE_BENCHMARK(BM_PackSpriteInstances_AVX2);
@@ -1,11 +0,0 @@
-#version 460 core
-out vec4 FragColor;
-
-in vec2 TexCoords;
-
-uniform vec4 uColor;
-
-void main()
-{
-    FragColor = uColor;
-}
\ No newline at end of file
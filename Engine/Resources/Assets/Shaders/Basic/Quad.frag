@@ -0,0 +1,68 @@
+#version 460 core
+// Quad del Renderer: un solo sorgente per tutte le varianti. Feature ("defines" nel JSON del materiale):
+//   TEXTURED  legge texture_diffuse
+//   TINTED    moltiplica per uColor (blocco MaterialParams), senza TEXTURED e' il colore pieno
+//   GLITCH    distorsione e linee di scansione animate, richiede TEXTURED
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+#include "../Common/FrameData.glsl"
+
+#ifdef TINTED
+layout (std140) uniform MaterialParams
+{
+    vec4 uColor;
+};
+#endif
+
+#ifdef TEXTURED
+uniform sampler2D texture_diffuse;
+// Parte di texture_diffuse da usare (offset, dimensione), vedi Texture::GetUVRect
+uniform vec4 texture_diffuseRect;
+
+// Porta le coordinate nel rettangolo della texture. Il clamp fa da GL_CLAMP_TO_EDGE, altrimenti
+// la distorsione leggerebbe le texture vicine nella pagina dell'atlas
+vec2 atlasUV(vec2 uv) {
+    return texture_diffuseRect.xy + clamp(uv, 0.0, 1.0) * texture_diffuseRect.zw;
+}
+#endif
+
+#ifdef GLITCH
+// Funzione di rumore pseudo-casuale
+float random(vec2 st) {
+    return fract(sin(dot(st.xy, vec2(12.9898,78.233))) * 43758.5453123);
+}
+#endif
+
+void main()
+{
+    vec4 color = vec4(1.0);
+
+#ifdef TEXTURED
+    vec2 uv = TexCoords;
+#ifdef GLITCH
+    // Effetto di distorsione casuale
+    float noise = random(vec2(uv.y, time)) * 0.1;
+    uv.x += noise;
+
+    // Linee di scansione
+    float scanline = sin(uv.y * 500.0) * 0.05;
+
+    // Glitch di distorsione
+    float distortion = sin(uv.x * 2.0 + time) * 0.01;
+    uv.y += distortion;
+#endif
+    color = texture(texture_diffuse, atlasUV(uv));
+#ifdef GLITCH
+    // Aggiungi le linee di scansione
+    color -= scanline;
+#endif
+#endif
+
+#ifdef TINTED
+    color *= uColor;
+#endif
+
+    FragColor = color;
+}
\ No newline at end of file
@@ -4,8 +4,9 @@ layout (location = 1) in vec2 aTexCoords;
 
 out vec2 TexCoords;
 
+#include "../Common/FrameData.glsl"
+
 uniform mat4 model;
-uniform mat4 projection;
 
 void main()
 {
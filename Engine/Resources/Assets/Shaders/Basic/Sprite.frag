@@ -0,0 +1,59 @@
+#version 460 core
+#if defined(ENGINE_BINDLESS_TEXTURES) && !defined(SPRITE_FALLBACK)
+#extension GL_ARB_bindless_texture : require
+#endif
+out vec4 FragColor;
+
+in vec4 Tint;
+
+#ifdef SPRITE_FALLBACK
+// Variante di attesa (vedi Sprite.vert): un materiale semplice, fuori dalla tabella
+layout (std140) uniform MaterialParams
+{
+    vec4 uColor;
+};
+
+void main()
+{
+    FragColor = Tint * uColor;
+}
+#else
+in vec2 TexCoords;
+flat in uint MaterialIndex;
+
+// Parametri dei materiali del draw indiretto, una riga per materiale. La texture e' un handle
+// bindless oppure un layer di una delle texture array (vedi TextureReferences.h); il rettangolo
+// e' la parte della texture da usare quando sta in una pagina del TextureAtlas. Il LOD bias
+// arriva dal materiale ("lodBias" nel JSON).
+struct SpriteMaterial
+{
+    vec4 uColor;
+    vec4 texture_diffuseRect;
+    uvec2 texture_diffuseHandle;
+    uint texture_diffuseArray;
+    uint texture_diffuseLayer;
+    float texture_diffuseLodBias;
+};
+
+layout (std140, binding = 2) readonly buffer MaterialTable
+{
+    SpriteMaterial materials[];
+};
+
+#ifndef ENGINE_BINDLESS_TEXTURES
+uniform sampler2DArray textureArrays[8];
+#endif
+
+void main()
+{
+    SpriteMaterial material = materials[MaterialIndex];
+    vec2 uv = material.texture_diffuseRect.xy + TexCoords * material.texture_diffuseRect.zw;
+#ifdef ENGINE_BINDLESS_TEXTURES
+    vec4 texel = texture(sampler2D(material.texture_diffuseHandle), uv, material.texture_diffuseLodBias);
+#else
+    // L'indice dipende solo da gl_DrawID, quindi e' uniforme all'interno del draw
+    vec4 texel = texture(textureArrays[material.texture_diffuseArray], vec3(uv, float(material.texture_diffuseLayer)), material.texture_diffuseLodBias);
+#endif
+    FragColor = texel * Tint * material.uColor;
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,51 @@
+#version 460 core
+// Sprite instanced del RenderingSystem. Con SPRITE_FALLBACK solo posizione e tinta, senza tabella
+// dei materiali: e' la variante disegnata finche' lo shader vero e' in compilazione.
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aTexCoords;
+
+// Dati per istanza (vedi InstancedData in Rendering.h)
+layout (location = 2) in vec2 iPosition;
+layout (location = 3) in vec2 iScale;
+layout (location = 4) in float iRotation;
+layout (location = 5) in uint iSpriteIndex;
+layout (location = 6) in vec4 iTint;
+
+#ifndef SPRITE_FALLBACK
+// Rettangoli UV degli sprite: offset in xy, dimensione in zw
+layout (std430, binding = 0) readonly buffer SpriteRects
+{
+    vec4 spriteRects[];
+};
+
+// Indice nella MaterialTable per ogni draw del glMultiDrawElementsIndirect (vedi Shader.h)
+layout (std430, binding = 3) readonly buffer DrawMaterials
+{
+    uint drawMaterials[];
+};
+
+out vec2 TexCoords;
+flat out uint MaterialIndex;
+#endif
+
+out vec4 Tint;
+
+#include "../Common/FrameData.glsl"
+
+void main()
+{
+    // Ricostruisce scale -> rotate -> translate senza una matrice per istanza
+    vec2 scaled = aPos.xy * iScale;
+    float c = cos(iRotation);
+    float s = sin(iRotation);
+    vec2 worldPos = vec2(c * scaled.x - s * scaled.y, s * scaled.x + c * scaled.y) + iPosition;
+
+    gl_Position = projection * vec4(worldPos, aPos.z, 1.0);
+    Tint = iTint;
+
+#ifndef SPRITE_FALLBACK
+    vec4 rect = spriteRects[iSpriteIndex];
+    TexCoords = rect.xy + aTexCoords * rect.zw;
+    MaterialIndex = drawMaterials[gl_DrawID];
+#endif
+}
\ No newline at end of file
@@ -1,11 +0,0 @@
-#version 460 core
-out vec4 FragColor;
-
-in vec2 TexCoords;
-
-uniform sampler2D texture_diffuse;
-
-void main()
-{
-    FragColor = texture(texture_diffuse, TexCoords);
-}
\ No newline at end of file
@@ -0,0 +1,6 @@
+// Costanti per frame, caricate una volta da Renderer::BeginFrame (vedi FrameData in Renderer.h)
+layout (std140) uniform FrameData
+{
+    mat4 projection;
+    float time;
+};
\ No newline at end of file
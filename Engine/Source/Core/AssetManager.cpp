@@ -1,8 +1,12 @@
 #include "Core/AssetManager.h"
+#include "Core/Profiler.h"
+#include "Core/TextureAtlas.h"
+#include "Core/TextureReferences.h"
+#include "Core/GLStateCache.h"
 #include <iostream>
 #include <stdexcept>
-#include <fstream>
 #include <nlohmann/json.hpp>
+#include <algorithm>
 
 AssetManager& AssetManager::GetInstance()
 {
@@ -12,16 +16,36 @@ AssetManager& AssetManager::GetInstance()
 
 AssetManager::AssetManager()
 {
-    asyncWorker = std::thread(&AssetManager::AsyncWorkerThread, this);
+    // Slot 0 riservato per l'ID non valido
+    materialAssets.push_back(nullptr);
+
+    // Le texture ancora in cache alla chiusura si rilasciano nel distruttore dell'AssetManager e
+    // usano atlas e riferimenti: costruiti prima, questi singleton vengono distrutti dopo
+    TextureAtlas::GetInstance();
+    TextureReferences::GetInstance();
+
+    // Un worker per core, lasciando libero quello del thread principale
+    unsigned int cores = std::thread::hardware_concurrency();
+    unsigned int workerCount = (cores > 1) ? cores - 1 : 1;
+    for (unsigned int i = 0; i < workerCount; ++i)
+    {
+        asyncWorkers.emplace_back(&AssetManager::AsyncWorkerThread, this);
+    }
 }
 
 AssetManager::~AssetManager()
 {
-    stopWorker = true;
-    taskCondition.notify_one();
-    if (asyncWorker.joinable())
     {
-        asyncWorker.join();
+        std::lock_guard<std::mutex> lock(taskMutex);
+        stopWorkers = true;
+    }
+    taskCondition.notify_all();
+    for (std::thread& worker : asyncWorkers)
+    {
+        if (worker.joinable())
+        {
+            worker.join();
+        }
     }
 }
 
@@ -41,43 +65,150 @@ std::shared_ptr<T> AssetManager::FindOrLoad(const std::string& name, const std::
     return asset;
 }
 
-std::shared_ptr<Shader> AssetManager::GetShader(const std::string& name, const std::map<unsigned int, std::string>& shaderPaths)
+std::shared_ptr<Shader> AssetManager::GetShader(const std::string& name, const std::map<unsigned int, std::string>& shaderPaths,
+    const std::vector<std::string>& defines, ShaderCompileMode mode)
 {
-    std::lock_guard<std::mutex> lock(assetsMutex);
-    if (assets.find(name) != assets.end())
+    std::shared_ptr<Shader> shader;
     {
-        return std::static_pointer_cast<Shader>(assets.at(name));
+        std::lock_guard<std::mutex> lock(assetsMutex);
+        auto variant = shaderVariants.find(name);
+        if (variant != shaderVariants.end())
+        {
+            auto it = shaders.find(variant->second.key);
+            if (it != shaders.end())
+            {
+                shader = it->second;
+            }
+        }
     }
 
-    std::shared_ptr<Shader> shader = std::make_shared<Shader>(shaderPaths);
-    assets[name] = shader;
+    if (!shader)
+    {
+        // Lettura dei sorgenti e compilazione fuori dal lock: i worker che caricano texture e
+        // materiali non restano fermi dietro al compilatore del driver
+        std::vector<std::string> files;
+        ShaderSources sources = Shader::LoadSources(shaderPaths, defines, &files);
+        const uint64_t key = Shader::ComputeContentKey(sources);
+        for (std::string& file : files)
+        {
+            file = AssetPack::NormalizePath(file);
+        }
+        {
+            std::lock_guard<std::mutex> lock(assetsMutex);
+            auto it = shaders.find(key);
+            if (it != shaders.end())
+            {
+                // Stesso programma sotto un altro nome (percorsi diversi, define equivalenti)
+                shader = it->second;
+                shaderVariants[name] = { key, shaderPaths, defines, std::move(files) };
+            }
+        }
+
+        if (!shader)
+        {
+            std::shared_ptr<Shader> created = std::make_shared<Shader>(sources, mode);
+
+            std::lock_guard<std::mutex> lock(assetsMutex);
+            auto [it, inserted] = shaders.try_emplace(key, created);
+            shaderVariants[name] = { key, shaderPaths, defines, std::move(files) };
+            shader = it->second;
+        }
+    }
+
+    if (mode == ShaderCompileMode::Blocking)
+    {
+        shader->WaitUntilReady();
+    }
     return shader;
 }
 
-std::shared_ptr<Texture> AssetManager::GetTexture(const std::string& name, const std::string& path, TextureFilter filter)
+std::shared_ptr<Texture> AssetManager::GetTexture(const std::string& name, const std::string& path, TextureFilter filter, TexturePacking packing)
 {
-    return FindOrLoad<Texture>(name, path, filter);
+    return FindOrLoad<Texture>(name, path, filter, TextureLoad::Immediate, packing);
 }
 
-std::shared_ptr<MaterialAsset> AssetManager::GetMaterialAsset(const std::string& path)
+std::shared_ptr<Texture> AssetManager::GetTextureAsync(const std::string& name, const std::string& path, TextureFilter filter, AssetLoadPriority priority,
+    TexturePacking packing)
 {
-    std::lock_guard<std::mutex> lock(assetsMutex);
+    std::shared_ptr<Texture> texture;
+    {
+        std::lock_guard<std::mutex> lock(assetsMutex);
+        auto it = assets.find(name);
+        if (it != assets.end())
+        {
+            return std::static_pointer_cast<Texture>(it->second);
+        }
+
+        // La texture e' registrata subito, cosi' le richieste successive ottengono lo stesso handle
+        texture = std::make_shared<Texture>(path, filter, TextureLoad::Streamed, packing);
+        assets[name] = texture;
+    }
 
-    if (assets.count(path))
+    // Il worker trattiene solo un weak_ptr: una texture rilasciata prima della decodifica non viene caricata
+    std::weak_ptr<Texture> weakTexture = texture;
+    QueueLoad(name, path, [this, weakTexture, path, filter, packing]() -> std::shared_ptr<Asset>
+        {
+            std::shared_ptr<Texture> target = weakTexture.lock();
+            if (!target)
+            {
+                return nullptr;
+            }
+            try
+            {
+                textureUploader.Enqueue(target, DecodeTexture(path, filter, packing));
+            }
+            catch (...)
+            {
+                // Nessun upload arrivera': l'hot reload puo' riempirla subito (vedi ProcessReloads)
+                target->loadFailed = true;
+                throw;
+            }
+            return target;
+        }, priority, nullptr);
+
+    return texture;
+}
+
+TextureImage AssetManager::DecodeTexture(const std::string& path, TextureFilter filter, TexturePacking packing)
+{
+    TextureImage image = Texture::Decode(path);
+
+    // Le mipmap del filtro SMOOTH si calcolano qui, non sul thread OpenGL. Le pagine del
+    // TextureAtlas hanno un solo livello: per le texture piccole non servono.
+    const bool atlased = packing == TexturePacking::Atlas && TextureAtlas::GetInstance().CanHold(image.width, image.height);
+    if (filter == TextureFilter::SMOOTH && !image.IsCompressed() && !atlased)
     {
-        return std::static_pointer_cast<MaterialAsset>(assets.at(path));
+        Texture::GenerateMipmaps(image);
     }
+    return image;
+}
 
-    std::shared_ptr<MaterialAsset> materialAsset;
-    std::ifstream file(path);
-    if (!file.is_open())
+TextureUploader& AssetManager::GetTextureUploader()
+{
+    return textureUploader;
+}
+
+std::shared_ptr<MaterialAsset> AssetManager::GetMaterialAsset(const std::string& path)
+{
     {
-        std::cerr << "ERROR: Failed to open material asset file: " << path << std::endl;
-        return nullptr;
+        std::lock_guard<std::mutex> lock(assetsMutex);
+        auto it = assets.find(path);
+        if (it != assets.end())
+        {
+            return std::static_pointer_cast<MaterialAsset>(it->second);
+        }
     }
 
+    PROFILE_ZONE("AssetManager::GetMaterialAsset (miss)");
+
+    // Lettura e parsing fuori dal lock: il genitore di un'istanza viene caricato con una
+    // chiamata ricorsiva, che con il lock tenuto andrebbe in deadlock
+    std::shared_ptr<MaterialAsset> materialAsset;
     nlohmann::json data;
-    file >> data;
+    if (!MaterialAsset::ReadData(path, data))
+    {
+        return nullptr;
+    }
 
     if (data.contains("parent"))
     {
@@ -85,7 +216,7 @@ std::shared_ptr<MaterialAsset> AssetManager::GetMaterialAsset(const std::string&
         std::shared_ptr<MaterialAsset> parentAsset = GetMaterialAsset(parentPath);
         if (parentAsset)
         {
-            materialAsset = std::make_shared<MaterialInstanceAsset>(path, parentAsset);
+            materialAsset = std::make_shared<MaterialInstanceAsset>(path, data, parentAsset);
         }
         else
         {
@@ -95,33 +226,26 @@ std::shared_ptr<MaterialAsset> AssetManager::GetMaterialAsset(const std::string&
     }
     else
     {
-        materialAsset = std::make_shared<MaterialAsset>(path);
+        materialAsset = std::make_shared<MaterialAsset>(path, data);
     }
 
-    assets[path] = materialAsset;
-    return materialAsset;
+    // Se un altro thread ha caricato lo stesso asset nel frattempo, vince il primo
+    std::lock_guard<std::mutex> lock(assetsMutex);
+    auto [it, inserted] = assets.try_emplace(path, materialAsset);
+    return std::static_pointer_cast<MaterialAsset>(it->second);
 }
 
 std::shared_ptr<Material> AssetManager::CreateMaterialFromAsset(const std::shared_ptr<MaterialAsset>& materialAsset)
 {
+    PROFILE_ZONE("AssetManager::CreateMaterialFromAsset");
+
     if (!materialAsset)
     {
         return nullptr;
     }
 
     // Ottieni lo shader
-    std::map<unsigned int, std::string> shaderPaths;
-    const nlohmann::json& paths = materialAsset->GetShaderPaths();
-    if (paths.contains("vertex"))
-    {
-        shaderPaths[GL_VERTEX_SHADER] = paths.at("vertex");
-    }
-    if (paths.contains("fragment"))
-    {
-        shaderPaths[GL_FRAGMENT_SHADER] = paths.at("fragment");
-    }
-
-    std::shared_ptr<Shader> shader = GetShader(paths.at("vertex"), shaderPaths);
+    std::shared_ptr<Shader> shader = GetMaterialShader(*materialAsset, ShaderCompileMode::Blocking);
     if (!shader)
     {
         return nullptr;
@@ -156,18 +280,197 @@ std::shared_ptr<Material> AssetManager::CreateMaterialFromAsset(const std::share
                 filter = TextureFilter::PIXEL_PERFECT;
             }
 
-            std::shared_ptr<Texture> texture = GetTexture(texturePath, texturePath, filter);
+            // "atlas": false tiene la texture fuori dal TextureAtlas (es. per il wrapping GL_REPEAT)
+            TexturePacking packing = val.value("atlas", true) ? TexturePacking::Atlas : TexturePacking::Standalone;
+
+            // "lodBias" sposta la scelta della mipmap solo per questo materiale (es. -0.5 per sprite piu' nitidi)
+            float lodBias = val.value("lodBias", 0.0f);
+
+            std::shared_ptr<Texture> texture = GetTextureAsync(texturePath, texturePath, filter, AssetLoadPriority::Visible, packing);
             if (texture)
             {
-                material->SetTexture(key, texture);
+                material->SetTexture(key, texture, lodBias);
+            }
+        }
+    }
+    return material;
+}
+
+std::shared_ptr<Shader> AssetManager::GetMaterialShader(const MaterialAsset& materialAsset, ShaderCompileMode mode)
+{
+    std::map<unsigned int, std::string> shaderPaths;
+    const nlohmann::json& paths = materialAsset.GetShaderPaths();
+    if (paths.contains("vertex"))
+    {
+        shaderPaths[GL_VERTEX_SHADER] = paths.at("vertex");
+    }
+    if (paths.contains("fragment"))
+    {
+        shaderPaths[GL_FRAGMENT_SHADER] = paths.at("fragment");
+    }
+
+    return GetShader(GetShaderVariantName(shaderPaths, materialAsset.GetDefines()), shaderPaths, materialAsset.GetDefines(), mode);
+}
+
+std::string AssetManager::GetShaderVariantName(const std::map<unsigned int, std::string>& shaderPaths, const std::vector<std::string>& defines)
+{
+    // Es. "Quad.frag|Quad.vert#TEXTURED#TINTED" (con i percorsi completi, in ordine di tipo)
+    std::string name;
+    for (const auto& [type, path] : shaderPaths)
+    {
+        name += name.empty() ? path : "|" + path;
+    }
+    for (const std::string& define : defines)
+    {
+        name += "#" + define;
+    }
+    return name;
+}
+
+std::shared_ptr<Material> AssetManager::GetFallbackMaterial(const MaterialAsset& materialAsset)
+{
+    const std::string& fallbackPath = materialAsset.GetFallbackPath().empty() ? DEFAULT_FALLBACK_MATERIAL : materialAsset.GetFallbackPath();
+    if (fallbackPath == materialAsset.GetPath())
+    {
+        return nullptr;
+    }
+
+    // Shader piccoli, compilati una volta sola e poi in cache come gli altri materiali.
+    // Siamo nel percorso di ogni frame: se lo shader del fallback non compila si prosegue senza,
+    // e GetMaterial aspetta lo shader vero
+    std::shared_ptr<Material> fallback;
+    try
+    {
+        fallback = GetMaterial(GetMaterialAsset(fallbackPath), ShaderCompileMode::Blocking);
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "ERROR: Fallback material shader failed: " << fallbackPath << " (" << e.what() << ")" << std::endl;
+        return nullptr;
+    }
+    if (!fallback)
+    {
+        std::cerr << "ERROR: Failed to load fallback material: " << fallbackPath << std::endl;
+    }
+    return fallback;
+}
+
+std::shared_ptr<Material> AssetManager::GetMaterial(const std::shared_ptr<MaterialAsset>& materialAsset)
+{
+    return GetMaterial(materialAsset, ShaderCompileMode::Parallel);
+}
+
+std::shared_ptr<Material> AssetManager::GetMaterial(const std::shared_ptr<MaterialAsset>& materialAsset, ShaderCompileMode mode)
+{
+    if (!materialAsset)
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<Shader> pendingShader;
+    std::shared_ptr<Material> fallback;
+    {
+        std::lock_guard<std::mutex> lock(materialsMutex);
+        auto it = materialCache.find(materialAsset.get());
+        // Il confronto sul weak_ptr esclude un indirizzo riutilizzato da un asset diverso
+        if (it != materialCache.end() && it->second.version == materialAsset->GetVersion() && it->second.asset.lock() == materialAsset)
+        {
+            if (!it->second.pendingShader)
+            {
+                return it->second.material;
             }
+            pendingShader = it->second.pendingShader;
+            fallback = it->second.material;
         }
     }
+
+    // Shader inviato al driver ma non ancora linkato: il controllo non blocca, e fino a quando
+    // non e' pronto si disegna con il fallback. Senza fallback si aspetta lo shader.
+    if (mode == ShaderCompileMode::Parallel)
+    {
+        if (!pendingShader)
+        {
+            pendingShader = GetMaterialShader(*materialAsset, ShaderCompileMode::Parallel);
+        }
+        if (!pendingShader->IsReady())
+        {
+            if (!fallback)
+            {
+                fallback = GetFallbackMaterial(*materialAsset);
+            }
+            if (fallback)
+            {
+                std::lock_guard<std::mutex> lock(materialsMutex);
+                materialCache[materialAsset.get()] = { materialAsset, materialAsset->GetVersion(), fallback, pendingShader };
+                return fallback;
+            }
+        }
+    }
+
+    // Cache miss: ricostruisci il Material fuori dal lock, CreateMaterialFromAsset prende assetsMutex
+    std::shared_ptr<Material> material = CreateMaterialFromAsset(materialAsset);
+    if (!material)
+    {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(materialsMutex);
+    materialCache[materialAsset.get()] = { materialAsset, materialAsset->GetVersion(), material, nullptr };
     return material;
 }
 
+unsigned int AssetManager::RegisterMaterial(const std::string& path)
+{
+    {
+        std::lock_guard<std::mutex> lock(materialsMutex);
+        auto it = materialIDs.find(path);
+        if (it != materialIDs.end())
+        {
+            return it->second;
+        }
+    }
+
+    std::shared_ptr<MaterialAsset> materialAsset = GetMaterialAsset(path);
+    if (!GetMaterial(materialAsset))
+    {
+        std::cerr << "ERROR: Failed to register material: " << path << std::endl;
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(materialsMutex);
+    auto [it, inserted] = materialIDs.try_emplace(path, static_cast<unsigned int>(materialAssets.size()));
+    if (inserted)
+    {
+        materialAssets.push_back(materialAsset);
+    }
+    return it->second;
+}
+
+std::shared_ptr<Material> AssetManager::GetMaterial(unsigned int materialID)
+{
+    std::shared_ptr<MaterialAsset> materialAsset;
+    {
+        std::lock_guard<std::mutex> lock(materialsMutex);
+        if (materialID >= materialAssets.size())
+        {
+            return nullptr;
+        }
+        materialAsset = materialAssets[materialID];
+    }
+    return GetMaterial(materialAsset);
+}
+
 void AssetManager::GarbageCollect()
 {
+    {
+        // I Material in cache trattengono shader e texture: rilascia quelli di asset distrutti
+        std::lock_guard<std::mutex> lock(materialsMutex);
+        std::erase_if(materialCache, [](const auto& entry)
+            {
+                return entry.second.asset.expired();
+            });
+    }
+
     std::lock_guard<std::mutex> lock(assetsMutex);
 
     for (auto it = assets.begin(); it != assets.end();)
@@ -182,58 +485,657 @@ void AssetManager::GarbageCollect()
             ++it;
         }
     }
+
+    // Programmi senza materiali, poi i nomi delle varianti rimasti senza programma
+    std::erase_if(shaders, [](const auto& entry)
+        {
+            return entry.second.use_count() == 1;
+        });
+    for (auto it = shaderVariants.begin(); it != shaderVariants.end();)
+    {
+        if (!shaders.contains(it->second.key))
+        {
+            std::cout << "Garbage collecting: " << it->first << std::endl;
+            it = shaderVariants.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+AssetStats AssetManager::GetStats()
+{
+    std::lock_guard<std::mutex> lock(assetsMutex);
+    AssetStats stats;
+    stats.assets = assets.size();
+    stats.shaderPrograms = shaders.size();
+    stats.shaderVariants = shaderVariants.size();
+    // Ricavato dalle due cache invece che contato, cosi' resta corretto dopo la raccolta delle varianti
+    stats.deduplicatedPrograms = (shaderVariants.size() > shaders.size()) ? shaderVariants.size() - shaders.size() : 0;
+    stats.reloads = reloads;
+    return stats;
+}
+
+bool AssetManager::EnableHotReload(const std::string& root)
+{
+    if (!fileWatcher.Start(root))
+    {
+        std::cerr << "ERROR: Failed to enable hot reload of " << root << std::endl;
+        return false;
+    }
+    std::cout << "Hot reload: watching " << root << std::endl;
+
+    std::error_code error;
+    hotReloadSource.clear();
+    if (!std::filesystem::equivalent(root, HOT_RELOAD_DIRECTORY, error))
+    {
+        hotReloadSource = std::filesystem::path(root).lexically_normal();
+    }
+    return true;
 }
 
-void AssetManager::LoadAssetAsync(const std::string& name, const std::string& path, const std::function<std::shared_ptr<Asset>()>& loadFunction)
+void AssetManager::DisableHotReload()
 {
+    fileWatcher.Stop();
+    shaderBuilds.clear();
+
+    std::lock_guard<std::mutex> lock(reloadsMutex);
+    loadedShaderSources.clear();
+    loadedMaterials.clear();
+    textureReloads.clear();
+}
+
+void AssetManager::ProcessReloads()
+{
+    if (!fileWatcher.IsWatching())
+    {
+        return;
+    }
+
+    PROFILE_ZONE("AssetManager::ProcessReloads");
+
+    for (const std::string& path : fileWatcher.TakeChanges())
+    {
+        std::string assetPath = CopyToAssetDirectory(path);
+        if (!assetPath.empty())
+        {
+            QueueReload(assetPath);
+        }
+    }
+
+    std::vector<ShaderSourcesReload> shaderSources;
+    std::vector<MaterialReload> materials;
+    std::vector<TextureReload> textures;
+    {
+        std::lock_guard<std::mutex> lock(reloadsMutex);
+        shaderSources.swap(loadedShaderSources);
+        materials.swap(loadedMaterials);
+
+        // Una texture ancora in streaming riceve i nuovi pixel solo dopo il suo primo upload,
+        // che altrimenti ne sovrascriverebbe lo storage. Se il primo caricamento e' fallito
+        // l'upload non arrivera' mai e lo scambio avviene subito.
+        for (auto it = textureReloads.begin(); it != textureReloads.end();)
+        {
+            std::shared_ptr<Texture> target = it->target.lock();
+            if (!target)
+            {
+                it = textureReloads.erase(it);
+            }
+            else if (it->replacement->IsResident() && (target->IsResident() || target->HasLoadFailed()))
+            {
+                textures.push_back(std::move(*it));
+                it = textureReloads.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    bool released = !textures.empty();
+    for (TextureReload& reload : textures)
+    {
+        std::shared_ptr<Texture> target = reload.target.lock();
+        if (target)
+        {
+            target->TakeContents(*reload.replacement);
+            std::cout << "Reloaded texture: " << target->GetPath() << std::endl;
+        }
+    }
+
+    for (MaterialReload& reload : materials)
+    {
+        ApplyMaterialReload(reload);
+    }
+
+    for (ShaderSourcesReload& reload : shaderSources)
+    {
+        ApplyShaderSources(reload);
+    }
+
+    // I programmi si controllano senza aspettare il driver, quelli non ancora linkati restano
+    // in attesa fino a un frame successivo
+    for (auto it = shaderBuilds.begin(); it != shaderBuilds.end();)
+    {
+        ShaderBuild& build = it->second;
+        if (build.shader->IsReady())
+        {
+            ApplyShaderBuild(it->first, build);
+            released = true;
+            it = shaderBuilds.erase(it);
+        }
+        else if (build.shader->HasFailed())
+        {
+            std::cerr << "ERROR: Shader reload failed, keeping the previous program: " << build.variants.front() << std::endl;
+            it = shaderBuilds.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    if (released)
+    {
+        // Programmi e texture rilasciati: GL puo' riassegnare gli stessi nomi
+        GLStateCache::GetInstance().Invalidate();
+        std::lock_guard<std::mutex> lock(assetsMutex);
+        reloads += textures.size();
+    }
+}
+
+// Porta un file cambiato nella cartella osservata al suo percorso di asset, copiandolo sopra
+// quello sotto HOT_RELOAD_DIRECTORY. Stringa vuota se la copia non riesce.
+std::string AssetManager::CopyToAssetDirectory(const std::string& changedPath)
+{
+    if (hotReloadSource.empty())
+    {
+        return changedPath;
+    }
+
+    std::filesystem::path assetPath = std::filesystem::path(HOT_RELOAD_DIRECTORY) / std::filesystem::path(changedPath).lexically_relative(hotReloadSource);
+    std::error_code error;
+    std::filesystem::create_directories(assetPath.parent_path(), error);
+    if (!std::filesystem::copy_file(changedPath, assetPath, std::filesystem::copy_options::overwrite_existing, error))
+    {
+        std::cerr << "WARNING: Hot reload cannot copy " << changedPath << " to " << assetPath.generic_string() << ": " << error.message() << std::endl;
+        return std::string();
+    }
+    return assetPath.generic_string();
+}
+
+void AssetManager::QueueReload(const std::string& path)
+{
+    const std::string key = AssetPack::NormalizePath(path);
+
+    std::vector<std::pair<std::string, std::shared_ptr<Texture>>> textures;
+    std::vector<std::string> materials;
+    std::vector<std::pair<std::string, ShaderVariant>> variants;
+    {
+        std::lock_guard<std::mutex> lock(assetsMutex);
+        for (const auto& [name, asset] : assets)
+        {
+            if (AssetPack::NormalizePath(asset->GetPath()) != key)
+            {
+                continue;
+            }
+            if (std::shared_ptr<Texture> texture = std::dynamic_pointer_cast<Texture>(asset))
+            {
+                textures.emplace_back(name, texture);
+            }
+            else if (std::dynamic_pointer_cast<MaterialAsset>(asset))
+            {
+                materials.push_back(asset->GetPath());
+            }
+        }
+        // Una variante dipende dai suoi stadi e da tutti i file che includono
+        for (const auto& [name, variant] : shaderVariants)
+        {
+            if (std::find(variant.files.begin(), variant.files.end(), key) != variant.files.end())
+            {
+                variants.emplace_back(name, variant);
+            }
+        }
+    }
+
+    for (const auto& [name, texture] : textures)
+    {
+        QueueTextureReload(name, texture);
+    }
+    for (const std::string& material : materials)
+    {
+        QueueMaterialReload(material);
+    }
+    for (const auto& [name, variant] : variants)
+    {
+        QueueShaderReload(name, variant);
+    }
+}
+
+// Nomi dei task diversi da quelli dei caricamenti normali: due modifiche ravvicinate allo stesso
+// file finiscono nello stesso task finche' e' in coda
+void AssetManager::QueueTextureReload(const std::string& name, const std::shared_ptr<Texture>& texture)
+{
+    std::weak_ptr<Texture> weakTarget = texture;
+    const std::string path = texture->GetPath();
+    const TextureFilter filter = texture->GetFilter();
+    const TexturePacking packing = texture->GetPacking();
+    QueueLoad("HotReload:" + name, path, [this, weakTarget, path, filter, packing]() -> std::shared_ptr<Asset>
+        {
+            if (weakTarget.expired())
+            {
+                return nullptr;
+            }
+            // Una copia in streaming caricata dal TextureUploader nel suo budget: la texture
+            // originale continua a mostrare i vecchi pixel fino allo scambio in ProcessReloads
+            std::shared_ptr<Texture> replacement = std::make_shared<Texture>(path, filter, TextureLoad::Streamed, packing);
+            textureUploader.Enqueue(replacement, DecodeTexture(path, filter, packing));
+
+            std::lock_guard<std::mutex> lock(reloadsMutex);
+            textureReloads.push_back({ weakTarget, replacement });
+            return nullptr;
+        }, AssetLoadPriority::Visible, nullptr);
+}
+
+void AssetManager::QueueMaterialReload(const std::string& path)
+{
+    QueueLoad("HotReload:" + path, path, [this, path]() -> std::shared_ptr<Asset>
+        {
+            MaterialReload reload = { path, nlohmann::json() };
+            if (!MaterialAsset::ReadData(path, reload.data))
+            {
+                return nullptr;
+            }
+            std::lock_guard<std::mutex> lock(reloadsMutex);
+            loadedMaterials.push_back(std::move(reload));
+            return nullptr;
+        }, AssetLoadPriority::Visible, nullptr);
+}
+
+void AssetManager::QueueShaderReload(const std::string& variant, const ShaderVariant& source)
+{
+    QueueLoad("HotReload:" + variant, variant, [this, variant, source]() -> std::shared_ptr<Asset>
+        {
+            ShaderSourcesReload reload;
+            reload.variant = variant;
+            reload.sources = Shader::LoadSources(source.shaderPaths, source.defines, &reload.files);
+            reload.key = Shader::ComputeContentKey(reload.sources);
+            for (std::string& file : reload.files)
+            {
+                file = AssetPack::NormalizePath(file);
+            }
+
+            std::lock_guard<std::mutex> lock(reloadsMutex);
+            loadedShaderSources.push_back(std::move(reload));
+            return nullptr;
+        }, AssetLoadPriority::Visible, nullptr);
+}
+
+void AssetManager::ApplyMaterialReload(MaterialReload& reload)
+{
+    std::shared_ptr<MaterialAsset> materialAsset;
+    std::vector<std::string> instances;
+    {
+        std::lock_guard<std::mutex> lock(assetsMutex);
+        auto it = assets.find(reload.path);
+        if (it != assets.end())
+        {
+            materialAsset = std::dynamic_pointer_cast<MaterialAsset>(it->second);
+        }
+        // Le istanze copiano i valori del genitore quando vengono caricate: si rileggono anche loro
+        const std::string key = AssetPack::NormalizePath(reload.path);
+        for (const auto& [name, asset] : assets)
+        {
+            const MaterialAsset* instance = dynamic_cast<const MaterialAsset*>(asset.get());
+            if (instance && !instance->GetParentPath().empty() && AssetPack::NormalizePath(instance->GetParentPath()) == key)
+            {
+                instances.push_back(asset->GetPath());
+            }
+        }
+    }
+    if (!materialAsset)
+    {
+        return;
+    }
+
+    // Un JSON valido ma con un campo del tipo sbagliato (es. "defines": "TINTED") non deve
+    // fermare il frame: si tiene il materiale di prima
+    try
+    {
+        std::shared_ptr<MaterialAsset> parent;
+        if (reload.data.contains("parent"))
+        {
+            parent = GetMaterialAsset(reload.data.at("parent").get<std::string>());
+        }
+        materialAsset->Reload(reload.data, parent);
+    }
+    catch (const nlohmann::json::exception& e)
+    {
+        std::cerr << "ERROR: Material reload failed, keeping the previous version: " << reload.path << " (" << e.what() << ")" << std::endl;
+        return;
+    }
+    std::cout << "Reloaded material: " << reload.path << std::endl;
+    {
+        std::lock_guard<std::mutex> lock(assetsMutex);
+        reloads++;
+    }
+
+    for (const std::string& instance : instances)
+    {
+        QueueMaterialReload(instance);
+    }
+}
+
+void AssetManager::ApplyShaderSources(ShaderSourcesReload& reload)
+{
+    {
+        std::lock_guard<std::mutex> lock(assetsMutex);
+        auto variant = shaderVariants.find(reload.variant);
+        if (variant == shaderVariants.end())
+        {
+            return;
+        }
+        // Gli include possono essere cambiati con il file
+        variant->second.files = std::move(reload.files);
+        if (variant->second.key == reload.key)
+        {
+            // File salvato senza modifiche che cambino il sorgente finale
+            return;
+        }
+    }
+
+    // Una variante modificata di nuovo prima che il programma precedente fosse pronto segue
+    // solo l'ultima versione
+    for (auto it = shaderBuilds.begin(); it != shaderBuilds.end();)
+    {
+        std::erase(it->second.variants, reload.variant);
+        it = it->second.variants.empty() ? shaderBuilds.erase(it) : std::next(it);
+    }
+
+    ShaderBuild& build = shaderBuilds[reload.key];
+    if (!build.shader)
+    {
+        // Inviato al driver senza aspettarlo, come i materiali registrati (vedi RegisterMaterial)
+        build.shader = std::make_shared<Shader>(reload.sources, ShaderCompileMode::Parallel);
+    }
+    build.variants.push_back(reload.variant);
+}
+
+void AssetManager::ApplyShaderBuild(uint64_t key, ShaderBuild& build)
+{
+    std::vector<std::shared_ptr<Shader>> replaced;
+    {
+        std::lock_guard<std::mutex> lock(assetsMutex);
+
+        // Programmi attuali delle varianti, quelle raccolte nel frattempo sono gia' uscite
+        std::vector<ShaderVariant*> variants;
+        for (const std::string& name : build.variants)
+        {
+            auto variant = shaderVariants.find(name);
+            if (variant == shaderVariants.end())
+            {
+                continue;
+            }
+            variants.push_back(&variant->second);
+            auto current = shaders.find(variant->second.key);
+            if (current != shaders.end() && std::find(replaced.begin(), replaced.end(), current->second) == replaced.end())
+            {
+                replaced.push_back(current->second);
+            }
+        }
+        if (variants.empty())
+        {
+            return;
+        }
+
+        if (!shaders.contains(key))
+        {
+            // Il programma nuovo prende il posto di quello vecchio, cosi' chi tiene lo shader lo
+            // vede subito, solo se nessun'altra variante lo usa: una variante deduplicata che non
+            // dipende dal file cambiato tiene il suo programma
+            const uint64_t oldKey = variants.front()->key;
+            const bool sameProgram = std::all_of(variants.begin(), variants.end(), [oldKey](const ShaderVariant* variant)
+                {
+                    return variant->key == oldKey;
+                });
+            const size_t users = std::count_if(shaderVariants.begin(), shaderVariants.end(), [oldKey](const auto& entry)
+                {
+                    return entry.second.key == oldKey;
+                });
+
+            auto old = shaders.find(oldKey);
+            if (sameProgram && users == variants.size() && old != shaders.end())
+            {
+                std::shared_ptr<Shader> target = old->second;
+                target->TakeProgram(*build.shader);
+                shaders.erase(old);
+                shaders[key] = target;
+            }
+            else
+            {
+                shaders[key] = build.shader;
+            }
+        }
+        // Altrimenti il contenuto e' gia' compilato (es. una modifica annullata): il programma
+        // appena costruito viene scartato
+
+        for (ShaderVariant* variant : variants)
+        {
+            variant->key = key;
+        }
+        reloads++;
+    }
+
+    std::cout << "Reloaded shader: " << build.variants.front() << std::endl;
+    InvalidateMaterials(replaced);
+}
+
+void AssetManager::InvalidateMaterials(const std::vector<std::shared_ptr<Shader>>& replaced)
+{
+    // Il layout del blocco MaterialParams puo' essere cambiato: i Material vanno ricostruiti
+    std::lock_guard<std::mutex> lock(materialsMutex);
+    std::erase_if(materialCache, [&replaced](const auto& entry)
+        {
+            const CachedMaterial& cached = entry.second;
+            return std::find(replaced.begin(), replaced.end(), cached.material->GetShader()) != replaced.end() ||
+                (cached.pendingShader && std::find(replaced.begin(), replaced.end(), cached.pendingShader) != replaced.end());
+        });
+}
+
+bool AssetManager::MountPack(const std::string& path)
+{
+    std::unique_ptr<AssetPack> pack = AssetPack::Open(path);
+    if (!pack)
+    {
+        std::cerr << "ERROR: Failed to mount asset pack: " << path << std::endl;
+        return false;
+    }
+
+    std::cout << "Mounted asset pack: " << path << " (" << pack->GetEntryCount() << " assets)" << std::endl;
+    std::lock_guard<std::mutex> lock(packsMutex);
+    packs.push_back(std::move(pack));
+    return true;
+}
+
+bool AssetManager::FindPackedAsset(const std::string& path, PackedAsset& asset)
+{
+    std::lock_guard<std::mutex> lock(packsMutex);
+    for (auto it = packs.rbegin(); it != packs.rend(); ++it)
+    {
+        if ((*it)->Find(path, asset))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+AssetFuture AssetManager::LoadAssetAsync(const std::string& name, const std::string& path, const std::function<std::shared_ptr<Asset>()>& loadFunction,
+    AssetLoadPriority priority, const AssetLoadCallback& onComplete)
+{
+    {
+        std::lock_guard<std::mutex> lock(assetsMutex);
+        auto it = assets.find(name);
+        if (it != assets.end())
+        {
+            std::promise<std::shared_ptr<Asset>> ready;
+            ready.set_value(it->second);
+            if (onComplete)
+            {
+                onComplete(it->second);
+            }
+            return ready.get_future().share();
+        }
+    }
+
+    return QueueLoad(name, path, loadFunction, priority, onComplete);
+}
+
+AssetFuture AssetManager::QueueLoad(const std::string& name, const std::string& path, const std::function<std::shared_ptr<Asset>()>& loadFunction,
+    AssetLoadPriority priority, const AssetLoadCallback& onComplete)
+{
+    AssetFuture future;
     {
         std::lock_guard<std::mutex> lock(taskMutex);
-        asyncTasks.push_back({ name, path, loadFunction });
+        auto pending = pendingLoads.find(name);
+        if (pending != pendingLoads.end())
+        {
+            PendingLoad& load = pending->second;
+            if (onComplete)
+            {
+                load.callbacks.push_back(onComplete);
+            }
+
+            // Una richiesta piu' urgente sposta il task ancora in coda nella coda giusta
+            if (priority < load.priority)
+            {
+                auto& queue = asyncTasks[static_cast<size_t>(load.priority)];
+                auto queued = std::find_if(queue.begin(), queue.end(), [&name](const AsyncLoadTask& task)
+                    {
+                        return task.name == name;
+                    });
+                if (queued != queue.end())
+                {
+                    asyncTasks[static_cast<size_t>(priority)].push_back(std::move(*queued));
+                    queue.erase(queued);
+                    load.priority = priority;
+                }
+            }
+            return load.future;
+        }
+
+        auto promise = std::make_shared<std::promise<std::shared_ptr<Asset>>>();
+        future = promise->get_future().share();
+
+        PendingLoad& load = pendingLoads[name];
+        load.future = future;
+        load.priority = priority;
+        if (onComplete)
+        {
+            load.callbacks.push_back(onComplete);
+        }
+
+        asyncTasks[static_cast<size_t>(priority)].push_back({ name, path, loadFunction, promise });
         activeTasks++;
     }
     taskCondition.notify_one();
+    return future;
 }
 
 void AssetManager::WaitForAllLoads()
 {
-    while (activeTasks > 0)
-    {
-        std::this_thread::yield();
-    }
+    std::unique_lock<std::mutex> lock(taskMutex);
+    loadsFinishedCondition.wait(lock, [this]()
+        {
+            return activeTasks == 0;
+        });
 }
 
 void AssetManager::AsyncWorkerThread()
 {
-    while (!stopWorker)
+    Profiler::SetThreadName("Asset Worker");
+
+    while (true)
     {
         std::unique_lock<std::mutex> lock(taskMutex);
         taskCondition.wait(lock, [this]()
             {
-                return !asyncTasks.empty() || stopWorker;
+                if (stopWorkers)
+                {
+                    return true;
+                }
+                for (const auto& queue : asyncTasks)
+                {
+                    if (!queue.empty())
+                    {
+                        return true;
+                    }
+                }
+                return false;
             });
 
-        if (stopWorker)
+        if (stopWorkers)
         {
             return;
         }
 
-        AsyncLoadTask task = asyncTasks.front();
-        asyncTasks.erase(asyncTasks.begin());
+        // Preleva il task dalla coda non vuota con la priorita' piu' alta
+        AsyncLoadTask task;
+        for (auto& queue : asyncTasks)
+        {
+            if (!queue.empty())
+            {
+                task = std::move(queue.front());
+                queue.pop_front();
+                break;
+            }
+        }
 
         lock.unlock();
 
+        PROFILE_ZONE("AssetManager::LoadAsync");
+        std::shared_ptr<Asset> loadedAsset;
         try
         {
-            std::shared_ptr<Asset> loadedAsset = task.loadFunction();
-            std::lock_guard<std::mutex> assetLock(assetsMutex);
-            assets[task.name] = loadedAsset;
+            loadedAsset = task.loadFunction();
+            if (loadedAsset)
+            {
+                // Non sovrascrive un asset registrato nel frattempo (es. le texture in streaming)
+                std::lock_guard<std::mutex> assetLock(assetsMutex);
+                assets.try_emplace(task.name, loadedAsset);
+            }
             std::cout << "Successfully loaded asset: " << task.name << std::endl;
+            task.promise->set_value(loadedAsset);
         }
         catch (const std::exception& e)
         {
             std::cerr << "Failed to load async asset: " << task.name << " | Error: " << e.what() << std::endl;
+            task.promise->set_exception(std::current_exception());
         }
 
+        std::vector<AssetLoadCallback> callbacks;
+        lock.lock();
+        auto pending = pendingLoads.find(task.name);
+        if (pending != pendingLoads.end())
+        {
+            callbacks = std::move(pending->second.callbacks);
+            pendingLoads.erase(pending);
+        }
+        lock.unlock();
+
+        for (const AssetLoadCallback& callback : callbacks)
+        {
+            callback(loadedAsset);
+        }
+
+        lock.lock();
         activeTasks--;
+        if (activeTasks == 0)
+        {
+            loadsFinishedCondition.notify_all();
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,299 @@
+#include "Core/AssetPack.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+AssetPack::~AssetPack()
+{
+#ifdef _WIN32
+    if (base)
+    {
+        UnmapViewOfFile(base);
+    }
+    if (mapping)
+    {
+        CloseHandle(mapping);
+    }
+    if (file && file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(file);
+    }
+#else
+    if (base)
+    {
+        munmap(const_cast<unsigned char*>(base), size);
+    }
+#endif
+}
+
+std::unique_ptr<AssetPack> AssetPack::Open(const std::string& path)
+{
+    std::unique_ptr<AssetPack> pack(new AssetPack());
+    pack->path = path;
+
+#ifdef _WIN32
+    pack->file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (pack->file == INVALID_HANDLE_VALUE)
+    {
+        return nullptr;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(pack->file, &fileSize) || fileSize.QuadPart == 0)
+    {
+        return nullptr;
+    }
+    pack->size = static_cast<size_t>(fileSize.QuadPart);
+    pack->mapping = CreateFileMappingA(pack->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!pack->mapping)
+    {
+        return nullptr;
+    }
+    pack->base = static_cast<const unsigned char*>(MapViewOfFile(pack->mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+    {
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(descriptor, &info) != 0 || info.st_size == 0)
+    {
+        close(descriptor);
+        return nullptr;
+    }
+    pack->size = static_cast<size_t>(info.st_size);
+    void* mapped = mmap(nullptr, pack->size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    // The mapping keeps the file alive on its own
+    close(descriptor);
+    if (mapped == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    pack->base = static_cast<const unsigned char*>(mapped);
+#endif
+    if (!pack->base)
+    {
+        return nullptr;
+    }
+
+    if (pack->size < sizeof(PackHeader))
+    {
+        std::cerr << "ERROR: Asset pack is too small: " << path << std::endl;
+        return nullptr;
+    }
+    pack->header = reinterpret_cast<const PackHeader*>(pack->base);
+    const PackHeader& header = *pack->header;
+    if (std::memcmp(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0 || header.version != PACK_VERSION)
+    {
+        std::cerr << "ERROR: Asset pack has an unknown format or version: " << path << std::endl;
+        return nullptr;
+    }
+    if (header.slotCount == 0 || !std::has_single_bit(header.slotCount) ||
+        header.entriesOffset + static_cast<uint64_t>(header.entryCount) * sizeof(PackEntry) > pack->size ||
+        header.slotsOffset + static_cast<uint64_t>(header.slotCount) * sizeof(uint32_t) > pack->size ||
+        header.stringsOffset > pack->size)
+    {
+        std::cerr << "ERROR: Asset pack table of contents is corrupted: " << path << std::endl;
+        return nullptr;
+    }
+
+    pack->entries = reinterpret_cast<const PackEntry*>(pack->base + header.entriesOffset);
+    pack->slots = reinterpret_cast<const uint32_t*>(pack->base + header.slotsOffset);
+    return pack;
+}
+
+bool AssetPack::Find(std::string_view path, PackedAsset& asset) const
+{
+    const std::string key = NormalizePath(path);
+    const uint64_t hash = HashPath(key);
+    const uint32_t mask = header->slotCount - 1;
+
+    for (uint32_t probe = 0; probe < header->slotCount; ++probe)
+    {
+        uint32_t slot = slots[(hash + probe) & mask];
+        if (slot == 0 || slot > header->entryCount)
+        {
+            return false;
+        }
+
+        const PackEntry& entry = entries[slot - 1];
+        if (entry.hash != hash)
+        {
+            continue;
+        }
+        const uint64_t pathStart = header->stringsOffset + entry.pathOffset;
+        if (pathStart + entry.pathLength > size || entry.dataOffset + entry.dataSize > size)
+        {
+            return false;
+        }
+        if (std::string_view(reinterpret_cast<const char*>(base + pathStart), entry.pathLength) != key)
+        {
+            continue;
+        }
+
+        asset.type = entry.type;
+        asset.data = base + entry.dataOffset;
+        asset.size = static_cast<size_t>(entry.dataSize);
+        asset.width = static_cast<int>(entry.width);
+        asset.height = static_cast<int>(entry.height);
+        return true;
+    }
+    return false;
+}
+
+size_t AssetPack::GetEntryCount() const
+{
+    return header->entryCount;
+}
+
+const std::string& AssetPack::GetPath() const
+{
+    return path;
+}
+
+std::string AssetPack::NormalizePath(std::string_view path)
+{
+    std::string normalized;
+    normalized.reserve(path.size());
+    for (char c : path)
+    {
+        c = (c == '\\') ? '/' : c;
+        if (c == '/' && !normalized.empty() && normalized.back() == '/')
+        {
+            continue;
+        }
+        normalized.push_back(c);
+    }
+    while (normalized.starts_with("./"))
+    {
+        normalized.erase(0, 2);
+    }
+    return normalized;
+}
+
+uint64_t AssetPack::HashPath(std::string_view normalizedPath)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : normalizedPath)
+    {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+void AssetPackWriter::Add(const std::string& path, PackEntryType type, std::vector<unsigned char> data, int width, int height)
+{
+    std::string key = AssetPack::NormalizePath(path);
+    for (Item& item : items)
+    {
+        if (item.path == key)
+        {
+            item = { std::move(key), type, std::move(data), width, height };
+            return;
+        }
+    }
+    items.push_back({ std::move(key), type, std::move(data), width, height });
+}
+
+size_t AssetPackWriter::GetEntryCount() const
+{
+    return items.size();
+}
+
+bool AssetPackWriter::Write(const std::string& outputPath) const
+{
+    // Sorted, so the same input always gives the same file
+    std::vector<const Item*> sorted;
+    for (const Item& item : items)
+    {
+        sorted.push_back(&item);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const Item* a, const Item* b) { return a->path < b->path; });
+
+    // Load factor at most 1/2 keeps the probe sequences short
+    PackHeader header = {};
+    std::memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+    header.version = PACK_VERSION;
+    header.entryCount = static_cast<uint32_t>(sorted.size());
+    header.slotCount = std::bit_ceil(std::max<uint32_t>(header.entryCount * 2, 1));
+    header.entriesOffset = sizeof(PackHeader);
+    header.slotsOffset = header.entriesOffset + sorted.size() * sizeof(PackEntry);
+    header.stringsOffset = header.slotsOffset + header.slotCount * sizeof(uint32_t);
+
+    std::vector<PackEntry> entries(sorted.size());
+    std::vector<uint32_t> slots(header.slotCount, 0);
+    std::string strings;
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+        PackEntry& entry = entries[i];
+        entry = {};
+        entry.hash = AssetPack::HashPath(sorted[i]->path);
+        entry.pathOffset = static_cast<uint32_t>(strings.size());
+        entry.pathLength = static_cast<uint32_t>(sorted[i]->path.size());
+        entry.type = sorted[i]->type;
+        entry.width = static_cast<uint32_t>(sorted[i]->width);
+        entry.height = static_cast<uint32_t>(sorted[i]->height);
+        entry.dataSize = sorted[i]->data.size();
+        strings += sorted[i]->path;
+
+        uint32_t slot = static_cast<uint32_t>(entry.hash & (header.slotCount - 1));
+        while (slots[slot] != 0)
+        {
+            slot = (slot + 1) & (header.slotCount - 1);
+        }
+        slots[slot] = static_cast<uint32_t>(i + 1);
+    }
+
+    uint64_t dataOffset = AlignUp(header.stringsOffset + strings.size(), PACK_DATA_ALIGNMENT);
+    for (PackEntry& entry : entries)
+    {
+        entry.dataOffset = dataOffset;
+        dataOffset = AlignUp(dataOffset + entry.dataSize, PACK_DATA_ALIGNMENT);
+    }
+
+    std::ofstream file(outputPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cerr << "ERROR: Failed to open asset pack for writing: " << outputPath << std::endl;
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(PackEntry)));
+    file.write(reinterpret_cast<const char*>(slots.data()), static_cast<std::streamsize>(slots.size() * sizeof(uint32_t)));
+    file.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+
+    static const char padding[PACK_DATA_ALIGNMENT] = {};
+    uint64_t written = header.stringsOffset + strings.size();
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+        file.write(padding, static_cast<std::streamsize>(entries[i].dataOffset - written));
+        file.write(reinterpret_cast<const char*>(sorted[i]->data.data()), static_cast<std::streamsize>(sorted[i]->data.size()));
+        written = entries[i].dataOffset + entries[i].dataSize;
+    }
+
+    if (!file)
+    {
+        std::cerr << "ERROR: Failed to write asset pack: " << outputPath << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -1,38 +1,239 @@
 #include "Core/Assets/Material.h"
+#include "Core/Profiler.h"
+#include "Core/GLStateCache.h"
+#include "Core/TextureReferences.h"
+#include "Core/SamplerCache.h"
 #include <glad/gl.h>
 #include <iostream>
+#include <cstring>
 
 Material::Material(const std::shared_ptr<Shader>& shader) : shader(shader)
 {
+    if (shader && shader->GetMaterialBlockLayout().size > 0)
+    {
+        blockData.resize(shader->GetMaterialBlockLayout().size, 0);
+
+        // Gli shader a tabella leggono i parametri dalla MaterialTable del frame, non da un UBO
+        if (!shader->UsesMaterialTable())
+        {
+            glCreateBuffers(1, &blockUBO);
+            glNamedBufferData(blockUBO, blockData.size(), blockData.data(), GL_DYNAMIC_DRAW);
+        }
+    }
+}
+
+Material::~Material()
+{
+    if (blockUBO != 0)
+    {
+        glDeleteBuffers(1, &blockUBO);
+    }
+}
+
+const std::shared_ptr<Shader>& Material::GetShader() const
+{
+    return shader;
+}
+
+// Offset di un membro della riga della tabella con il tipo atteso, -1 se manca
+static GLint FindTableMember(const UniformBlockLayout& layout, const std::string& name, GLenum type)
+{
+    auto it = layout.members.find(name);
+    return (it != layout.members.end() && it->second.type == type) ? it->second.offset : -1;
+}
+
+const std::vector<unsigned char>& Material::GetTableRow() const
+{
+    // I riferimenti cambiano quando una texture in streaming diventa residente
+    tableRow = blockData;
+    for (const TextureBinding& binding : textures)
+    {
+        if (binding.rectOffset >= 0)
+        {
+            // Cambia quando la texture diventa residente o il TextureAtlas ricompatta le pagine
+            glm::vec4 rect = binding.texture->GetUVRect();
+            std::memcpy(tableRow.data() + binding.rectOffset, glm::value_ptr(rect), sizeof(glm::vec4));
+        }
+        if (binding.handleOffset < 0 && binding.arrayOffset < 0 && binding.layerOffset < 0)
+        {
+            continue;
+        }
+
+        TextureReference reference = binding.texture->GetReference();
+        if (binding.handleOffset >= 0)
+        {
+            // uvec2: 32 bit bassi nella x
+            uint32_t handle[2] = { static_cast<uint32_t>(reference.handle), static_cast<uint32_t>(reference.handle >> 32) };
+            std::memcpy(tableRow.data() + binding.handleOffset, handle, sizeof(handle));
+        }
+        if (binding.arrayOffset >= 0)
+        {
+            std::memcpy(tableRow.data() + binding.arrayOffset, &reference.array, sizeof(uint32_t));
+        }
+        if (binding.layerOffset >= 0)
+        {
+            std::memcpy(tableRow.data() + binding.layerOffset, &reference.layer, sizeof(uint32_t));
+        }
+    }
+    return tableRow;
+}
+
+bool Material::WriteBlockMember(const std::string& uniformName, GLenum type, const void* data, size_t size)
+{
+    if (blockData.empty())
+    {
+        return false;
+    }
+
+    const UniformBlockLayout& layout = shader->GetMaterialBlockLayout();
+    auto it = layout.members.find(uniformName);
+    if (it == layout.members.end())
+    {
+        return false;
+    }
+    if (it->second.type != type)
+    {
+        std::cerr << "WARNING: Material parameter '" << uniformName << "' does not match its type in " << MATERIAL_PARAMS_BLOCK << std::endl;
+        return true;
+    }
+
+    // Segna il blocco da ricaricare solo se il valore cambia davvero
+    unsigned char* destination = blockData.data() + it->second.offset;
+    if (std::memcmp(destination, data, size) != 0)
+    {
+        std::memcpy(destination, data, size);
+        blockDirty = true;
+    }
+    return true;
+}
+
+void Material::WriteParameter(const std::string& uniformName, ParameterType type, const float* data, unsigned int floatCount)
+{
+    UniformHandle handle = shader->GetUniformHandle(uniformName);
+    if (!handle.IsValid())
+    {
+        return;
+    }
+
+    for (const Parameter& parameter : parameters)
+    {
+        if (parameter.handle.location == handle.location)
+        {
+            // Lo slot e' dimensionato sul tipo della prima scrittura
+            if (parameter.type != type)
+            {
+                std::cerr << "WARNING: Material parameter '" << uniformName << "' does not match the type it was first set with" << std::endl;
+                return;
+            }
+            std::memcpy(parameterData.data() + parameter.offset, data, floatCount * sizeof(float));
+            return;
+        }
+    }
+
+    parameters.push_back({ handle, type, static_cast<unsigned int>(parameterData.size()) });
+    parameterData.insert(parameterData.end(), data, data + floatCount);
 }
 
-void Material::SetTexture(const std::string& uniformName, const std::shared_ptr<Texture>& texture)
+void Material::SetTexture(const std::string& uniformName, const std::shared_ptr<Texture>& texture, float lodBias)
 {
-    textures[uniformName] = texture;
+    // Shader a riferimenti: nessun sampler uniform, la texture viene scritta nella riga della tabella
+    if (shader->UsesTextureReferences())
+    {
+        WriteBlockMember(uniformName + "LodBias", GL_FLOAT, &lodBias, sizeof(float));
+
+        const UniformBlockLayout& layout = shader->GetMaterialBlockLayout();
+        TextureBinding reference;
+        reference.texture = texture;
+        reference.name = uniformName;
+        reference.handleOffset = FindTableMember(layout, uniformName + "Handle", GL_UNSIGNED_INT_VEC2);
+        reference.arrayOffset = FindTableMember(layout, uniformName + "Array", GL_UNSIGNED_INT);
+        reference.layerOffset = FindTableMember(layout, uniformName + "Layer", GL_UNSIGNED_INT);
+        reference.rectOffset = FindTableMember(layout, uniformName + "Rect", GL_FLOAT_VEC4);
+        if (reference.handleOffset < 0 && reference.arrayOffset < 0 && reference.layerOffset < 0)
+        {
+            return;
+        }
+
+        for (TextureBinding& binding : textures)
+        {
+            if (binding.name == uniformName)
+            {
+                binding.texture = texture;
+                return;
+            }
+        }
+        textures.push_back(reference);
+        return;
+    }
+
+    UniformHandle handle = shader->GetUniformHandle(uniformName);
+    if (!handle.IsValid())
+    {
+        return;
+    }
+
+    const GLuint sampler = SamplerCache::GetInstance().Get(texture->GetFilter(), lodBias);
+    for (TextureBinding& binding : textures)
+    {
+        if (binding.handle.location == handle.location)
+        {
+            binding.texture = texture;
+            binding.sampler = sampler;
+            return;
+        }
+    }
+    TextureBinding binding;
+    binding.handle = handle;
+    binding.texture = texture;
+    binding.sampler = sampler;
+    binding.name = uniformName;
+    if (shader->UsesMaterialTable())
+    {
+        binding.rectOffset = FindTableMember(shader->GetMaterialBlockLayout(), uniformName + "Rect", GL_FLOAT_VEC4);
+    }
+    else
+    {
+        binding.rectHandle = shader->GetUniformHandle(uniformName + "Rect");
+    }
+    textures.push_back(binding);
 }
 
 void Material::SetFloat(const std::string& uniformName, float value)
 {
-    floatUniforms[uniformName] = value;
+    if (!WriteBlockMember(uniformName, GL_FLOAT, &value, sizeof(float)))
+    {
+        WriteParameter(uniformName, ParameterType::Float, &value, 1);
+    }
 }
 
 void Material::SetVec3(const std::string& uniformName, const glm::vec3& value)
 {
-    vec3Uniforms[uniformName] = value;
+    if (!WriteBlockMember(uniformName, GL_FLOAT_VEC3, glm::value_ptr(value), sizeof(glm::vec3)))
+    {
+        WriteParameter(uniformName, ParameterType::Vec3, glm::value_ptr(value), 3);
+    }
 }
 
 void Material::SetVec4(const std::string& uniformName, const glm::vec4& value)
 {
-    vec4Uniforms[uniformName] = value;
+    if (!WriteBlockMember(uniformName, GL_FLOAT_VEC4, glm::value_ptr(value), sizeof(glm::vec4)))
+    {
+        WriteParameter(uniformName, ParameterType::Vec4, glm::value_ptr(value), 4);
+    }
 }
 
 void Material::SetMat4(const std::string& uniformName, const glm::mat4& value)
 {
-    mat4Uniforms[uniformName] = value;
+    if (!WriteBlockMember(uniformName, GL_FLOAT_MAT4, glm::value_ptr(value), sizeof(glm::mat4)))
+    {
+        WriteParameter(uniformName, ParameterType::Mat4, glm::value_ptr(value), 16);
+    }
 }
 
 void Material::Use() const
 {
+    PROFILE_ZONE("Material::Use");
+
     if (!shader)
     {
         std::cerr << "ERROR: Material does not have a valid shader." << std::endl;
@@ -42,44 +243,87 @@ void Material::Use() const
     // Attiva lo shader
     shader->Use();
 
-    //glEnableVertexAttribArray(0);
-    //glEnableVertexAttribArray(1);
-
-    /*if (shader->GetUniformLocation("texture_diffuse") != -1)
+    // Parametri nel blocco std140: upload solo se sono cambiati dall'ultimo Use()
+    if (blockUBO != 0)
     {
-        glEnableVertexAttribArray(1);
+        if (blockDirty)
+        {
+            glNamedBufferSubData(blockUBO, 0, blockData.size(), blockData.data());
+            blockDirty = false;
+        }
+        glBindBufferBase(GL_UNIFORM_BUFFER, MATERIAL_PARAMS_BINDING, blockUBO);
     }
-    else
-    {
-        glDisableVertexAttribArray(1);
-    }*/
 
-
-    // Imposta le texture
+    // Imposta le texture: il bind viene saltato se l'unita' ha gia' la stessa texture.
+    // Gli shader a riferimenti leggono le texture dalla tabella, non servono unita'.
     int textureUnit = 0;
-    for (const auto& pair : textures)
+    for (const TextureBinding& binding : textures)
     {
-        glActiveTexture(GL_TEXTURE0 + textureUnit);
-        glBindTexture(GL_TEXTURE_2D, pair.second->GetID());
-        shader->SetInt(pair.first, textureUnit);
+        if (!binding.handle.IsValid())
+        {
+            continue;
+        }
+        GLStateCache::GetInstance().BindTextureUnit(textureUnit, binding.texture->GetID());
+        GLStateCache::GetInstance().BindSampler(textureUnit, binding.sampler);
+        glUniform1i(binding.handle.location, textureUnit);
+        if (binding.rectHandle.IsValid())
+        {
+            glUniform4fv(binding.rectHandle.location, 1, glm::value_ptr(binding.texture->GetUVRect()));
+        }
         textureUnit++;
     }
 
-    // Imposta tutti gli altri uniforms
-    for (const auto& pair : floatUniforms)
+    // Imposta gli uniform che non fanno parte del blocco
+    for (const Parameter& parameter : parameters)
+    {
+        const float* data = parameterData.data() + parameter.offset;
+        switch (parameter.type)
+        {
+        case ParameterType::Float:
+            glUniform1fv(parameter.handle.location, 1, data);
+            break;
+        case ParameterType::Vec3:
+            glUniform3fv(parameter.handle.location, 1, data);
+            break;
+        case ParameterType::Vec4:
+            glUniform4fv(parameter.handle.location, 1, data);
+            break;
+        case ParameterType::Mat4:
+            glUniformMatrix4fv(parameter.handle.location, 1, GL_FALSE, data);
+            break;
+        }
+    }
+}
+
+uint16_t Material::GetTextureSetKey() const
+{
+    // FNV-1a sugli ID: i materiali con le stesse texture hanno la stessa chiave. L'ID cambia
+    // quando una texture in streaming diventa residente, quindi la chiave va letta a ogni frame.
+    uint32_t hash = 2166136261u;
+    for (const TextureBinding& binding : textures)
     {
-        shader->SetFloat(pair.first, pair.second);
+        hash = (hash ^ binding.texture->GetID()) * 16777619u;
+        hash = (hash ^ binding.sampler) * 16777619u;
     }
-    for (const auto& pair : vec3Uniforms)
+    return static_cast<uint16_t>(hash ^ (hash >> 16));
+}
+
+bool Material::SharesTexturesWith(const Material& other) const
+{
+    if (shader->UsesTextureReferences() && other.shader->UsesTextureReferences())
     {
-        shader->SetVec3(pair.first, pair.second);
+        return true;
     }
-    for (const auto& pair : vec4Uniforms)
+    if (textures.size() != other.textures.size())
     {
-        shader->SetVec4(pair.first, pair.second);
+        return false;
     }
-    for (const auto& pair : mat4Uniforms)
+    for (size_t i = 0; i < textures.size(); ++i)
     {
-        shader->SetMat4(pair.first, pair.second);
+        if (textures[i].texture->GetID() != other.textures[i].texture->GetID() || textures[i].sampler != other.textures[i].sampler)
+        {
+            return false;
+        }
     }
-}
\ No newline at end of file
+    return true;
+}
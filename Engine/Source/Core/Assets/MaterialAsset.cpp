@@ -1,21 +1,69 @@
 #include "Core/Assets/MaterialAsset.h"
+#include "Core/AssetManager.h"
 #include <fstream>
 #include <iostream>
+#include <algorithm>
 
 MaterialAsset::MaterialAsset(const std::string& path)
 {
     this->path = path;
+    nlohmann::json data;
+    if (!ReadData(path, data))
+    {
+        return;
+    }
+
+    LoadShaderPathsFromJson(data);
+    LoadUniformsFromJson(data);
+}
+
+MaterialAsset::MaterialAsset(const std::string& path, const nlohmann::json& data)
+{
+    this->path = path;
+    LoadShaderPathsFromJson(data);
+    LoadUniformsFromJson(data);
+}
+
+bool MaterialAsset::ReadData(const std::string& path, nlohmann::json& data)
+{
+    // Nel pack il materiale e' gia' in MessagePack: niente apertura di file e parsing del testo
+    PackedAsset packed;
+    if (AssetManager::GetInstance().FindPackedAsset(path, packed) && packed.type == PackEntryType::Material)
+    {
+        data = nlohmann::json::from_msgpack(packed.data, packed.data + packed.size, true, false);
+        if (!data.is_discarded())
+        {
+            return true;
+        }
+        std::cerr << "WARNING: Corrupted material in asset pack, reading the file instead: " << path << std::endl;
+    }
+
     std::ifstream file(path);
     if (!file.is_open())
     {
         std::cerr << "ERROR: Failed to open material asset file: " << path << std::endl;
-        return;
+        return false;
     }
-    nlohmann::json data;
     file >> data;
+    return true;
+}
 
-    LoadShaderPathsFromJson(data);
-    LoadUniformsFromJson(data);
+void MaterialAsset::Reload(const nlohmann::json& data, const std::shared_ptr<MaterialAsset>& parent)
+{
+    MaterialAsset loaded(path, data);
+    TakeContents(loaded);
+}
+
+// Il nuovo contenuto e' letto per intero in 'loaded': se il JSON ha un tipo sbagliato l'eccezione
+// arriva prima di toccare questo asset, che resta com'era
+void MaterialAsset::TakeContents(MaterialAsset& loaded)
+{
+    shaderPaths = std::move(loaded.shaderPaths);
+    defines = std::move(loaded.defines);
+    fallbackPath = std::move(loaded.fallbackPath);
+    parentPath = std::move(loaded.parentPath);
+    uniforms = std::move(loaded.uniforms);
+    version++;
 }
 
 void MaterialAsset::LoadShaderPathsFromJson(const nlohmann::json& data)
@@ -24,6 +72,28 @@ void MaterialAsset::LoadShaderPathsFromJson(const nlohmann::json& data)
     {
         shaderPaths = data.at("shader_paths");
     }
+    // Feature accese nei sorgenti comuni, es. "defines": [ "TEXTURED", "TINTED" ]
+    if (data.contains("defines"))
+    {
+        defines = data.at("defines").get<std::vector<std::string>>();
+        SortDefines();
+    }
+    // Il fallback sostituisce gli shader, quindi deve avere lo stesso formato dei vertici
+    if (data.contains("fallback"))
+    {
+        fallbackPath = data.at("fallback").get<std::string>();
+    }
+    if (data.contains("parent"))
+    {
+        parentPath = data.at("parent").get<std::string>();
+    }
+}
+
+// Lo stesso insieme scritto in ordine diverso deve dare la stessa variante
+void MaterialAsset::SortDefines()
+{
+    std::sort(defines.begin(), defines.end());
+    defines.erase(std::unique(defines.begin(), defines.end()), defines.end());
 }
 
 void MaterialAsset::LoadUniformsFromJson(const nlohmann::json& data)
@@ -34,8 +104,36 @@ void MaterialAsset::LoadUniformsFromJson(const nlohmann::json& data)
     }
 }
 
+// Dati dell'istanza, vuoti se il file non si puo' leggere: resta valido quanto ereditato
+static nlohmann::json ReadInstanceData(const std::string& path)
+{
+    nlohmann::json data;
+    if (!MaterialAsset::ReadData(path, data))
+    {
+        data = nlohmann::json::object();
+    }
+    return data;
+}
+
 // Implementazione di MaterialInstanceAsset
-MaterialInstanceAsset::MaterialInstanceAsset(const std::string& path, const std::shared_ptr<MaterialAsset>& parent) : MaterialAsset(path)
+MaterialInstanceAsset::MaterialInstanceAsset(const std::string& path, const std::shared_ptr<MaterialAsset>& parent)
+    : MaterialInstanceAsset(path, ReadInstanceData(path), parent)
+{
+}
+
+MaterialInstanceAsset::MaterialInstanceAsset(const std::string& path, const nlohmann::json& data, const std::shared_ptr<MaterialAsset>& parent)
+    : MaterialAsset(path, data)
+{
+    InheritFrom(data, parent);
+}
+
+void MaterialInstanceAsset::Reload(const nlohmann::json& data, const std::shared_ptr<MaterialAsset>& parent)
+{
+    MaterialInstanceAsset loaded(path, data, parent);
+    TakeContents(loaded);
+}
+
+void MaterialInstanceAsset::InheritFrom(const nlohmann::json& data, const std::shared_ptr<MaterialAsset>& parent)
 {
     if (!parent)
     {
@@ -46,18 +144,22 @@ MaterialInstanceAsset::MaterialInstanceAsset(const std::string& path, const std:
     shaderPaths = parent->GetShaderPaths();
     uniforms = parent->GetUniforms();
 
+    // Un fallback indicato dall'istanza prevale su quello del genitore
+    if (!data.contains("fallback"))
+    {
+        fallbackPath = parent->GetFallbackPath();
+    }
+
+    // I define dell'istanza si aggiungono a quelli del genitore
+    defines.insert(defines.end(), parent->GetDefines().begin(), parent->GetDefines().end());
+    SortDefines();
+
     // Sovrascrivi i parametri con quelli specifici dell'istanza
-    std::ifstream file(path);
-    if (file.is_open())
+    if (data.contains("uniforms"))
     {
-        nlohmann::json data;
-        file >> data;
-        if (data.contains("uniforms"))
+        for (auto const& [key, val] : data.at("uniforms").items())
         {
-            for (auto const& [key, val] : data.at("uniforms").items())
-            {
-                uniforms[key] = val;
-            }
+            uniforms[key] = val;
         }
     }
 }
\ No newline at end of file
@@ -1,76 +1,258 @@
 #include "Core/Assets/Shader.h"
+#include "Core/Profiler.h"
+#include "Core/GLStateCache.h"
+#include "Core/TextureReferences.h"
+#include "Core/AssetManager.h"
+#include "Core/ProgramBinaryCache.h"
+#include "Core/Hash.h"
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <string_view>
 
-Shader::Shader(const std::map<unsigned int, std::string>& shaderPaths)
+// GL_KHR_parallel_shader_compile entry point, not generated by glad. The ARB version has the
+// same signature.
+typedef void (GLAD_API_PTR *PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+// Lets the driver pick how many compiler threads to use
+static const GLuint DRIVER_COMPILER_THREADS = 0xFFFFFFFF;
+
+std::vector<std::string> Shader::globalDefines;
+bool Shader::parallelCompile = false;
+
+static bool HasExtension(const char* name)
 {
-    std::vector<unsigned int> attachedShaders;
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        if (extension && std::strcmp(extension, name) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
 
-    // Load and complile a shader
-    for (const auto& pair : shaderPaths)
+static const char* GetStageName(GLenum type)
+{
+    return (type == GL_VERTEX_SHADER) ? "VERTEX" : (type == GL_FRAGMENT_SHADER) ? "FRAGMENT" : (type == GL_GEOMETRY_SHADER) ? "GEOMETRY" : "UNKNOWN";
+}
+
+Shader::Shader(const std::map<unsigned int, std::string>& shaderPaths, const std::vector<std::string>& defines, ShaderCompileMode mode)
+    : Shader(LoadSources(shaderPaths, defines), mode)
+{
+}
+
+Shader::Shader(const ShaderSources& sources, ShaderCompileMode mode)
+{
+    PROFILE_ZONE("Shader::Compile");
+
+    contentKey = ComputeContentKey(sources);
+    ProgramBinaryCache& binaryCache = ProgramBinaryCache::GetInstance();
+    id = glCreateProgram();
+    if (binaryCache.Load(binaryCache.ComputeKey(contentKey), id))
+    {
+        QueryProgramInterface();
+        ready = true;
+        return;
+    }
+
+    if (binaryCache.IsEnabled())
+    {
+        // A rejected binary leaves the program in a failed link state: start from a fresh one
+        glDeleteProgram(id);
+        id = glCreateProgram();
+        glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    SubmitStages(sources);
+    if (mode == ShaderCompileMode::Blocking)
     {
-        unsigned int type = pair.first;
-        const std::string& path = pair.second;
+        WaitUntilReady();
+    }
+}
 
+Shader::~Shader()
+{
+    ReleaseStages();
+    glDeleteProgram(id);
+}
+
+ShaderSources Shader::LoadSources(const std::map<unsigned int, std::string>& shaderPaths, const std::vector<std::string>& defines,
+    std::vector<std::string>* files)
+{
+    PROFILE_ZONE("Shader::LoadSources");
+
+    ShaderSources sources;
+    for (const auto& [type, path] : shaderPaths)
+    {
         try
         {
-            std::string source = LoadShaderSource(path);
-            unsigned int shaderID = CompileShader(type, source);
-            attachedShaders.push_back(shaderID);
+            std::vector<std::string> included = { path };
+            sources.emplace_back(type, ApplyDefines(ResolveIncludes(LoadShaderSource(path), path, 0, included), defines));
+            if (files)
+            {
+                files->insert(files->end(), included.begin(), included.end());
+            }
         }
         catch (const std::exception& e)
         {
             std::cerr << "ERROR::SHADER_LOADING_FAILED: " << e.what() << std::endl;
-            // Clean already compiled shaders in case of error
-            for (unsigned int shaderID : attachedShaders)
-            {
-                glDeleteShader(shaderID);
-            }
-            throw; // throw and exception
+            throw;
         }
     }
+    return sources;
+}
 
-    // Build and link the shader program
-    id = glCreateProgram();
-    for (unsigned int shaderID : attachedShaders)
+// Each stage is chained through the seed, so the type and the boundaries between sources are part
+// of the key
+uint64_t Shader::ComputeContentKey(const ShaderSources& sources)
+{
+    uint64_t key = 0;
+    for (const auto& [type, source] : sources)
     {
-        glAttachShader(id, shaderID);
+        key = Hash64(source, key + type);
     }
-    glLinkProgram(id);
+    return key;
+}
 
-    // Check linking errors
-    try
+uint64_t Shader::GetContentKey() const
+{
+    return contentKey;
+}
+
+bool Shader::IsReady()
+{
+    if (ready || failed)
     {
-        CheckErrors(id, "PROGRAM");
+        return ready;
     }
-    catch (const std::exception& e)
+
+    if (parallelCompile)
     {
-        std::cerr << "ERROR::SHADER_LINKING_FAILED: " << e.what() << std::endl;
-        // Clean the shaders in case of linking error
-        for (unsigned int shaderID : attachedShaders)
+        GLint completed = GL_FALSE;
+        glGetProgramiv(id, COMPLETION_STATUS_KHR, &completed);
+        if (!completed)
         {
-            glDeleteShader(shaderID);
+            return false;
         }
-        glDeleteProgram(id);
-        throw;
     }
 
-    // Delete the single shaders after the linking process. They're not necessary anymore.
-    for (unsigned int shaderID : attachedShaders)
+    try
     {
-        glDeleteShader(shaderID);
+        FinishBuild();
+    }
+    catch (const std::exception&)
+    {
+        // Already reported by FinishBuild
+        return false;
     }
+    return true;
 }
 
-Shader::~Shader()
+void Shader::WaitUntilReady()
 {
-    glDeleteProgram(id);
+    if (ready)
+    {
+        return;
+    }
+    if (failed)
+    {
+        throw std::runtime_error("Shader build failed.");
+    }
+    FinishBuild();
+}
+
+bool Shader::HasFailed() const
+{
+    return failed;
+}
+
+void Shader::InitializeParallelCompile(GLADloadfunc load)
+{
+    parallelCompile = false;
+    PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxShaderCompilerThreads = nullptr;
+    if (load && HasExtension("GL_KHR_parallel_shader_compile"))
+    {
+        maxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(load("glMaxShaderCompilerThreadsKHR"));
+    }
+    else if (load && HasExtension("GL_ARB_parallel_shader_compile"))
+    {
+        maxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(load("glMaxShaderCompilerThreadsARB"));
+    }
+
+    if (maxShaderCompilerThreads)
+    {
+        maxShaderCompilerThreads(DRIVER_COMPILER_THREADS);
+        parallelCompile = true;
+    }
+    std::cout << "Parallel shader compile: " << (parallelCompile ? "enabled" : "not supported") << std::endl;
+}
+
+bool Shader::IsParallelCompileSupported()
+{
+    return parallelCompile;
+}
+
+void Shader::TakeProgram(Shader& source)
+{
+    std::swap(id, source.id);
+    std::swap(contentKey, source.contentKey);
+    std::swap(materialBlockLayout, source.materialBlockLayout);
+    std::swap(usesMaterialTable, source.usesMaterialTable);
+    std::swap(usesTextureReferences, source.usesTextureReferences);
+    std::swap(modelHandle, source.modelHandle);
+    std::swap(ready, source.ready);
+    std::swap(failed, source.failed);
+    // Locations belong to the program they were queried from
+    uniformCache.clear();
+    source.uniformCache.clear();
+    version++;
+}
+
+// Program state every user of the shader relies on: block bindings, material layout, fixed
+// texture units and the model handle
+void Shader::QueryProgramInterface()
+{
+    // The shared uniform blocks live at fixed binding points, shaders don't need a binding qualifier
+    BindUniformBlock(FRAME_DATA_BLOCK, FRAME_DATA_BINDING);
+    BindUniformBlock(MATERIAL_PARAMS_BLOCK, MATERIAL_PARAMS_BINDING);
+    materialBlockLayout = QueryUniformBlockLayout(MATERIAL_PARAMS_BLOCK);
+    if (materialBlockLayout.size == 0)
+    {
+        materialBlockLayout = QueryMaterialTableLayout();
+        usesMaterialTable = materialBlockLayout.size > 0;
+    }
+    for (const auto& [name, member] : materialBlockLayout.members)
+    {
+        if (usesMaterialTable && (name.ends_with("Handle") || name.ends_with("Layer")))
+        {
+            usesTextureReferences = true;
+        }
+    }
+
+    // Texture array fallback: the arrays live at fixed units, set once per program
+    GLint arraysLocation = glGetUniformLocation(id, (std::string(TEXTURE_ARRAYS_UNIFORM) + "[0]").c_str());
+    if (arraysLocation != -1)
+    {
+        GLint units[MAX_TEXTURE_ARRAYS];
+        for (unsigned int i = 0; i < MAX_TEXTURE_ARRAYS; ++i)
+        {
+            units[i] = static_cast<GLint>(TEXTURE_ARRAY_FIRST_UNIT + i);
+        }
+        glProgramUniform1iv(id, arraysLocation, MAX_TEXTURE_ARRAYS, units);
+    }
+    // Optional uniform, resolved directly to skip the missing uniform warning
+    modelHandle = { glGetUniformLocation(id, "model") };
 }
 
 void Shader::Use() const
 {
-    glUseProgram(id);
+    GLStateCache::GetInstance().UseProgram(id);
 }
 
 unsigned int Shader::GetID() const
@@ -115,12 +297,48 @@ void Shader::SetMat4(const std::string& name, const glm::mat4& mat) const
     glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(mat));
 }
 
+void Shader::SetInt(UniformHandle handle, int value) const
+{
+    glUniform1i(handle.location, value);
+}
+
+void Shader::SetFloat(UniformHandle handle, float value) const
+{
+    glUniform1f(handle.location, value);
+}
+
+void Shader::SetVec3(UniformHandle handle, const glm::vec3& value) const
+{
+    glUniform3fv(handle.location, 1, glm::value_ptr(value));
+}
+
+void Shader::SetVec4(UniformHandle handle, const glm::vec4& value) const
+{
+    glUniform4fv(handle.location, 1, glm::value_ptr(value));
+}
+
+void Shader::SetMat4(UniformHandle handle, const glm::mat4& mat) const
+{
+    glUniformMatrix4fv(handle.location, 1, GL_FALSE, glm::value_ptr(mat));
+}
+
+UniformHandle Shader::GetUniformHandle(const std::string& name) const
+{
+    return { GetUniformLocation(name) };
+}
+
+UniformHandle Shader::GetModelHandle() const
+{
+    return modelHandle;
+}
+
 // Caching of the uniforms for performance optimization
 GLint Shader::GetUniformLocation(const std::string& name) const
 {
-    if (uniformCache.count(name))
+    auto it = uniformCache.find(name);
+    if (it != uniformCache.end())
     {
-        return uniformCache.at(name);
+        return it->second;
     }
 
     GLint location = glGetUniformLocation(id, name.c_str());
@@ -135,9 +353,269 @@ GLint Shader::GetUniformLocation(const std::string& name) const
     return location;
 }
 
+const UniformBlockLayout& Shader::GetMaterialBlockLayout() const
+{
+    return materialBlockLayout;
+}
+
+bool Shader::UsesMaterialTable() const
+{
+    return usesMaterialTable;
+}
+
+bool Shader::UsesTextureReferences() const
+{
+    return usesTextureReferences;
+}
+
+void Shader::AddGlobalDefine(const std::string& name)
+{
+    globalDefines.push_back(name);
+}
+
+// Reads size and member offsets of a uniform block through program introspection
+UniformBlockLayout Shader::QueryUniformBlockLayout(const std::string& blockName) const
+{
+    UniformBlockLayout layout;
+
+    GLuint blockIndex = glGetProgramResourceIndex(id, GL_UNIFORM_BLOCK, blockName.c_str());
+    if (blockIndex == GL_INVALID_INDEX)
+    {
+        return layout;
+    }
+
+    const GLenum blockProperties[] = { GL_BUFFER_DATA_SIZE, GL_NUM_ACTIVE_VARIABLES };
+    GLint blockValues[2] = { 0, 0 };
+    glGetProgramResourceiv(id, GL_UNIFORM_BLOCK, blockIndex, 2, blockProperties, 2, nullptr, blockValues);
+    layout.size = blockValues[0];
+
+    std::vector<GLint> memberIndices(blockValues[1]);
+    const GLenum activeVariables = GL_ACTIVE_VARIABLES;
+    glGetProgramResourceiv(id, GL_UNIFORM_BLOCK, blockIndex, 1, &activeVariables, blockValues[1], nullptr, memberIndices.data());
+
+    const GLenum memberProperties[] = { GL_OFFSET, GL_TYPE, GL_NAME_LENGTH };
+    for (GLint memberIndex : memberIndices)
+    {
+        GLint memberValues[3] = { 0, 0, 0 };
+        glGetProgramResourceiv(id, GL_UNIFORM, memberIndex, 3, memberProperties, 3, nullptr, memberValues);
+
+        std::string name(memberValues[2], '\0');
+        glGetProgramResourceName(id, GL_UNIFORM, memberIndex, memberValues[2], nullptr, name.data());
+        name.resize(memberValues[2] - 1); // GL_NAME_LENGTH counts the null terminator
+
+        layout.members[name] = { memberValues[0], static_cast<GLenum>(memberValues[1]) };
+    }
+    return layout;
+}
+
+// Reads the entry layout of the MaterialTable storage block. Members of the array are reported
+// as "materials[0].name" with their offset inside the first entry.
+UniformBlockLayout Shader::QueryMaterialTableLayout() const
+{
+    UniformBlockLayout layout;
+
+    GLuint blockIndex = glGetProgramResourceIndex(id, GL_SHADER_STORAGE_BLOCK, MATERIAL_TABLE_BLOCK);
+    if (blockIndex == GL_INVALID_INDEX)
+    {
+        return layout;
+    }
+
+    GLint memberCount = 0;
+    const GLenum activeVariableCount = GL_NUM_ACTIVE_VARIABLES;
+    glGetProgramResourceiv(id, GL_SHADER_STORAGE_BLOCK, blockIndex, 1, &activeVariableCount, 1, nullptr, &memberCount);
+
+    std::vector<GLint> memberIndices(memberCount);
+    const GLenum activeVariables = GL_ACTIVE_VARIABLES;
+    glGetProgramResourceiv(id, GL_SHADER_STORAGE_BLOCK, blockIndex, 1, &activeVariables, memberCount, nullptr, memberIndices.data());
+
+    const GLenum memberProperties[] = { GL_OFFSET, GL_TYPE, GL_NAME_LENGTH, GL_TOP_LEVEL_ARRAY_STRIDE };
+    for (GLint memberIndex : memberIndices)
+    {
+        GLint memberValues[4] = { 0, 0, 0, 0 };
+        glGetProgramResourceiv(id, GL_BUFFER_VARIABLE, memberIndex, 4, memberProperties, 4, nullptr, memberValues);
+
+        std::string name(memberValues[2], '\0');
+        glGetProgramResourceName(id, GL_BUFFER_VARIABLE, memberIndex, memberValues[2], nullptr, name.data());
+        name.resize(memberValues[2] - 1);
+
+        size_t separator = name.find("].");
+        if (separator == std::string::npos)
+        {
+            continue;
+        }
+        layout.members[name.substr(separator + 2)] = { memberValues[0], static_cast<GLenum>(memberValues[1]) };
+        layout.size = memberValues[3];
+    }
+    return layout;
+}
+
+void Shader::BindUniformBlock(const std::string& blockName, unsigned int binding) const
+{
+    GLuint blockIndex = glGetUniformBlockIndex(id, blockName.c_str());
+    if (blockIndex != GL_INVALID_INDEX)
+    {
+        glUniformBlockBinding(id, blockIndex, binding);
+    }
+}
+
+// Compiles the stages and links them into 'id' without asking for any status, so nothing waits
+// for the driver here. Errors are checked by FinishBuild.
+void Shader::SubmitStages(const ShaderSources& sources)
+{
+    for (const auto& [type, source] : sources)
+    {
+        pendingStages.emplace_back(type, CompileShader(type, source));
+    }
+    for (const auto& [type, shaderID] : pendingStages)
+    {
+        glAttachShader(id, shaderID);
+    }
+    glLinkProgram(id);
+}
+
+// Checks the link (waiting for the driver if it is still working), then stores the binary and
+// queries the program interface. On error the program is released and the build marked failed.
+void Shader::FinishBuild()
+{
+    PROFILE_ZONE("Shader::FinishBuild");
+
+    try
+    {
+        GLint linked = GL_FALSE;
+        glGetProgramiv(id, GL_LINK_STATUS, &linked);
+        if (!linked)
+        {
+            // A stage that does not compile makes the link fail: report the compiler log first
+            for (const auto& [type, shaderID] : pendingStages)
+            {
+                CheckErrors(shaderID, GetStageName(type));
+            }
+        }
+        CheckErrors(id, "PROGRAM");
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "ERROR::SHADER_BUILD_FAILED: " << e.what() << std::endl;
+        ReleaseStages();
+        glDeleteProgram(id);
+        id = 0;
+        failed = true;
+        throw;
+    }
+
+    // The single shaders are not necessary anymore after the linking process
+    ReleaseStages();
+    ProgramBinaryCache& binaryCache = ProgramBinaryCache::GetInstance();
+    binaryCache.Store(binaryCache.ComputeKey(contentKey), id);
+    QueryProgramInterface();
+    ready = true;
+}
+
+void Shader::ReleaseStages()
+{
+    for (const auto& [type, shaderID] : pendingStages)
+    {
+        glDeleteShader(shaderID);
+    }
+    pendingStages.clear();
+}
+
+// Expands the lines starting with #include "file", the path being relative to the including file.
+// Each file is included once per stage, later #include lines of the same file are dropped, so
+// included files need no guards. Inclusion ignores #if blocks: an #include inside a disabled
+// block still counts as the first one.
+// #line keeps the compiler messages on the lines of each file; the source string number in the
+// messages is the index of the file in 'included', 0 being the stage itself.
+std::string Shader::ResolveIncludes(const std::string& source, const std::string& path, int sourceIndex, std::vector<std::string>& included)
+{
+    std::string result;
+    result.reserve(source.size());
+
+    size_t lineStart = 0;
+    int lineNumber = 1;
+    while (lineStart < source.size())
+    {
+        size_t lineEnd = source.find('\n', lineStart);
+        lineEnd = (lineEnd == std::string::npos) ? source.size() : lineEnd + 1;
+        std::string_view line(source.data() + lineStart, lineEnd - lineStart);
+
+        size_t directive = line.find_first_not_of(" \t");
+        if (directive == std::string_view::npos || !line.substr(directive).starts_with("#include"))
+        {
+            result += line;
+        }
+        else
+        {
+            size_t nameStart = line.find('"', directive);
+            size_t nameEnd = (nameStart == std::string_view::npos) ? nameStart : line.find('"', nameStart + 1);
+            if (nameEnd == std::string_view::npos)
+            {
+                throw std::runtime_error("Malformed #include at line " + std::to_string(lineNumber) + " of " + path);
+            }
+
+            std::string includePath = (std::filesystem::path(path).parent_path() / std::string(line.substr(nameStart + 1, nameEnd - nameStart - 1)))
+                .lexically_normal().generic_string();
+            if (std::find(included.begin(), included.end(), includePath) == included.end())
+            {
+                int includeIndex = static_cast<int>(included.size());
+                included.push_back(includePath);
+                std::string body = ResolveIncludes(LoadShaderSource(includePath), includePath, includeIndex, included);
+                if (!body.empty() && body.back() != '\n')
+                {
+                    body += '\n';
+                }
+                result += "#line 1 " + std::to_string(includeIndex) + "\n" + body;
+                result += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(sourceIndex) + "\n";
+            }
+            else
+            {
+                // Keeps the line count of the file
+                result += '\n';
+            }
+        }
+
+        lineStart = lineEnd;
+        lineNumber++;
+    }
+    return result;
+}
+
+// Global defines first, then those of the permutation. They go right after #version, which must
+// stay the first directive. #line keeps the compiler messages on the line numbers of the file.
+std::string Shader::ApplyDefines(std::string source, const std::vector<std::string>& defines)
+{
+    if (globalDefines.empty() && defines.empty())
+    {
+        return source;
+    }
+    size_t versionEnd = source.find('\n', source.find("#version"));
+    if (versionEnd != std::string::npos)
+    {
+        std::string directives;
+        for (const std::string& define : globalDefines)
+        {
+            directives += "#define " + define + "\n";
+        }
+        for (const std::string& define : defines)
+        {
+            directives += "#define " + define + "\n";
+        }
+        size_t versionLine = std::count(source.begin(), source.begin() + versionEnd, '\n') + 1;
+        directives += "#line " + std::to_string(versionLine + 1) + "\n";
+        source.insert(versionEnd + 1, directives);
+    }
+    return source;
+}
+
 // Load a shader from source file
-std::string Shader::LoadShaderSource(const std::string& path) const
+std::string Shader::LoadShaderSource(const std::string& path)
 {
+    PackedAsset packed;
+    if (AssetManager::GetInstance().FindPackedAsset(path, packed) && packed.type == PackEntryType::ShaderSource)
+    {
+        return std::string(reinterpret_cast<const char*>(packed.data), packed.size);
+    }
+
     std::ifstream file;
     file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
     try
@@ -154,14 +632,13 @@ std::string Shader::LoadShaderSource(const std::string& path) const
     }
 }
 
-// Compile a shader
+// Compile a shader. The compile status is checked with the link, see FinishBuild.
 unsigned int Shader::CompileShader(unsigned int type, const std::string& source) const
 {
     unsigned int shaderID = glCreateShader(type);
     const char* src = source.c_str();
     glShaderSource(shaderID, 1, &src, nullptr);
     glCompileShader(shaderID);
-    CheckErrors(shaderID, (type == GL_VERTEX_SHADER) ? "VERTEX" : (type == GL_FRAGMENT_SHADER) ? "FRAGMENT" : (type == GL_GEOMETRY_SHADER) ? "GEOMETRY" : "UNKNOWN");
     return shaderID;
 }
 
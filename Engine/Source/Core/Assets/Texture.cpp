@@ -1,70 +1,333 @@
 #include "Core/Assets/Texture.h"
+#include "Core/Profiler.h"
+#include "Core/TextureReferences.h"
+#include "Core/TextureAtlas.h"
+#include "Core/TextureCompression.h"
+#include "Core/SamplerCache.h"
+#include "Core/AssetManager.h"
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
+#include <bit>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
-Texture::Texture(const std::string& path, TextureFilter filter)
+static unsigned int placeholderID = 0;
+
+Texture::Texture(const std::string& path, TextureFilter filter, TextureLoad load, TexturePacking packing) : filter(filter), packing(packing)
 {
-    int width, height, nrChannels;
+    this->path = path;
+
+    if (load == TextureLoad::Streamed)
+    {
+        return;
+    }
 
-    // Configura stb_image per capovolgere l'immagine sull'asse Y
-    stbi_set_flip_vertically_on_load(true);
+    TextureImage image;
+    try
+    {
+        image = Decode(path);
+    }
+    catch (const std::exception&)
+    {
+        std::cerr << "ERROR::TEXTURE::FAILED_TO_LOAD_IMAGE at path: " << path << std::endl;
+        throw;
+    }
 
-    // Carica i dati dell'immagine
-    unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
+    if (image.IsCompressed())
+    {
+        UploadCompressed(image);
+        return;
+    }
 
-    if (data)
+    if (packing == TexturePacking::Atlas && TextureAtlas::GetInstance().Insert(*this, image))
     {
-        // Genera la texture OpenGL
-        glGenTextures(1, &id);
-        glBindTexture(GL_TEXTURE_2D, id);
+        return;
+    }
+
+    // Invia i dati dell'immagine alla GPU
+    CreateStorage(image.width, image.height);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glTextureSubImage2D(id, 0, 0, 0, image.width, image.height, GL_RGBA, GL_UNSIGNED_BYTE, image.Data());
+    FinishUpload();
+}
+
+Texture::~Texture()
+{
+    ReleaseStorage();
+}
+
+void Texture::ReleaseStorage()
+{
+    if (atlased)
+    {
+        // La pagina resta al TextureAtlas, si libera solo il rettangolo
+        TextureAtlas::GetInstance().Remove(*this);
+    }
+    else if (id != 0)
+    {
+        TextureReferences::GetInstance().Release(id);
+        glDeleteTextures(1, &id);
+    }
+}
+
+void Texture::TakeContents(Texture& source)
+{
+    ReleaseStorage();
+
+    id = source.id;
+    width = source.width;
+    height = source.height;
+    levels = source.levels;
+    internalFormat = source.internalFormat;
+    resident = source.resident;
+    atlased = source.atlased;
+    atlasRect = source.atlasRect;
+    uvRect = source.uvRect;
+    if (atlased)
+    {
+        // Il rettangolo nella pagina passa a questa texture
+        TextureAtlas::GetInstance().Transfer(source, *this);
+    }
 
-        // Imposta i parametri di wrapping
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    source.id = 0;
+    source.resident = false;
+    source.atlased = false;
+    loadFailed = false;
+    version++;
+}
+
+unsigned int Texture::GetID() const
+{
+    return resident ? id : GetPlaceholderID();
+}
+
+bool Texture::IsResident() const
+{
+    return resident;
+}
 
-        // --- LOGICA DEL FILTRO AGGIUNTA ---
-        if (filter == TextureFilter::PIXEL_PERFECT)
+bool Texture::HasLoadFailed() const
+{
+    return loadFailed;
+}
+
+TextureFilter Texture::GetFilter() const
+{
+    return filter;
+}
+
+TexturePacking Texture::GetPacking() const
+{
+    return packing;
+}
+
+bool Texture::IsAtlased() const
+{
+    return atlased;
+}
+
+glm::vec4 Texture::GetUVRect() const
+{
+    return resident ? uvRect : glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+}
+
+TextureReference Texture::GetReference() const
+{
+    if (!resident)
+    {
+        return TextureReferences::GetInstance().Resolve(GetPlaceholderID(), 2, 2, 1, TextureFilter::PIXEL_PERFECT);
+    }
+    if (atlased)
+    {
+        // Il riferimento e' quello dell'intera pagina, il rettangolo arriva da GetUVRect
+        return TextureReferences::GetInstance().Resolve(id, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE, 1, filter);
+    }
+    return TextureReferences::GetInstance().Resolve(id, width, height, levels, filter, internalFormat);
+}
+
+TextureImage Texture::Decode(const std::string& path)
+{
+    PROFILE_ZONE("Texture::Decode");
+
+    // Nel pack la texture e' gia' decodificata: i pixel si leggono direttamente dalla mappatura
+    PackedAsset packed;
+    if (AssetManager::GetInstance().FindPackedAsset(path, packed) && packed.type == PackEntryType::Texture &&
+        packed.size == static_cast<size_t>(packed.width) * packed.height * 4)
+    {
+        TextureImage image;
+        image.width = packed.width;
+        image.height = packed.height;
+        image.mapped = packed.data;
+        return image;
+    }
+    if (packed.data && packed.type == PackEntryType::CompressedTexture)
+    {
+        TextureImage image;
+        if (!TextureCompression::Read(packed.data, packed.size, image))
         {
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            throw std::runtime_error("Corrupted compressed texture in asset pack: " + path);
         }
-        else
-        { // TextureFilter::SMOOTH
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        }
-        // ------------------------------------
+        // Senza S3TC nel driver i blocchi si decodificano qui, sul worker
+        return TextureCompression::IsSupported() ? image : TextureCompression::Decompress(image);
+    }
+
+    int width, height, nrChannels;
 
-        // Determina il formato dell'immagine
-        GLenum format = GL_RGB;
-        if (nrChannels == 4)
+    // Configura stb_image per capovolgere l'immagine sull'asse Y. L'impostazione e' per thread,
+    // i worker possono decodificare in parallelo.
+    stbi_set_flip_vertically_on_load_thread(true);
+
+    // Carica sempre 4 canali: righe allineate a 4 byte e un solo formato da caricare
+    unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 4);
+    if (!data)
+    {
+        throw std::runtime_error("Failed to load texture file: " + path);
+    }
+
+    TextureImage image;
+    image.width = width;
+    image.height = height;
+    image.pixels.assign(data, data + static_cast<size_t>(width) * height * 4);
+
+    // Libera la memoria della CPU
+    stbi_image_free(data);
+    return image;
+}
+
+// Filtro box 2x2 da un livello al successivo. Sulle dimensioni dispari l'ultima riga o colonna
+// non ha una coppia e viene ignorata, come in glGenerateMipmap.
+static void Downsample(const unsigned char* source, int width, int height, unsigned char* destination)
+{
+    const int halfWidth = std::max(width / 2, 1);
+    const int halfHeight = std::max(height / 2, 1);
+    for (int y = 0; y < halfHeight; ++y)
+    {
+        const unsigned char* row0 = source + static_cast<size_t>(std::min(y * 2, height - 1)) * width * 4;
+        const unsigned char* row1 = source + static_cast<size_t>(std::min(y * 2 + 1, height - 1)) * width * 4;
+        for (int x = 0; x < halfWidth; ++x)
         {
-            format = GL_RGBA;
+            const int x0 = std::min(x * 2, width - 1) * 4;
+            const int x1 = std::min(x * 2 + 1, width - 1) * 4;
+            for (int c = 0; c < 4; ++c)
+            {
+                int sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+                *destination++ = static_cast<unsigned char>((sum + 2) / 4);
+            }
         }
+    }
+}
+
+void Texture::GenerateMipmaps(TextureImage& image)
+{
+    PROFILE_ZONE("Texture::GenerateMipmaps");
 
-        // Invia i dati dell'immagine alla GPU
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        //glGenerateMipmap(GL_TEXTURE_2D);
+    if (!image.levels.empty() || image.width <= 0 || image.height <= 0)
+    {
+        return;
     }
-    else
+
+    // I pixel mappati da un AssetPack sono in sola lettura: la catena va in una copia
+    if (image.mapped)
     {
-        std::cerr << "ERROR::TEXTURE::FAILED_TO_LOAD_IMAGE at path: " << path << std::endl;
-        throw std::runtime_error("Failed to load texture file.");
+        image.pixels.assign(image.mapped, image.mapped + image.GetSize());
+        image.mapped = nullptr;
     }
 
-    // Libera la memoria della CPU
-    stbi_image_free(data);
+    // Stesso numero di livelli di CreateStorage
+    const int levelCount = std::bit_width(static_cast<unsigned int>(std::max(image.width, image.height)));
+    size_t offset = 0;
+    for (int level = 0; level < levelCount; ++level)
+    {
+        size_t size = static_cast<size_t>(std::max(image.width >> level, 1)) * std::max(image.height >> level, 1) * 4;
+        image.levels.push_back({ offset, size });
+        offset += size;
+    }
+    image.pixels.resize(offset);
+
+    for (int level = 1; level < levelCount; ++level)
+    {
+        Downsample(image.pixels.data() + image.levels[level - 1].offset, std::max(image.width >> (level - 1), 1),
+            std::max(image.height >> (level - 1), 1), image.pixels.data() + image.levels[level].offset);
+    }
 }
 
-Texture::~Texture()
+unsigned int Texture::GetPlaceholderID()
 {
-    glDeleteTextures(1, &id);
+    if (placeholderID == 0)
+    {
+        // Scacchiera magenta/nero, ben visibile se una texture resta bloccata
+        const unsigned char pixels[] = {
+            255, 0, 255, 255,   0, 0, 0, 255,
+            0, 0, 0, 255,       255, 0, 255, 255
+        };
+
+        glCreateTextures(GL_TEXTURE_2D, 1, &placeholderID);
+        glTextureStorage2D(placeholderID, 1, GL_RGBA8, 2, 2);
+        glTextureParameteri(placeholderID, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTextureParameteri(placeholderID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTextureParameteri(placeholderID, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(placeholderID, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glTextureSubImage2D(placeholderID, 0, 0, 0, 2, 2, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    }
+    return placeholderID;
 }
 
-unsigned int Texture::GetID() const
+void Texture::DestroyPlaceholder()
+{
+    if (placeholderID != 0)
+    {
+        TextureReferences::GetInstance().Release(placeholderID);
+        glDeleteTextures(1, &placeholderID);
+        placeholderID = 0;
+    }
+}
+
+void Texture::CreateStorage(int width, int height, GLenum internalFormat, GLsizei levelCount)
+{
+    this->width = width;
+    this->height = height;
+    this->internalFormat = internalFormat;
+
+    // Con il filtro SMOOTH il minification filter usa le mipmap: senza una catena completa
+    // la texture sarebbe incompleta
+    levels = 1;
+    if (filter == TextureFilter::SMOOTH)
+    {
+        levels = levelCount > 0 ? levelCount : static_cast<GLsizei>(std::bit_width(static_cast<unsigned int>(std::max(width, height))));
+    }
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &id);
+    glTextureStorage2D(id, levels, internalFormat, width, height);
+
+    // Wrapping, filtri e anisotropia, gli stessi dei sampler dei materiali
+    SamplerCache::GetInstance().ApplyParameters(id, filter);
+}
+
+void Texture::FinishUpload(bool generateMipmaps)
 {
-    return id;
-}
\ No newline at end of file
+    if (filter == TextureFilter::SMOOTH && generateMipmaps)
+    {
+        glGenerateTextureMipmap(id);
+    }
+    resident = true;
+}
+
+void Texture::UploadCompressed(const TextureImage& image)
+{
+    PROFILE_ZONE("Texture::UploadCompressed");
+
+    // PIXEL_PERFECT non campiona le mipmap: basta il livello 0
+    CreateStorage(image.width, image.height, image.compressedFormat, static_cast<GLsizei>(image.levels.size()));
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    for (GLsizei level = 0; level < levels; ++level)
+    {
+        const TextureLevel& data = image.levels[level];
+        glCompressedTextureSubImage2D(id, level, 0, 0, std::max(image.width >> level, 1), std::max(image.height >> level, 1),
+            image.compressedFormat, static_cast<GLsizei>(data.size), image.Data() + data.offset);
+    }
+    resident = true;
+}
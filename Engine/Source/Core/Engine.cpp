@@ -1,7 +1,17 @@
 #include "Core/Engine.h"
 #include <iostream>
 #include <sstream>
+#include <iomanip>
+#include <filesystem>
 #include "Core/AssetManager.h"
+#include "Core/Rendering.h"
+#include "Core/NullGL.h"
+#include "Core/Profiler.h"
+#include "Core/TextureReferences.h"
+#include "Core/TextureAtlas.h"
+#include "Core/TextureCompression.h"
+#include "Core/SamplerCache.h"
+#include "Core/ProgramBinaryCache.h"
 
 //// Hint per NVIDIA: forza l'uso della GPU dedicata
 //extern "C" {
@@ -17,6 +27,9 @@ const float VIRTUAL_WIDTH = 1280.0f;
 const float VIRTUAL_HEIGHT = 720.0f;
 const float VIRTUAL_ASPECT_RATIO = VIRTUAL_WIDTH / VIRTUAL_HEIGHT;
 
+// Passo fisso del tempo in modalita' headless (60 Hz)
+const double HEADLESS_FRAME_TIME = 1.0 / 60.0;
+
 // Funzione statica per il callback del ridimensionamento della finestra
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
@@ -44,60 +57,133 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
     glViewport(xOffset, yOffset, newWidth, newHeight);
 }
 
-// Dichiarazione del sistema di rendering per Flecs
-//void RenderingSystem(flecs::iter& it, Position* p, Rotation* r, Scale* s, SpriteRef* spr, MaterialRef* mat);
-
-Engine::Engine(int width, int height, const char* title)
+// F12 salva la traccia del profiler degli ultimi frame
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
-    // 1. Inizializza GLFW (gestione della finestra)
-    if (!glfwInit())
+    if (key == GLFW_KEY_F12 && action == GLFW_PRESS)
     {
-        throw std::runtime_error("Failed to initialize GLFW");
+        Engine* engine = static_cast<Engine*>(glfwGetWindowUserPointer(window));
+        engine->RequestProfilerCapture();
     }
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+}
 
-    // 2. Crea la finestra e rendi il contesto OpenGL attuale
-    window = glfwCreateWindow(width, height, title, NULL, NULL);
-    if (!window)
+Engine::Engine(int width, int height, const char* title, EngineMode mode) : mode(mode), width(width), height(height)
+{
+    if (mode == EngineMode::Headless)
     {
-        glfwTerminate();
-        throw std::runtime_error("Failed to create GLFW window");
+        // Nessuna finestra: le funzioni GL puntano al backend nullo
+        if (!LoadNullGL())
+        {
+            throw std::runtime_error("Failed to initialize the null GL backend");
+        }
+    }
+    else
+    {
+        // 1. Inizializza GLFW (gestione della finestra)
+        if (!glfwInit())
+        {
+            throw std::runtime_error("Failed to initialize GLFW");
+        }
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+        // 2. Crea la finestra e rendi il contesto OpenGL attuale
+        window = glfwCreateWindow(width, height, title, NULL, NULL);
+        if (!window)
+        {
+            glfwTerminate();
+            throw std::runtime_error("Failed to create GLFW window");
+        }
+        glfwMakeContextCurrent(window);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+        glfwSetWindowUserPointer(window, this);
+        glfwSetKeyCallback(window, key_callback);
+
+        if (!gladLoadGL((GLADloadfunc)glfwGetProcAddress))
+        {
+            throw std::runtime_error("Failed to initialize GLAD");
+        }
     }
-    glfwMakeContextCurrent(window);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
-    if (!gladLoadGL((GLADloadfunc)glfwGetProcAddress))
+    // Texture cotte in BC1/BC3: senza S3TC nel driver si decodificano sulla CPU
+    TextureCompression::Initialize();
+    // Limite dell'anisotropia del driver: di default resta spenta, vedi SamplerCache::SetAnisotropy
+    SamplerCache::GetInstance().Initialize();
+
+    // Texture degli shader a tabella: handle bindless se disponibili, altrimenti texture array.
+    // Va deciso prima di compilare qualsiasi shader.
+    TextureReferences::GetInstance().Initialize(window ? (GLADloadfunc)glfwGetProcAddress : nullptr);
+    if (TextureReferences::GetInstance().GetMode() == TextureReferenceMode::Bindless)
     {
-        throw std::runtime_error("Failed to initialize GLAD");
+        Shader::AddGlobalDefine(BINDLESS_TEXTURES_DEFINE);
     }
+    // Compilazione degli shader sui thread del driver, controllata senza bloccare (vedi Shader::IsReady)
+    Shader::InitializeParallelCompile(window ? (GLADloadfunc)glfwGetProcAddress : nullptr);
+    // Programmi gia' linkati nelle esecuzioni precedenti, con lo stesso driver
+    ProgramBinaryCache::GetInstance().Initialize(PROGRAM_BINARY_CACHE_DIRECTORY);
 
     glViewport(0, 0, width, height);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+    Profiler::SetThreadName("Main");
+
+    // Asset cotti dall'AssetCooker: se il pack c'e' gli asset si leggono da li', altrimenti dai file
+    if (std::filesystem::exists(DEFAULT_ASSET_PACK))
+    {
+        AssetManager::GetInstance().MountPack(DEFAULT_ASSET_PACK);
+    }
+#ifdef ENGINE_HOT_RELOAD_ENABLED
+    else if (window)
+    {
+        // Con i file sciolti le modifiche a shader, texture e materiali si vedono senza riavviare
+        AssetManager::GetInstance().EnableHotReload(HOT_RELOAD_SOURCE_DIRECTORY);
+    }
+#endif // ENGINE_HOT_RELOAD_ENABLED
+
     // Inizializza i sottosistemi del motore (Flecs, rendering, ecc.)
     RegisterEngineComponents();
 
-    //world.system<Position, Rotation, Scale, SpriteRef, MaterialRef>("RenderingSystem")
-    //    .each(RenderingSystem);
-
     renderer = new Renderer();
 
+    // Sprite pass instanced: raggruppa gli sprite per MaterialRef, una draw call per materiale
+    InitRenderingSystem(*renderer);
+    world.system<const Position, const Rotation, const Scale, const SpriteRef, const MaterialRef>("RenderingSystem")
+        .kind(flecs::OnStore)
+        .run(RenderingSystem);
+
     // V-Sync
-    glfwSwapInterval(0);
+    if (window)
+    {
+        glfwSwapInterval(0);
+    }
 }
 
 Engine::~Engine()
 {
+    ShutdownRenderingSystem();
+    AssetManager::GetInstance().DisableHotReload();
+    AssetManager::GetInstance().GetTextureUploader().Shutdown();
+    TextureAtlas::GetInstance().Shutdown();
+    TextureReferences::GetInstance().Shutdown();
+    SamplerCache::GetInstance().Shutdown();
     delete renderer;
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    if (window)
+    {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
 }
 
 void Engine::Run()
 {
+    if (!window)
+    {
+        std::cerr << "ERROR: Engine::Run needs a window, use RunFrames in headless mode." << std::endl;
+        return;
+    }
+
 #ifdef _DEBUG
     lastFrameTime = glfwGetTime();
 #endif // _DEBUG
@@ -105,30 +191,121 @@ void Engine::Run()
     MainLoop();
 }
 
+void Engine::RunFrames(unsigned int frameCount)
+{
+    for (unsigned int i = 0; i < frameCount; ++i)
+    {
+        if (window && glfwWindowShouldClose(window))
+        {
+            break;
+        }
+
+        RenderFrame();
+
+        if (window)
+        {
+            SwapAndPollEvents();
+        }
+        FinishFrame();
+    }
+}
+
 void Engine::MainLoop()
 {
     while (!glfwWindowShouldClose(window))
     {
-        // Pulisci i buffer
-        glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        RenderFrame();
+
+        SwapAndPollEvents();
+        FinishFrame();
+
+#ifdef _DEBUG
+        UpdateStats();
+#endif // _DEBUG
+
+    }
+}
+
+void Engine::RenderFrame()
+{
+    PROFILE_ZONE("Engine::RenderFrame");
+    int64_t cpuFrameStart = Profiler::Now();
+
+    // Pulisci i buffer
+    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    int framebufferWidth = width, framebufferHeight = height;
+    if (window)
+    {
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    }
+
+    // Costanti per frame (proiezione, tempo) caricate una volta sola prima di tutti i pass
+    renderer->BeginFrame(GetFrameTime(), framebufferWidth, framebufferHeight);
+
+    // Carica sulla GPU le texture decodificate dai worker, entro il budget per frame
+    {
+        GpuZone uploadZone(renderer->GetGpuTimer(), "TextureUploads");
+        AssetManager::GetInstance().GetTextureUploader().ProcessUploads();
+    }
+    // Asset modificati su disco: il nuovo contenuto prende il posto del vecchio tra due frame
+    AssetManager::GetInstance().ProcessReloads();
+    TextureAtlas::GetInstance().CollectRetiredPages();
+
+    {
+        PROFILE_ZONE("world.progress");
+        world.progress(window ? 0.0f : static_cast<float>(HEADLESS_FRAME_TIME));
+    }
 
-        world.progress();
+    std::shared_ptr<MaterialAsset> defaultTexturedMaterial = AssetManager::GetInstance().GetMaterialAsset("Resources/Assets/Materials/MM_default.json");
+    std::shared_ptr<MaterialAsset> defaultMaterial = AssetManager::GetInstance().GetMaterialAsset("Resources/Assets/Materials/MM_glitch.json");
 
-        std::shared_ptr<MaterialAsset> defaultTexturedMaterial = AssetManager::GetInstance().GetMaterialAsset("Resources/Assets/Materials/MM_default.json");
-        std::shared_ptr<MaterialAsset> defaultMaterial = AssetManager::GetInstance().GetMaterialAsset("Resources/Assets/Materials/MM_glitch.json");
+    renderer->DrawSingleColoredQuad(defaultTexturedMaterial, glm::vec2(0.0f, 0.0f), 32.0f);
+    renderer->DrawSingleColoredQuad(defaultMaterial, glm::vec2(500.0f, 400.0f), 100.0f);
 
-        renderer->DrawSingleColoredQuad(defaultTexturedMaterial, glm::vec2(0.0f, 0.0f), 32.0f);
-        renderer->DrawSingleColoredQuad(defaultMaterial, glm::vec2(500.0f, 400.0f), 100.0f);
+    // Ordina ed esegue le draw accodate durante il frame
+    renderer->EndFrame();
+    EndRenderingSystemFrame();
+    cpuFrameStatistics.Add(static_cast<double>(Profiler::Now() - cpuFrameStart) / 1.0e6);
+}
 
+void Engine::SwapAndPollEvents()
+{
+    {
+        PROFILE_ZONE("glfwSwapBuffers");
         glfwSwapBuffers(window);
-        glfwPollEvents();
+    }
+    PROFILE_ZONE("glfwPollEvents");
+    glfwPollEvents();
+}
 
-#ifdef _DEBUG
-        UpdateStats();
-#endif // _DEBUG
+void Engine::FinishFrame()
+{
+    // La traccia viene scritta tra due frame, cosi' contiene il frame appena concluso per intero
+    if (profilerCaptureRequested)
+    {
+        std::string path = pendingProfilerCapture.empty() ? "profile_" + std::to_string(frameIndex) + ".json" : pendingProfilerCapture;
+        Profiler::WriteChromeTrace(path);
+        profilerCaptureRequested = false;
+        pendingProfilerCapture.clear();
+    }
+    frameIndex++;
+}
+
+void Engine::RequestProfilerCapture(const std::string& path)
+{
+    pendingProfilerCapture = path;
+    profilerCaptureRequested = true;
+}
 
+float Engine::GetFrameTime() const
+{
+    if (!window)
+    {
+        return static_cast<float>(frameIndex * HEADLESS_FRAME_TIME);
     }
+    return static_cast<float>(glfwGetTime());
 }
 
 void Engine::UpdateStats()
@@ -173,7 +350,51 @@ void Engine::RegisterEngineComponents()
     world.component<SpriteRef>();
 }
 
+TimingStats Engine::GetCpuFrameStatistics() const
+{
+    return cpuFrameStatistics.Summarize("CPU Frame");
+}
+
+std::vector<TimingStats> Engine::GetGpuStatistics() const
+{
+    return renderer->GetGpuTimer().GetStatistics();
+}
+
+const RenderQueueStats& Engine::GetRenderQueueStats() const
+{
+    return renderer->GetRenderQueueStats();
+}
+
+void Engine::LogFrameStatistics(std::ostream& out) const
+{
+    std::vector<TimingStats> all = GetGpuStatistics();
+    all.insert(all.begin(), GetCpuFrameStatistics());
+
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+    for (const TimingStats& stats : all)
+    {
+        out << std::left << std::setw(24) << stats.name << std::right
+            << " min " << std::setw(8) << stats.min << " ms"
+            << "  avg " << std::setw(8) << stats.avg << " ms"
+            << "  p99 " << std::setw(8) << stats.p99 << " ms"
+            << "  (" << stats.samples << " frames)" << std::endl;
+    }
+
+    AssetStats assetStats = AssetManager::GetInstance().GetStats();
+    out << "Shader programs: " << assetStats.shaderPrograms << " for " << assetStats.shaderVariants << " variants ("
+        << assetStats.deduplicatedPrograms << " deduplicated)" << std::endl;
+    out.flags(flags);
+    out.precision(precision);
+}
+
 flecs::world& Engine::GetWorld()
 {
     return world;
+}
+
+bool Engine::IsHeadless() const
+{
+    return mode == EngineMode::Headless;
 }
\ No newline at end of file
@@ -0,0 +1,232 @@
+#include "Core/FileWatcher.h"
+#include "Core/Profiler.h"
+#include <iostream>
+#include <system_error>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+// Changes that make a file worth reloading, plus the directory events that keep the watches in sync
+static const uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE_SELF;
+#else
+#include <chrono>
+#endif
+
+FileWatcher::~FileWatcher()
+{
+    Stop();
+}
+
+bool FileWatcher::Start(const std::string& root)
+{
+    Stop();
+
+    std::error_code error;
+    if (!std::filesystem::is_directory(root, error))
+    {
+        std::cerr << "ERROR: Cannot watch a missing directory: " << root << std::endl;
+        return false;
+    }
+    this->root = std::filesystem::path(root).lexically_normal();
+
+#ifdef __linux__
+    descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (descriptor < 0)
+    {
+        std::cerr << "ERROR: inotify is not available, cannot watch " << root << std::endl;
+        return false;
+    }
+    AddWatches(this->root, false);
+#else
+    Scan(false);
+#endif
+
+    stopRequested = false;
+    thread = std::thread(&FileWatcher::WatchThread, this);
+    return true;
+}
+
+void FileWatcher::Stop()
+{
+    if (thread.joinable())
+    {
+        stopRequested = true;
+        thread.join();
+    }
+#ifdef __linux__
+    if (descriptor >= 0)
+    {
+        close(descriptor);
+        descriptor = -1;
+    }
+    watches.clear();
+#else
+    writeTimes.clear();
+#endif
+}
+
+bool FileWatcher::IsWatching() const
+{
+    return thread.joinable();
+}
+
+std::vector<std::string> FileWatcher::TakeChanges()
+{
+    std::lock_guard<std::mutex> lock(changesMutex);
+    std::vector<std::string> taken(changes.begin(), changes.end());
+    changes.clear();
+    return taken;
+}
+
+void FileWatcher::AddChange(const std::filesystem::path& path)
+{
+    std::lock_guard<std::mutex> lock(changesMutex);
+    changes.insert(path.lexically_normal().generic_string());
+}
+
+void FileWatcher::WatchThread()
+{
+    Profiler::SetThreadName("File Watcher");
+
+    while (!stopRequested)
+    {
+#ifdef __linux__
+        // The timeout only bounds how long Stop waits for the thread
+        pollfd request = { descriptor, POLLIN, 0 };
+        if (poll(&request, 1, POLL_INTERVAL_MS) > 0)
+        {
+            ReadEvents();
+        }
+#else
+        std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS));
+        Scan(true);
+#endif
+    }
+}
+
+#ifdef __linux__
+
+// A directory created after Start may already hold files when its watch is added (e.g. copied
+// in one go): with 'reportFiles' those are reported as changed
+void FileWatcher::AddWatches(const std::filesystem::path& directory, bool reportFiles)
+{
+    std::error_code error;
+    std::error_code entryError;
+    std::vector<std::filesystem::path> directories = { directory };
+    for (auto it = std::filesystem::recursive_directory_iterator(directory, error); !error && it != std::filesystem::recursive_directory_iterator();
+         it.increment(error))
+    {
+        if (it->is_directory(entryError))
+        {
+            directories.push_back(it->path());
+        }
+        else if (reportFiles && it->is_regular_file(entryError))
+        {
+            AddChange(it->path());
+        }
+    }
+
+    for (const std::filesystem::path& path : directories)
+    {
+        int watch = inotify_add_watch(descriptor, path.c_str(), WATCH_MASK);
+        if (watch < 0)
+        {
+            std::cerr << "WARNING: Cannot watch directory: " << path.string() << std::endl;
+            continue;
+        }
+        watches[watch] = path;
+    }
+}
+
+void FileWatcher::ReadEvents()
+{
+    PROFILE_ZONE("FileWatcher::ReadEvents");
+
+    alignas(inotify_event) char buffer[16 * 1024];
+    while (true)
+    {
+        ssize_t length = read(descriptor, buffer, sizeof(buffer));
+        if (length <= 0)
+        {
+            return;
+        }
+
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                std::cerr << "WARNING: File watcher queue overflow, some changes were lost" << std::endl;
+                continue;
+            }
+            auto watch = watches.find(event->wd);
+            if (watch == watches.end())
+            {
+                continue;
+            }
+            if (event->mask & (IN_DELETE_SELF | IN_IGNORED))
+            {
+                watches.erase(watch);
+                continue;
+            }
+            if (event->len == 0)
+            {
+                continue;
+            }
+
+            std::filesystem::path path = watch->second / event->name;
+            if (event->mask & IN_ISDIR)
+            {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                {
+                    AddWatches(path, true);
+                }
+            }
+            else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+            {
+                AddChange(path);
+            }
+        }
+    }
+}
+
+#else
+
+void FileWatcher::Scan(bool reportChanges)
+{
+    std::error_code error;
+    std::error_code entryError;
+    for (auto it = std::filesystem::recursive_directory_iterator(root, error); !error && it != std::filesystem::recursive_directory_iterator();
+         it.increment(error))
+    {
+        if (!it->is_regular_file(entryError))
+        {
+            continue;
+        }
+        std::filesystem::file_time_type writeTime = it->last_write_time(entryError);
+        if (entryError)
+        {
+            continue;
+        }
+
+        auto [known, inserted] = writeTimes.try_emplace(it->path().generic_string(), writeTime);
+        if (!inserted && known->second != writeTime)
+        {
+            known->second = writeTime;
+            if (reportChanges)
+            {
+                AddChange(it->path());
+            }
+        }
+        else if (inserted && reportChanges)
+        {
+            AddChange(it->path());
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,97 @@
+#include "Core/GLStateCache.h"
+
+GLStateCache& GLStateCache::GetInstance()
+{
+    static GLStateCache instance;
+    return instance;
+}
+
+GLStateCache::GLStateCache()
+{
+    Invalidate();
+}
+
+void GLStateCache::UseProgram(GLuint value)
+{
+    if (program == value)
+    {
+        elided++;
+        return;
+    }
+    glUseProgram(value);
+    program = value;
+    issued++;
+}
+
+void GLStateCache::BindTextureUnit(GLuint unit, GLuint texture)
+{
+    // Units past the cached range are always bound
+    if (unit < MAX_TEXTURE_UNITS)
+    {
+        if (textures[unit] == texture)
+        {
+            elided++;
+            return;
+        }
+        textures[unit] = texture;
+    }
+    glBindTextureUnit(unit, texture);
+    issued++;
+}
+
+void GLStateCache::BindSampler(GLuint unit, GLuint sampler)
+{
+    if (unit < MAX_TEXTURE_UNITS)
+    {
+        if (samplers[unit] == sampler)
+        {
+            elided++;
+            return;
+        }
+        samplers[unit] = sampler;
+    }
+    glBindSampler(unit, sampler);
+    issued++;
+}
+
+void GLStateCache::BindVertexArray(GLuint vao)
+{
+    if (vertexArray == vao)
+    {
+        elided++;
+        return;
+    }
+    glBindVertexArray(vao);
+    vertexArray = vao;
+    issued++;
+}
+
+void GLStateCache::Invalidate()
+{
+    program = UNKNOWN;
+    vertexArray = UNKNOWN;
+    for (GLuint& texture : textures)
+    {
+        texture = UNKNOWN;
+    }
+    for (GLuint& sampler : samplers)
+    {
+        sampler = UNKNOWN;
+    }
+}
+
+uint64_t GLStateCache::GetIssuedCount() const
+{
+    return issued;
+}
+
+uint64_t GLStateCache::GetElidedCount() const
+{
+    return elided;
+}
+
+void GLStateCache::ResetCounters()
+{
+    issued = 0;
+    elided = 0;
+}
@@ -0,0 +1,158 @@
+#include "Core/GpuTimer.h"
+#include <algorithm>
+
+// Queries created at a time when a frame slot runs out of them
+static const size_t QUERY_POOL_GROWTH = 32;
+
+GpuTimer::GpuTimer(unsigned int framesInFlight, size_t historySize) : frames(std::max(framesInFlight, 1u)), historySize(historySize)
+{
+}
+
+GpuTimer::~GpuTimer()
+{
+    for (FrameSlot& frame : frames)
+    {
+        if (!frame.queries.empty())
+        {
+            glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+        }
+    }
+}
+
+void GpuTimer::BeginFrame()
+{
+    FrameSlot& frame = frames[currentFrame];
+    if (frame.usedQueries > 0)
+    {
+        CollectResults(frame);
+    }
+    frame.usedQueries = 0;
+    frame.scopes.clear();
+
+    frameScope = BeginScope("Frame");
+}
+
+void GpuTimer::EndFrame()
+{
+    EndScope(frameScope);
+    frameScope = INVALID_SCOPE;
+    currentFrame = (currentFrame + 1) % frames.size();
+}
+
+unsigned int GpuTimer::BeginScope(const char* name, int id)
+{
+    if (!enabled)
+    {
+        return INVALID_SCOPE;
+    }
+
+    FrameSlot& frame = frames[currentFrame];
+    unsigned int beginQuery = IssueTimestamp(frame);
+    frame.scopes.push_back({ name, id, beginQuery, INVALID_SCOPE });
+    return static_cast<unsigned int>(frame.scopes.size() - 1);
+}
+
+void GpuTimer::EndScope(unsigned int scope)
+{
+    FrameSlot& frame = frames[currentFrame];
+    if (scope >= frame.scopes.size())
+    {
+        return;
+    }
+    frame.scopes[scope].endQuery = IssueTimestamp(frame);
+}
+
+unsigned int GpuTimer::IssueTimestamp(FrameSlot& frame)
+{
+    if (frame.usedQueries == frame.queries.size())
+    {
+        size_t oldSize = frame.queries.size();
+        frame.queries.resize(oldSize + QUERY_POOL_GROWTH);
+        glCreateQueries(GL_TIMESTAMP, static_cast<GLsizei>(QUERY_POOL_GROWTH), frame.queries.data() + oldSize);
+    }
+
+    glQueryCounter(frame.queries[frame.usedQueries], GL_TIMESTAMP);
+    return frame.usedQueries++;
+}
+
+void GpuTimer::CollectResults(FrameSlot& frame)
+{
+    // Timestamps complete in submission order: if the last one is available, all of them are
+    GLint available = 0;
+    glGetQueryObjectiv(frame.queries[frame.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+    {
+        droppedFrames++;
+        return;
+    }
+
+    timestamps.resize(frame.usedQueries);
+    for (unsigned int i = 0; i < frame.usedQueries; ++i)
+    {
+        glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &timestamps[i]);
+    }
+
+    for (const Scope& scope : frame.scopes)
+    {
+        // Scopes never closed during the frame have no duration
+        if (scope.endQuery == INVALID_SCOPE)
+        {
+            continue;
+        }
+
+        nameBuffer = scope.name;
+        if (scope.id >= 0)
+        {
+            nameBuffer += " #";
+            nameBuffer += std::to_string(scope.id);
+        }
+
+        auto it = statistics.find(nameBuffer);
+        if (it == statistics.end())
+        {
+            it = statistics.emplace(nameBuffer, RollingStatistics(historySize)).first;
+        }
+
+        GLuint64 begin = timestamps[scope.beginQuery];
+        GLuint64 end = timestamps[scope.endQuery];
+        it->second.Add(end > begin ? static_cast<double>(end - begin) / 1.0e6 : 0.0);
+    }
+}
+
+std::vector<TimingStats> GpuTimer::GetStatistics() const
+{
+    std::vector<TimingStats> result;
+    result.reserve(statistics.size());
+    for (const auto& [name, stats] : statistics)
+    {
+        result.push_back(stats.Summarize(name));
+    }
+    return result;
+}
+
+TimingStats GpuTimer::GetStatistics(const std::string& name) const
+{
+    auto it = statistics.find(name);
+    if (it == statistics.end())
+    {
+        TimingStats empty;
+        empty.name = name;
+        return empty;
+    }
+    return it->second.Summarize(name);
+}
+
+size_t GpuTimer::GetDroppedFrameCount() const
+{
+    return droppedFrames;
+}
+
+void GpuTimer::SetEnabled(bool value)
+{
+    enabled = value;
+}
+
+bool GpuTimer::IsEnabled() const
+{
+    return enabled;
+}
@@ -0,0 +1,103 @@
+#include "Core/Hash.h"
+#include <cstring>
+
+static const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ull;
+static const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4Full;
+static const uint64_t PRIME64_3 = 0x165667B19E3779F9ull;
+static const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ull;
+static const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ull;
+
+static uint64_t RotateLeft(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// Unaligned little endian reads, the byte order of every platform the engine runs on
+static uint64_t Read64(const unsigned char* bytes)
+{
+    uint64_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static uint32_t Read32(const unsigned char* bytes)
+{
+    uint32_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+static uint64_t Round(uint64_t accumulator, uint64_t input)
+{
+    accumulator += input * PRIME64_2;
+    accumulator = RotateLeft(accumulator, 31);
+    return accumulator * PRIME64_1;
+}
+
+static uint64_t MergeRound(uint64_t accumulator, uint64_t value)
+{
+    accumulator ^= Round(0, value);
+    return accumulator * PRIME64_1 + PRIME64_4;
+}
+
+uint64_t Hash64(const void* data, size_t size, uint64_t seed)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    const unsigned char* end = bytes + size;
+    uint64_t hash;
+
+    // Four independent lanes over 32-byte stripes
+    if (size >= 32)
+    {
+        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+        uint64_t v2 = seed + PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME64_1;
+        const unsigned char* limit = end - 32;
+        do
+        {
+            v1 = Round(v1, Read64(bytes));
+            v2 = Round(v2, Read64(bytes + 8));
+            v3 = Round(v3, Read64(bytes + 16));
+            v4 = Round(v4, Read64(bytes + 24));
+            bytes += 32;
+        } while (bytes <= limit);
+
+        hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+        hash = MergeRound(hash, v1);
+        hash = MergeRound(hash, v2);
+        hash = MergeRound(hash, v3);
+        hash = MergeRound(hash, v4);
+    }
+    else
+    {
+        hash = seed + PRIME64_5;
+    }
+    hash += static_cast<uint64_t>(size);
+
+    // Tail: 8, 4 and 1 bytes at a time
+    for (; bytes + 8 <= end; bytes += 8)
+    {
+        hash ^= Round(0, Read64(bytes));
+        hash = RotateLeft(hash, 27) * PRIME64_1 + PRIME64_4;
+    }
+    if (bytes + 4 <= end)
+    {
+        hash ^= static_cast<uint64_t>(Read32(bytes)) * PRIME64_1;
+        hash = RotateLeft(hash, 23) * PRIME64_2 + PRIME64_3;
+        bytes += 4;
+    }
+    for (; bytes < end; ++bytes)
+    {
+        hash ^= (*bytes) * PRIME64_5;
+        hash = RotateLeft(hash, 11) * PRIME64_1;
+    }
+
+    // Avalanche
+    hash ^= hash >> 33;
+    hash *= PRIME64_2;
+    hash ^= hash >> 29;
+    hash *= PRIME64_3;
+    hash ^= hash >> 32;
+    return hash;
+}
@@ -0,0 +1,690 @@
+#include "Core/NullGL.h"
+#include <glad/gl.h>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// The backend is driven by the render thread only, like a real context
+static GLCallStats stats;
+static GLuint nextObjectName = 1;
+static uintptr_t nextSyncName = 1;
+
+// System memory behind every buffer, so glMap* can return a writable pointer
+static std::unordered_map<GLuint, std::vector<unsigned char>> bufferStorage;
+static std::unordered_map<GLenum, GLuint> boundBuffers;
+
+// Uniform locations handed out per program, stable across queries of the same name
+static std::unordered_map<GLuint, std::unordered_map<std::string, GLint>> uniformLocations;
+
+static size_t BytesPerPixel(GLenum format, GLenum type)
+{
+    size_t components = 4;
+    switch (format)
+    {
+    case GL_RED:
+    case GL_RED_INTEGER:
+    case GL_DEPTH_COMPONENT:
+        components = 1;
+        break;
+    case GL_RG:
+    case GL_RG_INTEGER:
+        components = 2;
+        break;
+    case GL_RGB:
+    case GL_BGR:
+    case GL_RGB_INTEGER:
+        components = 3;
+        break;
+    default:
+        break;
+    }
+
+    switch (type)
+    {
+    case GL_UNSIGNED_SHORT:
+    case GL_SHORT:
+    case GL_HALF_FLOAT:
+        return components * 2;
+    case GL_UNSIGNED_INT:
+    case GL_INT:
+    case GL_FLOAT:
+        return components * 4;
+    default:
+        return components;
+    }
+}
+
+static void GenerateNames(GLsizei n, GLuint* names)
+{
+    stats.calls++;
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        names[i] = nextObjectName++;
+    }
+}
+
+static void ResizeBuffer(GLuint buffer, GLsizeiptr size, const void* data)
+{
+    std::vector<unsigned char>& storage = bufferStorage[buffer];
+    storage.assign(static_cast<size_t>(size), 0);
+    if (data)
+    {
+        std::memcpy(storage.data(), data, static_cast<size_t>(size));
+        stats.bytesUploaded += static_cast<uint64_t>(size);
+    }
+}
+
+static void WriteBuffer(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data)
+{
+    std::vector<unsigned char>& storage = bufferStorage[buffer];
+    if (data && static_cast<size_t>(offset + size) <= storage.size())
+    {
+        std::memcpy(storage.data() + offset, data, static_cast<size_t>(size));
+    }
+    stats.bytesUploaded += static_cast<uint64_t>(size);
+}
+
+static void* MapBuffer(GLuint buffer, GLintptr offset)
+{
+    std::vector<unsigned char>& storage = bufferStorage[buffer];
+    return storage.empty() ? nullptr : storage.data() + offset;
+}
+
+// Entry points without side effects get a stub generated from their glad pointer type, so the
+// stub takes exactly the arguments the caller passes: with __stdcall (32-bit Windows) the callee
+// pops them itself. Integer and pointer results read as 0 / nullptr.
+template<typename Function>
+struct NullStub;
+
+template<typename Result, typename... Args>
+struct NullStub<Result (GLAD_API_PTR*)(Args...)>
+{
+    static Result GLAD_API_PTR Noop(Args...)
+    {
+        stats.calls++;
+        return Result();
+    }
+
+    static Result GLAD_API_PTR StateChange(Args...)
+    {
+        stats.calls++;
+        stats.stateChanges++;
+        return Result();
+    }
+
+    static Result GLAD_API_PTR Uniform(Args...)
+    {
+        stats.calls++;
+        stats.uniformUpdates++;
+        return Result();
+    }
+};
+
+// Queries
+
+static const GLubyte* GLAD_API_PTR NullGetString(GLenum name)
+{
+    stats.calls++;
+    const char* value = "";
+    switch (name)
+    {
+    case GL_VERSION:
+        value = "4.6.0 Null";
+        break;
+    case GL_VENDOR:
+        value = "ConceptualEngine";
+        break;
+    case GL_RENDERER:
+        value = "Null GL backend";
+        break;
+    case GL_SHADING_LANGUAGE_VERSION:
+        value = "4.60";
+        break;
+    default:
+        break;
+    }
+    return reinterpret_cast<const GLubyte*>(value);
+}
+
+static const GLubyte* GLAD_API_PTR NullGetStringi(GLenum, GLuint)
+{
+    stats.calls++;
+    return reinterpret_cast<const GLubyte*>("");
+}
+
+static void GLAD_API_PTR NullGetIntegerv(GLenum pname, GLint* data)
+{
+    stats.calls++;
+    switch (pname)
+    {
+    case GL_MAX_TEXTURE_SIZE:
+        *data = 16384;
+        break;
+    case GL_MAX_UNIFORM_BLOCK_SIZE:
+        *data = 65536;
+        break;
+    case GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT:
+    case GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT:
+        *data = 256;
+        break;
+    case GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS:
+        *data = 32;
+        break;
+    default:
+        *data = 0;
+        break;
+    }
+}
+
+static void GLAD_API_PTR NullGetShaderiv(GLuint, GLenum pname, GLint* params)
+{
+    stats.calls++;
+    *params = (pname == GL_COMPILE_STATUS) ? GL_TRUE : 0;
+}
+
+static void GLAD_API_PTR NullGetProgramiv(GLuint, GLenum pname, GLint* params)
+{
+    stats.calls++;
+    *params = (pname == GL_LINK_STATUS || pname == GL_VALIDATE_STATUS) ? GL_TRUE : 0;
+}
+
+static void GLAD_API_PTR NullGetInfoLog(GLuint, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
+{
+    stats.calls++;
+    if (length)
+    {
+        *length = 0;
+    }
+    if (infoLog && bufSize > 0)
+    {
+        infoLog[0] = '\0';
+    }
+}
+
+static GLint GLAD_API_PTR NullGetUniformLocation(GLuint program, const GLchar* name)
+{
+    stats.calls++;
+    std::unordered_map<std::string, GLint>& locations = uniformLocations[program];
+    auto [it, inserted] = locations.try_emplace(name, static_cast<GLint>(locations.size()));
+    return it->second;
+}
+
+static GLuint GLAD_API_PTR NullGetUniformBlockIndex(GLuint, const GLchar*)
+{
+    stats.calls++;
+    return GL_INVALID_INDEX;
+}
+
+static GLuint GLAD_API_PTR NullGetProgramResourceIndex(GLuint, GLenum, const GLchar*)
+{
+    stats.calls++;
+    return GL_INVALID_INDEX;
+}
+
+static void GLAD_API_PTR NullGetQueryObjectiv(GLuint, GLenum pname, GLint* params)
+{
+    stats.calls++;
+    *params = (pname == GL_QUERY_RESULT_AVAILABLE) ? GL_TRUE : 0;
+}
+
+static void GLAD_API_PTR NullGetQueryObjectui64v(GLuint, GLenum, GLuint64* params)
+{
+    stats.calls++;
+    *params = 0;
+}
+
+static GLenum GLAD_API_PTR NullCheckFramebufferStatus(GLenum)
+{
+    stats.calls++;
+    return GL_FRAMEBUFFER_COMPLETE;
+}
+
+// Object creation
+
+static GLuint GLAD_API_PTR NullCreateShader(GLenum)
+{
+    stats.calls++;
+    return nextObjectName++;
+}
+
+static GLuint GLAD_API_PTR NullCreateProgram()
+{
+    stats.calls++;
+    return nextObjectName++;
+}
+
+static void GLAD_API_PTR NullGenNames(GLsizei n, GLuint* names)
+{
+    GenerateNames(n, names);
+}
+
+static void GLAD_API_PTR NullCreateNamesWithTarget(GLenum, GLsizei n, GLuint* names)
+{
+    GenerateNames(n, names);
+}
+
+static void GLAD_API_PTR NullDeleteBuffers(GLsizei n, const GLuint* buffers)
+{
+    stats.calls++;
+    for (GLsizei i = 0; i < n; ++i)
+    {
+        bufferStorage.erase(buffers[i]);
+    }
+}
+
+static void GLAD_API_PTR NullDeleteProgram(GLuint program)
+{
+    stats.calls++;
+    uniformLocations.erase(program);
+}
+
+static GLsync GLAD_API_PTR NullFenceSync(GLenum, GLbitfield)
+{
+    stats.calls++;
+    return reinterpret_cast<GLsync>(nextSyncName++);
+}
+
+static GLenum GLAD_API_PTR NullClientWaitSync(GLsync, GLbitfield, GLuint64)
+{
+    stats.calls++;
+    return GL_ALREADY_SIGNALED;
+}
+
+// Buffers
+
+static void GLAD_API_PTR NullBindBuffer(GLenum target, GLuint buffer)
+{
+    stats.calls++;
+    stats.stateChanges++;
+    boundBuffers[target] = buffer;
+}
+
+static void GLAD_API_PTR NullNamedBufferStorage(GLuint buffer, GLsizeiptr size, const void* data, GLbitfield)
+{
+    stats.calls++;
+    ResizeBuffer(buffer, size, data);
+}
+
+static void GLAD_API_PTR NullNamedBufferData(GLuint buffer, GLsizeiptr size, const void* data, GLenum)
+{
+    stats.calls++;
+    ResizeBuffer(buffer, size, data);
+}
+
+static void GLAD_API_PTR NullBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum)
+{
+    stats.calls++;
+    ResizeBuffer(boundBuffers[target], size, data);
+}
+
+static void GLAD_API_PTR NullBufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield)
+{
+    stats.calls++;
+    ResizeBuffer(boundBuffers[target], size, data);
+}
+
+static void GLAD_API_PTR NullNamedBufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data)
+{
+    stats.calls++;
+    WriteBuffer(buffer, offset, size, data);
+}
+
+static void GLAD_API_PTR NullBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+{
+    stats.calls++;
+    WriteBuffer(boundBuffers[target], offset, size, data);
+}
+
+static void* GLAD_API_PTR NullMapNamedBufferRange(GLuint buffer, GLintptr offset, GLsizeiptr, GLbitfield)
+{
+    stats.calls++;
+    return MapBuffer(buffer, offset);
+}
+
+static void* GLAD_API_PTR NullMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr, GLbitfield)
+{
+    stats.calls++;
+    return MapBuffer(boundBuffers[target], offset);
+}
+
+static void* GLAD_API_PTR NullMapNamedBuffer(GLuint buffer, GLenum)
+{
+    stats.calls++;
+    return MapBuffer(buffer, 0);
+}
+
+static void* GLAD_API_PTR NullMapBuffer(GLenum target, GLenum)
+{
+    stats.calls++;
+    return MapBuffer(boundBuffers[target], 0);
+}
+
+// Textures
+
+static void GLAD_API_PTR NullTexImage2D(GLenum, GLint, GLint, GLsizei width, GLsizei height, GLint, GLenum format, GLenum type, const void* pixels)
+{
+    stats.calls++;
+    if (pixels)
+    {
+        stats.bytesUploaded += static_cast<uint64_t>(width) * height * BytesPerPixel(format, type);
+    }
+}
+
+static void GLAD_API_PTR NullTexSubImage2D(GLenum, GLint, GLint, GLint, GLsizei width, GLsizei height, GLenum format, GLenum type, const void*)
+{
+    stats.calls++;
+    stats.bytesUploaded += static_cast<uint64_t>(width) * height * BytesPerPixel(format, type);
+}
+
+static void GLAD_API_PTR NullTextureSubImage2D(GLuint, GLint, GLint, GLint, GLsizei width, GLsizei height, GLenum format, GLenum type, const void*)
+{
+    stats.calls++;
+    stats.bytesUploaded += static_cast<uint64_t>(width) * height * BytesPerPixel(format, type);
+}
+
+static void GLAD_API_PTR NullTexImage3D(GLenum, GLint, GLint, GLsizei width, GLsizei height, GLsizei depth, GLint, GLenum format, GLenum type, const void* pixels)
+{
+    stats.calls++;
+    if (pixels)
+    {
+        stats.bytesUploaded += static_cast<uint64_t>(width) * height * depth * BytesPerPixel(format, type);
+    }
+}
+
+static void GLAD_API_PTR NullTexSubImage3D(GLenum, GLint, GLint, GLint, GLint, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void*)
+{
+    stats.calls++;
+    stats.bytesUploaded += static_cast<uint64_t>(width) * height * depth * BytesPerPixel(format, type);
+}
+
+static void GLAD_API_PTR NullTextureSubImage3D(GLuint, GLint, GLint, GLint, GLint, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void*)
+{
+    stats.calls++;
+    stats.bytesUploaded += static_cast<uint64_t>(width) * height * depth * BytesPerPixel(format, type);
+}
+
+static void GLAD_API_PTR NullCompressedTexImage2D(GLenum, GLint, GLenum, GLsizei, GLsizei, GLint, GLsizei imageSize, const void* data)
+{
+    stats.calls++;
+    if (data)
+    {
+        stats.bytesUploaded += static_cast<uint64_t>(imageSize);
+    }
+}
+
+static void GLAD_API_PTR NullCompressedTextureSubImage2D(GLuint, GLint, GLint, GLint, GLsizei, GLsizei, GLenum, GLsizei imageSize, const void*)
+{
+    stats.calls++;
+    stats.bytesUploaded += static_cast<uint64_t>(imageSize);
+}
+
+// Draws
+
+static void GLAD_API_PTR NullDrawArrays(GLenum, GLint, GLsizei)
+{
+    stats.calls++;
+    stats.drawCalls++;
+    stats.instances++;
+}
+
+static void GLAD_API_PTR NullDrawElements(GLenum, GLsizei, GLenum, const void*)
+{
+    stats.calls++;
+    stats.drawCalls++;
+    stats.instances++;
+}
+
+static void GLAD_API_PTR NullDrawElementsBaseVertex(GLenum, GLsizei, GLenum, const void*, GLint)
+{
+    stats.calls++;
+    stats.drawCalls++;
+    stats.instances++;
+}
+
+static void GLAD_API_PTR NullDrawArraysInstanced(GLenum, GLint, GLsizei, GLsizei instancecount)
+{
+    stats.calls++;
+    stats.drawCalls++;
+    stats.instances += static_cast<uint64_t>(instancecount);
+}
+
+static void GLAD_API_PTR NullDrawArraysInstancedBaseInstance(GLenum, GLint, GLsizei, GLsizei instancecount, GLuint)
+{
+    stats.calls++;
+    stats.drawCalls++;
+    stats.instances += static_cast<uint64_t>(instancecount);
+}
+
+static void GLAD_API_PTR NullDrawElementsInstanced(GLenum, GLsizei, GLenum, const void*, GLsizei instancecount)
+{
+    stats.calls++;
+    stats.drawCalls++;
+    stats.instances += static_cast<uint64_t>(instancecount);
+}
+
+static void GLAD_API_PTR NullDrawElementsInstancedBaseInstance(GLenum, GLsizei, GLenum, const void*, GLsizei instancecount, GLuint)
+{
+    stats.calls++;
+    stats.drawCalls++;
+    stats.instances += static_cast<uint64_t>(instancecount);
+}
+
+static void GLAD_API_PTR NullDrawElementsInstancedBaseVertexBaseInstance(GLenum, GLsizei, GLenum, const void*, GLsizei instancecount, GLint, GLuint)
+{
+    stats.calls++;
+    stats.drawCalls++;
+    stats.instances += static_cast<uint64_t>(instancecount);
+}
+
+// The commands live in the bound GL_DRAW_INDIRECT_BUFFER, which is backed by system memory here
+static void CountIndirectDraws(const void* indirect, GLsizei drawcount, GLsizei stride, size_t commandSize, size_t instanceCountOffset)
+{
+    stats.calls++;
+    stats.drawCalls += static_cast<uint64_t>(drawcount);
+
+    const std::vector<unsigned char>& storage = bufferStorage[boundBuffers[GL_DRAW_INDIRECT_BUFFER]];
+    const size_t step = (stride != 0) ? static_cast<size_t>(stride) : commandSize;
+    size_t offset = reinterpret_cast<size_t>(indirect);
+    for (GLsizei i = 0; i < drawcount; ++i, offset += step)
+    {
+        if (offset + commandSize > storage.size())
+        {
+            break;
+        }
+        GLuint instanceCount;
+        std::memcpy(&instanceCount, storage.data() + offset + instanceCountOffset, sizeof(GLuint));
+        stats.instances += instanceCount;
+    }
+}
+
+static void GLAD_API_PTR NullMultiDrawArraysIndirect(GLenum, const void* indirect, GLsizei drawcount, GLsizei stride)
+{
+    // DrawArraysIndirectCommand: count, instanceCount, first, baseInstance
+    CountIndirectDraws(indirect, drawcount, stride, 4 * sizeof(GLuint), sizeof(GLuint));
+}
+
+static void GLAD_API_PTR NullMultiDrawElementsIndirect(GLenum, GLenum, const void* indirect, GLsizei drawcount, GLsizei stride)
+{
+    // DrawElementsIndirectCommand: count, instanceCount, firstIndex, baseVertex, baseInstance
+    CountIndirectDraws(indirect, drawcount, stride, 5 * sizeof(GLuint), sizeof(GLuint));
+}
+
+template<typename Function>
+static GLADapiproc Proc(Function function)
+{
+    return reinterpret_cast<GLADapiproc>(function);
+}
+
+// Table entries for the generated stubs, typed after the glad pointer of the entry point
+#define NULL_NOOP(name) { #name, Proc(NullStub<decltype(glad_##name)>::Noop) }
+#define NULL_STATE_CHANGE(name) { #name, Proc(NullStub<decltype(glad_##name)>::StateChange) }
+#define NULL_UNIFORM(name) { #name, Proc(NullStub<decltype(glad_##name)>::Uniform) }
+
+static GLADapiproc NullGetProcAddress(const char* name)
+{
+    static const std::unordered_map<std::string_view, GLADapiproc> procs = {
+        { "glGetString", Proc(NullGetString) },
+        { "glGetStringi", Proc(NullGetStringi) },
+        { "glGetIntegerv", Proc(NullGetIntegerv) },
+        { "glGetShaderiv", Proc(NullGetShaderiv) },
+        { "glGetProgramiv", Proc(NullGetProgramiv) },
+        { "glGetShaderInfoLog", Proc(NullGetInfoLog) },
+        { "glGetProgramInfoLog", Proc(NullGetInfoLog) },
+        { "glGetUniformLocation", Proc(NullGetUniformLocation) },
+        { "glGetUniformBlockIndex", Proc(NullGetUniformBlockIndex) },
+        { "glGetProgramResourceIndex", Proc(NullGetProgramResourceIndex) },
+        { "glGetQueryObjectiv", Proc(NullGetQueryObjectiv) },
+        { "glGetQueryObjectui64v", Proc(NullGetQueryObjectui64v) },
+        { "glCheckFramebufferStatus", Proc(NullCheckFramebufferStatus) },
+
+        { "glCreateShader", Proc(NullCreateShader) },
+        { "glCreateProgram", Proc(NullCreateProgram) },
+        { "glGenBuffers", Proc(NullGenNames) },
+        { "glCreateBuffers", Proc(NullGenNames) },
+        { "glGenTextures", Proc(NullGenNames) },
+        { "glCreateTextures", Proc(NullCreateNamesWithTarget) },
+        { "glGenVertexArrays", Proc(NullGenNames) },
+        { "glCreateVertexArrays", Proc(NullGenNames) },
+        { "glGenFramebuffers", Proc(NullGenNames) },
+        { "glCreateFramebuffers", Proc(NullGenNames) },
+        { "glGenQueries", Proc(NullGenNames) },
+        { "glCreateQueries", Proc(NullCreateNamesWithTarget) },
+        { "glGenSamplers", Proc(NullGenNames) },
+        { "glCreateSamplers", Proc(NullGenNames) },
+        { "glDeleteBuffers", Proc(NullDeleteBuffers) },
+        { "glDeleteProgram", Proc(NullDeleteProgram) },
+        { "glFenceSync", Proc(NullFenceSync) },
+        { "glClientWaitSync", Proc(NullClientWaitSync) },
+
+        { "glBindBuffer", Proc(NullBindBuffer) },
+        { "glNamedBufferStorage", Proc(NullNamedBufferStorage) },
+        { "glNamedBufferData", Proc(NullNamedBufferData) },
+        { "glBufferData", Proc(NullBufferData) },
+        { "glBufferStorage", Proc(NullBufferStorage) },
+        { "glNamedBufferSubData", Proc(NullNamedBufferSubData) },
+        { "glBufferSubData", Proc(NullBufferSubData) },
+        { "glMapNamedBufferRange", Proc(NullMapNamedBufferRange) },
+        { "glMapBufferRange", Proc(NullMapBufferRange) },
+        { "glMapNamedBuffer", Proc(NullMapNamedBuffer) },
+        { "glMapBuffer", Proc(NullMapBuffer) },
+
+        { "glTexImage2D", Proc(NullTexImage2D) },
+        { "glTexSubImage2D", Proc(NullTexSubImage2D) },
+        { "glTextureSubImage2D", Proc(NullTextureSubImage2D) },
+        { "glTexImage3D", Proc(NullTexImage3D) },
+        { "glTexSubImage3D", Proc(NullTexSubImage3D) },
+        { "glTextureSubImage3D", Proc(NullTextureSubImage3D) },
+        { "glCompressedTexImage2D", Proc(NullCompressedTexImage2D) },
+        { "glCompressedTextureSubImage2D", Proc(NullCompressedTextureSubImage2D) },
+
+        { "glDrawArrays", Proc(NullDrawArrays) },
+        { "glDrawElements", Proc(NullDrawElements) },
+        { "glDrawElementsBaseVertex", Proc(NullDrawElementsBaseVertex) },
+        { "glDrawArraysInstanced", Proc(NullDrawArraysInstanced) },
+        { "glDrawArraysInstancedBaseInstance", Proc(NullDrawArraysInstancedBaseInstance) },
+        { "glDrawElementsInstanced", Proc(NullDrawElementsInstanced) },
+        { "glDrawElementsInstancedBaseInstance", Proc(NullDrawElementsInstancedBaseInstance) },
+        { "glDrawElementsInstancedBaseVertexBaseInstance", Proc(NullDrawElementsInstancedBaseVertexBaseInstance) },
+        { "glMultiDrawArraysIndirect", Proc(NullMultiDrawArraysIndirect) },
+        { "glMultiDrawElementsIndirect", Proc(NullMultiDrawElementsIndirect) },
+
+        NULL_STATE_CHANGE(glUseProgram),
+        NULL_STATE_CHANGE(glBindVertexArray),
+        NULL_STATE_CHANGE(glBindBufferBase),
+        NULL_STATE_CHANGE(glBindBufferRange),
+        NULL_STATE_CHANGE(glBindVertexBuffer),
+        NULL_STATE_CHANGE(glVertexArrayVertexBuffer),
+        NULL_STATE_CHANGE(glBindTexture),
+        NULL_STATE_CHANGE(glBindTextureUnit),
+        NULL_STATE_CHANGE(glBindTextures),
+        NULL_STATE_CHANGE(glBindSampler),
+        NULL_STATE_CHANGE(glActiveTexture),
+        NULL_STATE_CHANGE(glBindFramebuffer),
+        NULL_STATE_CHANGE(glEnable),
+        NULL_STATE_CHANGE(glDisable),
+        NULL_STATE_CHANGE(glBlendFunc),
+        NULL_STATE_CHANGE(glViewport),
+        NULL_STATE_CHANGE(glScissor),
+        NULL_STATE_CHANGE(glDepthMask),
+        NULL_STATE_CHANGE(glPixelStorei),
+
+        NULL_UNIFORM(glUniform1i),
+        NULL_UNIFORM(glUniform1f),
+        NULL_UNIFORM(glUniform1fv),
+        NULL_UNIFORM(glUniform2fv),
+        NULL_UNIFORM(glUniform3fv),
+        NULL_UNIFORM(glUniform4fv),
+        NULL_UNIFORM(glUniformMatrix4fv),
+        NULL_UNIFORM(glProgramUniform1i),
+        NULL_UNIFORM(glProgramUniform1iv),
+        NULL_UNIFORM(glProgramUniform1f),
+        NULL_UNIFORM(glProgramUniform4fv),
+        NULL_UNIFORM(glProgramUniformMatrix4fv),
+
+        NULL_NOOP(glGetError),
+        NULL_NOOP(glGetFloatv),
+        NULL_NOOP(glGetProgramResourceName),
+        NULL_NOOP(glGetProgramResourceiv),
+        NULL_NOOP(glGetProgramBinary),
+        NULL_NOOP(glProgramBinary),
+        NULL_NOOP(glProgramParameteri),
+        NULL_NOOP(glShaderSource),
+        NULL_NOOP(glCompileShader),
+        NULL_NOOP(glAttachShader),
+        NULL_NOOP(glLinkProgram),
+        NULL_NOOP(glDeleteShader),
+        NULL_NOOP(glUniformBlockBinding),
+        NULL_NOOP(glDeleteTextures),
+        NULL_NOOP(glDeleteVertexArrays),
+        NULL_NOOP(glDeleteSamplers),
+        NULL_NOOP(glDeleteQueries),
+        NULL_NOOP(glDeleteFramebuffers),
+        NULL_NOOP(glDeleteSync),
+        NULL_NOOP(glUnmapNamedBuffer),
+        NULL_NOOP(glUnmapBuffer),
+        NULL_NOOP(glTextureStorage2D),
+        NULL_NOOP(glTextureStorage3D),
+        NULL_NOOP(glTextureParameteri),
+        NULL_NOOP(glTextureParameterf),
+        NULL_NOOP(glGenerateTextureMipmap),
+        NULL_NOOP(glClearTexImage),
+        NULL_NOOP(glCopyImageSubData),
+        NULL_NOOP(glSamplerParameteri),
+        NULL_NOOP(glSamplerParameterf),
+        NULL_NOOP(glEnableVertexAttribArray),
+        NULL_NOOP(glVertexAttribPointer),
+        NULL_NOOP(glVertexAttribFormat),
+        NULL_NOOP(glVertexAttribIFormat),
+        NULL_NOOP(glVertexAttribBinding),
+        NULL_NOOP(glVertexBindingDivisor),
+        NULL_NOOP(glQueryCounter),
+        NULL_NOOP(glClear),
+        NULL_NOOP(glClearColor),
+        NULL_NOOP(glFlush),
+        NULL_NOOP(glFinish),
+    };
+
+    // Entry points the engine does not use stay null: a stub with a guessed signature would
+    // unbalance the stack on __stdcall builds, a null pointer at least fails where it is called
+    auto it = procs.find(name);
+    return (it != procs.end()) ? it->second : nullptr;
+}
+
+bool LoadNullGL()
+{
+    // Object names are never reused, so state left by a previous load can stay
+    ResetNullGLStats();
+    return gladLoadGL(NullGetProcAddress) != 0;
+}
+
+const GLCallStats& GetNullGLStats()
+{
+    return stats;
+}
+
+void ResetNullGLStats()
+{
+    stats = {};
+}
@@ -0,0 +1,135 @@
+#include "Core/PersistentRingBuffer.h"
+#include <cassert>
+#include <stdexcept>
+#include <iostream>
+
+PersistentRingBuffer::PersistentRingBuffer(size_t slotSize, unsigned int slotCount) : slotSize(slotSize), slotCount(slotCount)
+{
+    fences.resize(slotCount, nullptr);
+    CreateStorage();
+}
+
+PersistentRingBuffer::~PersistentRingBuffer()
+{
+    DestroyStorage();
+}
+
+void PersistentRingBuffer::BeginFrame()
+{
+    WaitForSlot(currentSlot);
+    slotHead = 0;
+}
+
+void PersistentRingBuffer::EndFrame()
+{
+    fences[currentSlot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    currentSlot = (currentSlot + 1) % slotCount;
+}
+
+void* PersistentRingBuffer::Allocate(size_t size, size_t alignment, size_t& offset)
+{
+    // The alignment does not need to be a power of two, instance strides usually are not.
+    // It applies to the offset in the whole buffer, which is what glBindBufferRange and the
+    // base instance see: the slot size is not necessarily a multiple of it.
+    const size_t slotBase = currentSlot * slotSize;
+    size_t start = slotBase + slotHead;
+    if (alignment > 1)
+    {
+        start = ((start + alignment - 1) / alignment) * alignment;
+    }
+    start -= slotBase;
+    if (start + size > slotSize)
+    {
+        return nullptr;
+    }
+
+    slotHead = start + size;
+    offset = slotBase + start;
+    assert(alignment <= 1 || offset % alignment == 0);
+    return mapped + offset;
+}
+
+void PersistentRingBuffer::Reserve(size_t newSlotSize)
+{
+    if (newSlotSize <= slotSize)
+    {
+        return;
+    }
+
+    DestroyStorage();
+    slotSize = newSlotSize;
+    slotHead = 0;
+    CreateStorage();
+}
+
+unsigned int PersistentRingBuffer::GetID() const
+{
+    return id;
+}
+
+size_t PersistentRingBuffer::GetSlotSize() const
+{
+    return slotSize;
+}
+
+void PersistentRingBuffer::CreateStorage()
+{
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    const GLsizeiptr totalSize = static_cast<GLsizeiptr>(slotSize * slotCount);
+
+    glCreateBuffers(1, &id);
+    glNamedBufferStorage(id, totalSize, nullptr, flags);
+    mapped = static_cast<unsigned char*>(glMapNamedBufferRange(id, 0, totalSize, flags));
+    if (!mapped)
+    {
+        glDeleteBuffers(1, &id);
+        id = 0;
+        throw std::runtime_error("Failed to map persistent ring buffer.");
+    }
+}
+
+void PersistentRingBuffer::DestroyStorage()
+{
+    // The GPU may still be reading any of the slots
+    for (unsigned int slot = 0; slot < slotCount; ++slot)
+    {
+        WaitForSlot(slot);
+    }
+
+    if (id != 0)
+    {
+        glUnmapNamedBuffer(id);
+        glDeleteBuffers(1, &id);
+        id = 0;
+    }
+    mapped = nullptr;
+}
+
+void PersistentRingBuffer::WaitForSlot(unsigned int slot)
+{
+    GLsync fence = fences[slot];
+    if (!fence)
+    {
+        return;
+    }
+
+    // Flush on the first wait so the fence is guaranteed to signal eventually
+    GLbitfield waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    while (true)
+    {
+        GLenum result = glClientWaitSync(fence, waitFlags, 1000000);
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+        {
+            break;
+        }
+        if (result == GL_WAIT_FAILED)
+        {
+            std::cerr << "ERROR: glClientWaitSync failed on ring buffer slot " << slot << std::endl;
+            break;
+        }
+        waitFlags = 0;
+    }
+
+    glDeleteSync(fence);
+    fences[slot] = nullptr;
+}
@@ -0,0 +1,209 @@
+#include "Core/Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Zones kept per thread. 64K zones cover several seconds of a busy frame loop.
+static const uint64_t RING_CAPACITY = 1 << 16;
+static const uint64_t RING_MASK = RING_CAPACITY - 1;
+
+struct ProfileEvent
+{
+    alignas(std::atomic_ref<const char*>::required_alignment) const char* name;
+    alignas(std::atomic_ref<int64_t>::required_alignment) int64_t start;
+    alignas(std::atomic_ref<int64_t>::required_alignment) int64_t end;
+};
+
+// Single producer ring: only the owning thread writes, WriteChromeTrace reads 'written' to know
+// which slots are complete
+struct ThreadRing
+{
+    std::vector<ProfileEvent> events;
+    std::atomic<uint64_t> written = 0;
+    std::atomic<uint64_t> clearedUpTo = 0;  // zones before this index are hidden by Clear
+    uint32_t threadID = 0;
+    std::string threadName;
+    std::mutex nameMutex;
+};
+
+// Rings are never freed: zones of a thread that already exited still show up in the trace
+static std::mutex registryMutex;
+static std::vector<std::unique_ptr<ThreadRing>> registry;
+static thread_local ThreadRing* localRing = nullptr;
+
+static std::atomic<bool> enabled = true;
+static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+static ThreadRing* GetLocalRing()
+{
+    if (!localRing)
+    {
+        auto ring = std::make_unique<ThreadRing>();
+        ring->events.resize(RING_CAPACITY);
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+        ring->threadID = static_cast<uint32_t>(registry.size());
+        ring->threadName = "Thread " + std::to_string(ring->threadID);
+        localRing = ring.get();
+        registry.push_back(std::move(ring));
+    }
+    return localRing;
+}
+
+int64_t Profiler::Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Profiler::Record(const char* name, int64_t start, int64_t end)
+{
+    if (!enabled.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    ThreadRing* ring = GetLocalRing();
+    uint64_t index = ring->written.load(std::memory_order_relaxed);
+    // Relaxed atomic stores compile to plain moves, they only make the concurrent read in
+    // WriteChromeTrace well defined
+    ProfileEvent& event = ring->events[index & RING_MASK];
+    std::atomic_ref<const char*>(event.name).store(name, std::memory_order_relaxed);
+    std::atomic_ref<int64_t>(event.start).store(start, std::memory_order_relaxed);
+    std::atomic_ref<int64_t>(event.end).store(end, std::memory_order_relaxed);
+    ring->written.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::SetThreadName(const std::string& name)
+{
+    ThreadRing* ring = GetLocalRing();
+    std::lock_guard<std::mutex> lock(ring->nameMutex);
+    ring->threadName = name;
+}
+
+void Profiler::SetEnabled(bool value)
+{
+    enabled.store(value, std::memory_order_relaxed);
+}
+
+bool Profiler::IsEnabled()
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+static void WriteJsonString(std::ostream& out, const std::string& value)
+{
+    out << '"';
+    for (char c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out << '\\' << c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            out << ' ';
+        }
+        else
+        {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path)
+{
+    // Snapshot the rings first so the file I/O does not hold the registry lock
+    struct ThreadSnapshot
+    {
+        uint32_t threadID;
+        std::string threadName;
+        std::vector<ProfileEvent> events;
+    };
+    std::vector<ThreadSnapshot> snapshots;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const std::unique_ptr<ThreadRing>& ring : registry)
+        {
+            ThreadSnapshot snapshot;
+            snapshot.threadID = ring->threadID;
+            {
+                std::lock_guard<std::mutex> nameLock(ring->nameMutex);
+                snapshot.threadName = ring->threadName;
+            }
+
+            uint64_t end = ring->written.load(std::memory_order_acquire);
+            uint64_t begin = (end > RING_CAPACITY) ? end - RING_CAPACITY : 0;
+            begin = std::max(begin, std::min(ring->clearedUpTo.load(std::memory_order_relaxed), end));
+            for (uint64_t i = begin; i < end; ++i)
+            {
+                ProfileEvent& event = ring->events[i & RING_MASK];
+                snapshot.events.push_back({ std::atomic_ref<const char*>(event.name).load(std::memory_order_relaxed),
+                    std::atomic_ref<int64_t>(event.start).load(std::memory_order_relaxed),
+                    std::atomic_ref<int64_t>(event.end).load(std::memory_order_relaxed) });
+            }
+
+            // The owner kept writing during the copy: the oldest slots may hold newer zones now
+            uint64_t after = ring->written.load(std::memory_order_acquire);
+            uint64_t firstValid = (after > RING_CAPACITY) ? after - RING_CAPACITY : 0;
+            if (firstValid > begin)
+            {
+                size_t overwritten = static_cast<size_t>(std::min(firstValid - begin, end - begin));
+                snapshot.events.erase(snapshot.events.begin(), snapshot.events.begin() + overwritten);
+            }
+            snapshots.push_back(std::move(snapshot));
+        }
+    }
+
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        std::cerr << "ERROR: Failed to open profiler trace file: " << path << std::endl;
+        return false;
+    }
+
+    // Complete events ("ph":"X") with microsecond timestamps, nanoseconds kept as decimals
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    file << std::fixed << std::setprecision(3);
+    bool first = true;
+    for (const ThreadSnapshot& snapshot : snapshots)
+    {
+        file << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << snapshot.threadID << ",\"args\":{\"name\":";
+        WriteJsonString(file, snapshot.threadName);
+        file << "}}";
+        first = false;
+
+        for (const ProfileEvent& event : snapshot.events)
+        {
+            file << ",\n{\"name\":";
+            WriteJsonString(file, event.name);
+            file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << snapshot.threadID
+                << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+        }
+    }
+    file << "\n]}\n";
+
+    if (!file.good())
+    {
+        std::cerr << "ERROR: Failed to write profiler trace file: " << path << std::endl;
+        return false;
+    }
+    std::cout << "Profiler trace written to " << path << std::endl;
+    return true;
+}
+
+void Profiler::Clear()
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (const std::unique_ptr<ThreadRing>& ring : registry)
+    {
+        // Only the owner thread advances 'written', the old zones are just hidden
+        ring->clearedUpTo.store(ring->written.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
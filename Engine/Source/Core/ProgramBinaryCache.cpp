@@ -0,0 +1,162 @@
+#include "Core/ProgramBinaryCache.h"
+#include "Core/Profiler.h"
+#include "Core/Hash.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+static uint64_t HashString(uint64_t hash, const char* value)
+{
+    // The terminator separates consecutive strings: "ab" + "c" differs from "a" + "bc"
+    return value ? Hash64(value, std::strlen(value) + 1, hash) : Hash64("", 1, hash);
+}
+
+ProgramBinaryCache& ProgramBinaryCache::GetInstance()
+{
+    static ProgramBinaryCache instance;
+    return instance;
+}
+
+void ProgramBinaryCache::Initialize(const std::string& cacheDirectory)
+{
+    directory = cacheDirectory;
+
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    enabled = formats > 0;
+
+    driverHash = 0;
+    driverHash = HashString(driverHash, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+    driverHash = HashString(driverHash, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+    driverHash = HashString(driverHash, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+
+    std::cout << "Program binary cache: " << (enabled ? directory : "not supported by the driver") << std::endl;
+}
+
+bool ProgramBinaryCache::IsEnabled() const
+{
+    return enabled;
+}
+
+uint64_t ProgramBinaryCache::ComputeKey(uint64_t contentKey) const
+{
+    return Hash64(&contentKey, sizeof(contentKey), driverHash);
+}
+
+bool ProgramBinaryCache::Load(uint64_t key, GLuint program)
+{
+    if (!enabled)
+    {
+        return false;
+    }
+    PROFILE_ZONE("ProgramBinaryCache::Load");
+
+    const std::string path = GetEntryPath(key);
+    std::ifstream file(path, std::ios::binary);
+    ProgramBinaryHeader header = {};
+    if (!file.is_open() || !file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, PROGRAM_BINARY_MAGIC, sizeof(PROGRAM_BINARY_MAGIC)) != 0 ||
+        header.version != PROGRAM_BINARY_VERSION || header.key != key)
+    {
+        misses++;
+        return false;
+    }
+
+    std::vector<char> binary(header.size);
+    if (!file.read(binary.data(), static_cast<std::streamsize>(binary.size())))
+    {
+        misses++;
+        return false;
+    }
+    file.close();
+
+    glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        // The driver may reject binaries for reasons outside the key (e.g. a changed setting):
+        // the entry is dropped and written again after the program is compiled
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        misses++;
+        return false;
+    }
+    hits++;
+    return true;
+}
+
+void ProgramBinaryCache::Store(uint64_t key, GLuint program)
+{
+    if (!enabled)
+    {
+        return;
+    }
+    PROFILE_ZONE("ProgramBinaryCache::Store");
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+
+    std::vector<char> binary(static_cast<size_t>(length));
+    GLenum format = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0)
+    {
+        return;
+    }
+
+    ProgramBinaryHeader header = {};
+    std::memcpy(header.magic, PROGRAM_BINARY_MAGIC, sizeof(PROGRAM_BINARY_MAGIC));
+    header.version = PROGRAM_BINARY_VERSION;
+    header.key = key;
+    header.format = format;
+    header.size = static_cast<uint32_t>(written);
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    // Written aside and renamed, so a crash never leaves a truncated entry behind
+    const std::string path = GetEntryPath(key);
+    const std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), written);
+        if (!file)
+        {
+            std::cerr << "WARNING: Failed to write program binary: " << temporaryPath << std::endl;
+            return;
+        }
+    }
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error)
+    {
+        std::cerr << "WARNING: Failed to write program binary: " << path << " (" << error.message() << ")" << std::endl;
+        std::filesystem::remove(temporaryPath, error);
+    }
+}
+
+uint64_t ProgramBinaryCache::GetHitCount() const
+{
+    return hits;
+}
+
+uint64_t ProgramBinaryCache::GetMissCount() const
+{
+    return misses;
+}
+
+std::string ProgramBinaryCache::GetEntryPath(uint64_t key) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(directory) / name).string();
+}
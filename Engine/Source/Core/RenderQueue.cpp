@@ -0,0 +1,170 @@
+#include "Core/RenderQueue.h"
+#include "Core/Assets/Material.h"
+#include "Core/GLStateCache.h"
+#include "Core/GpuTimer.h"
+#include "Core/Profiler.h"
+#include <iostream>
+
+// Depth occupies the low bits of the key
+static const uint32_t DEPTH_MASK = (1u << 24) - 1;
+
+uint64_t RenderQueue::MakeSortKey(uint8_t layer, uint16_t shader, uint16_t textureSet, uint32_t depth)
+{
+    return (static_cast<uint64_t>(layer) << 56)
+        | (static_cast<uint64_t>(shader) << 40)
+        | (static_cast<uint64_t>(textureSet) << 24)
+        | static_cast<uint64_t>(depth & DEPTH_MASK);
+}
+
+void RenderQueue::Submit(const DrawCommand& command)
+{
+    if (!command.material || !command.material->GetShader())
+    {
+        std::cerr << "ERROR: Cannot submit a draw without a material and a shader." << std::endl;
+        return;
+    }
+
+    entries.push_back({ command.sortKey, static_cast<uint32_t>(commands.size()) });
+    commands.push_back(command);
+}
+
+void RenderQueue::SortEntries()
+{
+    scratch.resize(entries.size());
+    for (unsigned int shift = 0; shift < 64; shift += 8)
+    {
+        size_t counts[256] = {};
+        for (const SortEntry& entry : entries)
+        {
+            counts[(entry.key >> shift) & 0xFF]++;
+        }
+
+        // Every key has the same byte here: the pass would not move anything. With few
+        // layers and shaders most of the eight passes end up skipped.
+        if (counts[(entries[0].key >> shift) & 0xFF] == entries.size())
+        {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (size_t& count : counts)
+        {
+            size_t bucketSize = count;
+            count = offset;
+            offset += bucketSize;
+        }
+        for (const SortEntry& entry : entries)
+        {
+            scratch[counts[(entry.key >> shift) & 0xFF]++] = entry;
+        }
+        entries.swap(scratch);
+    }
+}
+
+// Binds 'range' unless it is the range already bound at 'binding' during this flush
+static void BindStorageRange(GLuint binding, const StorageRange& range, StorageRange& current)
+{
+    if (range.buffer == 0 || (range.buffer == current.buffer && range.offset == current.offset && range.size == current.size))
+    {
+        return;
+    }
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, range.buffer, range.offset, range.size);
+    current = range;
+}
+
+void RenderQueue::Flush(GpuTimer* gpuTimer)
+{
+    PROFILE_ZONE("RenderQueue::Flush");
+
+    GLStateCache& cache = GLStateCache::GetInstance();
+    uint64_t issuedBefore = cache.GetIssuedCount();
+    uint64_t elidedBefore = cache.GetElidedCount();
+
+    lastStats = RenderQueueStats();
+    lastStats.commands = commands.size();
+    if (commands.empty())
+    {
+        return;
+    }
+
+    SortEntries();
+
+    const Material* currentMaterial = nullptr;
+    GLuint currentIndirectBuffer = 0;
+    StorageRange currentTable;
+    StorageRange currentDrawMaterials;
+    for (const SortEntry& entry : entries)
+    {
+        const DrawCommand& command = commands[entry.index];
+        unsigned int scope = (gpuTimer && command.gpuScope) ? gpuTimer->BeginScope(command.gpuScope, command.gpuScopeId) : GpuTimer::INVALID_SCOPE;
+
+        // Same material as the previous draw: program, textures and parameters are already set
+        if (command.material != currentMaterial)
+        {
+            command.material->Use();
+            currentMaterial = command.material;
+            lastStats.materialChanges++;
+        }
+        else
+        {
+            lastStats.materialChangesSaved++;
+        }
+
+        if (command.hasModel)
+        {
+            const Shader& shader = *command.material->GetShader();
+            shader.SetMat4(shader.GetModelHandle(), command.model);
+        }
+
+        cache.BindVertexArray(command.vertexArray);
+        if (command.drawCount > 0)
+        {
+            // Buffers and ranges only change between shader groups
+            if (command.indirectBuffer != currentIndirectBuffer)
+            {
+                glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command.indirectBuffer);
+                currentIndirectBuffer = command.indirectBuffer;
+            }
+            BindStorageRange(MATERIAL_TABLE_BINDING, command.materialTable, currentTable);
+            BindStorageRange(DRAW_MATERIALS_BINDING, command.drawMaterials, currentDrawMaterials);
+
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<const void*>(command.indirectOffset),
+                command.drawCount, 0);
+            lastStats.draws += static_cast<size_t>(command.drawCount);
+        }
+        else if (command.instanceCount == 1 && command.baseInstance == 0)
+        {
+            glDrawElements(GL_TRIANGLES, command.indexCount, GL_UNSIGNED_INT, 0);
+        }
+        else
+        {
+            glDrawElementsInstancedBaseInstance(GL_TRIANGLES, command.indexCount, GL_UNSIGNED_INT, 0,
+                command.instanceCount, command.baseInstance);
+        }
+        if (command.drawCount == 0)
+        {
+            lastStats.draws++;
+        }
+
+        if (gpuTimer)
+        {
+            gpuTimer->EndScope(scope);
+        }
+    }
+
+    commands.clear();
+    entries.clear();
+
+    lastStats.stateChanges = cache.GetIssuedCount() - issuedBefore;
+    lastStats.stateChangesSaved = cache.GetElidedCount() - elidedBefore;
+}
+
+size_t RenderQueue::GetPendingCount() const
+{
+    return commands.size();
+}
+
+const RenderQueueStats& RenderQueue::GetLastFlushStats() const
+{
+    return lastStats;
+}
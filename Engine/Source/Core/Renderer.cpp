@@ -1,9 +1,11 @@
 #include "Core/Renderer.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-#include <GLFW/glfw3.h>
 #include <map>
 #include "Core/AssetManager.h"
+#include "Core/Profiler.h"
+#include "Core/GLStateCache.h"
+#include "Core/TextureReferences.h"
 #include <iostream>
 
 const float WORLD_WIDTH = 800.0f;
@@ -12,10 +14,13 @@ const float WORLD_HEIGHT = 600.0f;
 Renderer::Renderer()
 {
     InitBuffers();
+
+    glCreateBuffers(1, &frameUBO);
+    glNamedBufferData(frameUBO, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
     /*std::map<unsigned int, std::string> shaderPaths;
-    shaderPaths[GL_VERTEX_SHADER] = "Resources/Assets/Shaders/Basic/Textured.vert";
-    shaderPaths[GL_FRAGMENT_SHADER] = "Resources/Assets/Shaders/Basic/Textured.frag";
-    testShader = AssetManager::GetInstance().GetShader("test_shader", shaderPaths);
+    shaderPaths[GL_VERTEX_SHADER] = "Resources/Assets/Shaders/Basic/Quad.vert";
+    shaderPaths[GL_FRAGMENT_SHADER] = "Resources/Assets/Shaders/Basic/Quad.frag";
+    testShader = AssetManager::GetInstance().GetShader("test_shader", shaderPaths, { "TEXTURED" });
 
     testTexture = AssetManager::GetInstance().GetTexture("simple_texture", "Resources/Assets/Textures/sampleTexture.png", TextureFilter::PIXEL_PERFECT);*/
 }
@@ -25,18 +30,58 @@ Renderer::~Renderer()
     glDeleteVertexArrays(1, &quadVAO);
     glDeleteBuffers(1, &quadVBO);
     glDeleteBuffers(1, &EBO);
+    glDeleteBuffers(1, &frameUBO);
+}
+
+void Renderer::BeginFrame(float time, int width, int height)
+{
+    gpuTimer.BeginFrame();
+
+    // Gli oggetti distrutti o collegati fuori dalla cache tra due frame la renderebbero inaffidabile
+    GLStateCache::GetInstance().Invalidate();
+
+    // L'origine (0,0)  in basso a sinistra, le coordinate vanno in pixel fino a (width, height)
+    FrameData frameData = {};
+    frameData.projection = glm::ortho(0.0f, static_cast<float>(width), 0.0f, static_cast<float>(height));
+    frameData.time = time;
+
+    glNamedBufferSubData(frameUBO, 0, sizeof(FrameData), &frameData);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, frameUBO);
+}
+
+void Renderer::EndFrame()
+{
+    {
+        GpuZone queueZone(gpuTimer, "RenderQueue");
+        // Le array possono essere cresciute durante il frame, mentre i materiali risolvevano le texture
+        TextureReferences::GetInstance().BindArrays();
+        renderQueue.Flush(&gpuTimer);
+    }
+    gpuTimer.EndFrame();
+}
+
+void Renderer::Submit(const DrawCommand& command)
+{
+    renderQueue.Submit(command);
+}
+
+const RenderQueueStats& Renderer::GetRenderQueueStats() const
+{
+    return renderQueue.GetLastFlushStats();
 }
 
 void Renderer::DrawSingleColoredQuad(const std::shared_ptr<MaterialAsset>& materialAsset, const glm::vec2& position, float scale)
 {
+    PROFILE_ZONE("Renderer::DrawSingleColoredQuad");
+
     if (!materialAsset)
     {
         std::cerr << "ERROR: Cannot draw with a null MaterialAsset." << std::endl;
         return;
     }
 
-    // Crea l'istanza Material "al volo" basata sull'asset
-    std::shared_ptr<Material> material = AssetManager::GetInstance().CreateMaterialFromAsset(materialAsset);
+    // Recupera il Material in cache per l'asset: viene ricostruito solo se l'asset cambia
+    std::shared_ptr<Material> material = AssetManager::GetInstance().GetMaterial(materialAsset);
 
     if (!material)
     {
@@ -44,30 +89,26 @@ void Renderer::DrawSingleColoredQuad(const std::shared_ptr<MaterialAsset>& mater
         return;
     }
 
-    int width, height;
-    glfwGetFramebufferSize(glfwGetCurrentContext(), &width, &height);
-
-    float aspectRatio = static_cast<float>(width) / height;
-
-    // 1. Calculate orthographic projection matrix
-    // L'origine (0,0) sar in basso a sinistra e le coordinate del mondo andranno fino a (WORLD_WIDTH, WORLD_HEIGHT).
-    glm::mat4 projection = glm::ortho(0.0f, static_cast<float>(width), 0.0f, static_cast<float>(height));
-
-    // 2. Calculate model matrix
+    // 1. Calculate model matrix (projection and time come from the FrameData block)
     glm::mat4 model = glm::mat4(1.0f);
     model = glm::translate(model, glm::vec3(position.x, position.y, 0.0f));
     model = glm::scale(model, glm::vec3(scale, scale, 1.0f));
 
-    material->SetMat4("projection", projection);
-    material->SetMat4("model", model);
-    material->SetFloat("time", (float)glfwGetTime());
-
-    material->Use();
+    // 2. Accoda il quadrato: materiale e VAO vengono applicati da RenderQueue::Flush.
+    // La matrice model e' per draw, quindi resta un uniform semplice.
+    DrawCommand command;
+    command.sortKey = RenderQueue::MakeSortKey(OVERLAY_LAYER, static_cast<uint16_t>(material->GetShader()->GetID()), material->GetTextureSetKey(), 0);
+    command.material = material.get();
+    command.vertexArray = quadVAO;
+    command.indexCount = 6;
+    command.hasModel = true;
+    command.model = model;
+    renderQueue.Submit(command);
+}
 
-    // 4. Disegna il quadrato
-    glBindVertexArray(quadVAO);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0); // Sconnetti il VAO per evitare modifiche accidentali
+GpuTimer& Renderer::GetGpuTimer()
+{
+    return gpuTimer;
 }
 
 void Renderer::InitBuffers()
@@ -1,96 +1,430 @@
 #include "Core/Rendering.h"
 #include "Core/AssetManager.h"
-#include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
+#include "Core/PersistentRingBuffer.h"
+#include "Core/SpriteTransform.h"
+#include "Core/Profiler.h"
+#include <iostream>
+#include <cstddef>
+#include <algorithm>
+#include <cstring>
 
 // VBO e VAO globali per il rendering instanced
-static unsigned int quadVAO, quadVBO;
-static unsigned int instanceVBO;
-
-// Mappa per il batching
-static std::map<unsigned int, std::vector<glm::mat4>> batches;
-
-// Shader source (estremamente semplificato)
-const char* vertexShaderSource = "#version 330 core\n"
-"layout (location = 0) in vec2 aPos;\n"
-"layout (location = 1) in vec4 aColor;\n"
-"layout (location = 2) in mat4 aModel;\n"
-"void main()\n"
-"{\n"
-"   gl_Position = aModel * vec4(aPos, 0.0, 1.0);\n"
-"}\0";
+static unsigned int quadVAO, quadVBO, quadEBO;
+
+// Binding dei vertex buffer nel VAO: 0 per il quad, 1 per i dati per istanza
+static const unsigned int QUAD_BINDING = 0;
+static const unsigned int INSTANCE_BINDING = 1;
+
+// Ring buffer persistente per i dati instanced: uno slot per frame in volo
+static const size_t INITIAL_INSTANCE_CAPACITY = 16384;
+static PersistentRingBuffer* instanceRing = nullptr;
+
+// Ring persistente per i comandi indiretti, le MaterialTable e gli indici dei materiali per draw
+static const size_t INITIAL_DRAW_DATA_CAPACITY = 64 * 1024;
+static PersistentRingBuffer* drawDataRing = nullptr;
+static bool drawDataSlotInUse = false;
+static size_t storageAlignment = 256;
+
+// Batch che condividono shader e texture: vengono disegnati con un solo glMultiDrawElementsIndirect,
+// ogni draw legge i parametri del proprio materiale dalla MaterialTable tramite gl_DrawID
+struct IndirectGroup
+{
+    const Material* material = nullptr;     // primo materiale del gruppo, applicato con Use()
+    std::vector<DrawElementsIndirectCommand> draws;
+    std::vector<uint32_t> drawMaterials;    // indice in 'materials' per ogni draw
+    std::vector<const Material*> materials;
+};
+static std::vector<IndirectGroup> indirectGroups;
+static size_t indirectGroupCount = 0;
+
+// Renderer che riceve le draw dei batch nella sua RenderQueue
+static Renderer* spriteRenderer = nullptr;
+// Vero se lo slot corrente del ring e' in uso e va chiuso con EndRenderingSystemFrame
+static bool instanceSlotInUse = false;
+
+// Colonne di Flecs raccolte durante l'iterazione. Restano valide per tutta la durata del
+// sistema perche' il mondo e' in modalita' deferred e le tabelle non vengono spostate.
+struct SpriteChunk
+{
+    const Position* p;
+    const Rotation* r;
+    const Scale* s;
+    const SpriteRef* spr;
+    const MaterialRef* mat;
+    size_t count;
+};
+static std::vector<SpriteChunk> chunks;
+
+// Un batch per ogni MaterialRef: numero di istanze e prima istanza nello slot del frame
+struct MaterialBatch
+{
+    size_t count = 0;
+    size_t first = 0;
+    size_t cursor = 0;
+};
+static std::map<unsigned int, MaterialBatch> batches;
+
+// Tabella dei rettangoli UV degli sprite, letta dal vertex shader tramite SSBO
+static const unsigned int SPRITE_RECTS_BINDING = 0;
+static std::vector<glm::vec4> spriteRects;
+static unsigned int spriteRectsSSBO;
+static bool spriteRectsDirty = true;
 
 // Funzione di inizializzazione per il quad e i buffer per l'instancing
-void InitRenderingSystem()
+void InitRenderingSystem(Renderer& renderer)
 {
-    // Definizione dei vertici del quad
+    spriteRenderer = &renderer;
+
+    // Stesso layout del quad di Renderer, cosi' gli shader dei materiali restano compatibili
     float quadVertices[] = {
-        // pos      // texcoords
-        -0.5f,  0.5f, 0.0f, 1.0f,
-         0.5f,  0.5f, 1.0f, 1.0f,
-         0.5f, -0.5f, 1.0f, 0.0f,
-        -0.5f, -0.5f, 0.0f, 0.0f
+        // positions         // texture coords
+         0.5f,  0.5f, 0.0f,  1.0f, 1.0f, // top right (0)
+         0.5f, -0.5f, 0.0f,  1.0f, 0.0f, // bottom right (1)
+        -0.5f,  0.5f, 0.0f,  0.0f, 1.0f, // top left (2)
+        -0.5f, -0.5f, 0.0f,  0.0f, 0.0f  // bottom left (3)
+    };
+
+    unsigned int indices[] = {
+        0, 1, 2,
+        1, 3, 2
     };
 
     // Configurazione VAO e VBO per il quad
     glGenVertexArrays(1, &quadVAO);
     glGenBuffers(1, &quadVBO);
+    glGenBuffers(1, &quadEBO);
     glBindVertexArray(quadVAO);
+
     glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
 
-    // Attributi dei vertici
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadEBO);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+    // Attributi dei vertici. Si usa il formato separato dal buffer, cosi' il buffer delle istanze
+    // puo' essere riagganciato ad ogni frame su un offset diverso del ring buffer.
+    glBindVertexBuffer(QUAD_BINDING, quadVBO, 0, 5 * sizeof(float));
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexAttribBinding(0, QUAD_BINDING);
     glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
-
-    // VBO per i dati instanced
-    glGenBuffers(1, &instanceVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-    // Verr riempito ogni frame, non ha bisogno di dati iniziali
+    glVertexAttribFormat(1, 2, GL_FLOAT, GL_FALSE, 3 * sizeof(float));
+    glVertexAttribBinding(1, QUAD_BINDING);
 
-    // Attributi per la matrice di trasformazione (divisori a 1 per instancing)
+    // Attributi per istanza (vedi InstancedData e Sprite.vert)
     glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)0);
-    glVertexAttribDivisor(2, 1);
+    glVertexAttribFormat(2, 2, GL_FLOAT, GL_FALSE, static_cast<GLuint>(offsetof(InstancedData, position)));
+    glEnableVertexAttribArray(3);
+    glVertexAttribFormat(3, 2, GL_HALF_FLOAT, GL_FALSE, static_cast<GLuint>(offsetof(InstancedData, scale)));
+    glEnableVertexAttribArray(4);
+    glVertexAttribFormat(4, 1, GL_FLOAT, GL_FALSE, static_cast<GLuint>(offsetof(InstancedData, rotation)));
+    glEnableVertexAttribArray(5);
+    glVertexAttribIFormat(5, 1, GL_UNSIGNED_INT, static_cast<GLuint>(offsetof(InstancedData, spriteIndex)));
+    glEnableVertexAttribArray(6);
+    glVertexAttribFormat(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, static_cast<GLuint>(offsetof(InstancedData, tint)));
+
+    for (unsigned int location = 2; location <= 6; ++location)
+    {
+        glVertexAttribBinding(location, INSTANCE_BINDING);
+    }
+    glVertexBindingDivisor(INSTANCE_BINDING, 1);
 
-    // ... e cos via per gli altri 3 vettori della matrice
     glBindVertexArray(0);
+
+    instanceRing = new PersistentRingBuffer(INITIAL_INSTANCE_CAPACITY * sizeof(InstancedData));
+    drawDataRing = new PersistentRingBuffer(INITIAL_DRAW_DATA_CAPACITY);
+
+    GLint alignment = 0;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    storageAlignment = (alignment > 0) ? static_cast<size_t>(alignment) : 256;
+
+    glCreateBuffers(1, &spriteRectsSSBO);
+    if (spriteRects.empty())
+    {
+        spriteRects.push_back(glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+    }
+    spriteRectsDirty = true;
+}
+
+unsigned int RegisterSprite(const glm::vec4& uvRect)
+{
+    if (spriteRects.empty())
+    {
+        spriteRects.push_back(glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+    }
+    spriteRects.push_back(uvRect);
+    spriteRectsDirty = true;
+    return static_cast<unsigned int>(spriteRects.size() - 1);
+}
+
+void ShutdownRenderingSystem()
+{
+    delete instanceRing;
+    instanceRing = nullptr;
+    instanceSlotInUse = false;
+    delete drawDataRing;
+    drawDataRing = nullptr;
+    drawDataSlotInUse = false;
+    indirectGroups.clear();
+    indirectGroupCount = 0;
+    spriteRenderer = nullptr;
+
+    glDeleteVertexArrays(1, &quadVAO);
+    glDeleteBuffers(1, &quadVBO);
+    glDeleteBuffers(1, &quadEBO);
+    glDeleteBuffers(1, &spriteRectsSSBO);
+    chunks.clear();
+    batches.clear();
+}
+
+static void AddToIndirectGroup(const Material* material, const MaterialBatch& batch)
+{
+    IndirectGroup* group = nullptr;
+    for (size_t i = 0; i < indirectGroupCount; ++i)
+    {
+        const Material* first = indirectGroups[i].material;
+        if (first->GetShader() == material->GetShader() && first->SharesTexturesWith(*material))
+        {
+            group = &indirectGroups[i];
+            break;
+        }
+    }
+
+    // I gruppi restano allocati tra un frame e l'altro, cosi' i vettori non vengono riallocati
+    if (!group)
+    {
+        if (indirectGroupCount == indirectGroups.size())
+        {
+            indirectGroups.emplace_back();
+        }
+        group = &indirectGroups[indirectGroupCount++];
+        group->material = material;
+    }
+
+    group->draws.push_back({ 6, static_cast<GLuint>(batch.count), 0, 0, static_cast<GLuint>(batch.first) });
+    group->drawMaterials.push_back(static_cast<uint32_t>(group->materials.size()));
+    group->materials.push_back(material);
+}
+
+// Copia comandi, tabelle e indici dei gruppi nel ring e accoda un comando indiretto per gruppo
+static void SubmitIndirectGroups()
+{
+    if (indirectGroupCount == 0)
+    {
+        return;
+    }
+
+    size_t requiredSize = 0;
+    for (size_t i = 0; i < indirectGroupCount; ++i)
+    {
+        const IndirectGroup& group = indirectGroups[i];
+        const size_t stride = static_cast<size_t>(group.material->GetShader()->GetMaterialBlockLayout().size);
+        requiredSize += group.draws.size() * sizeof(DrawElementsIndirectCommand) + group.materials.size() * stride
+            + group.drawMaterials.size() * sizeof(uint32_t) + 3 * storageAlignment;
+    }
+
+    drawDataRing->BeginFrame();
+    drawDataSlotInUse = true;
+    if (requiredSize > drawDataRing->GetSlotSize())
+    {
+        drawDataRing->Reserve(std::max(requiredSize, drawDataRing->GetSlotSize() * 2));
+    }
+
+    for (size_t i = 0; i < indirectGroupCount; ++i)
+    {
+        IndirectGroup& group = indirectGroups[i];
+        const Shader& shader = *group.material->GetShader();
+        const size_t stride = static_cast<size_t>(shader.GetMaterialBlockLayout().size);
+
+        size_t commandsOffset = 0;
+        void* commands = drawDataRing->Allocate(group.draws.size() * sizeof(DrawElementsIndirectCommand), sizeof(GLuint), commandsOffset);
+        std::memcpy(commands, group.draws.data(), group.draws.size() * sizeof(DrawElementsIndirectCommand));
+
+        // Una riga per materiale, nel layout std140 riportato dallo shader
+        size_t tableOffset = 0;
+        unsigned char* table = static_cast<unsigned char*>(drawDataRing->Allocate(group.materials.size() * stride, storageAlignment, tableOffset));
+        for (size_t m = 0; m < group.materials.size(); ++m)
+        {
+            const std::vector<unsigned char>& row = group.materials[m]->GetTableRow();
+            std::memcpy(table + m * stride, row.data(), std::min(row.size(), stride));
+        }
+
+        size_t drawMaterialsOffset = 0;
+        void* drawMaterials = drawDataRing->Allocate(group.drawMaterials.size() * sizeof(uint32_t), storageAlignment, drawMaterialsOffset);
+        std::memcpy(drawMaterials, group.drawMaterials.data(), group.drawMaterials.size() * sizeof(uint32_t));
+
+        DrawCommand command;
+        command.sortKey = RenderQueue::MakeSortKey(SPRITE_LAYER, static_cast<uint16_t>(shader.GetID()), group.material->GetTextureSetKey(), 0);
+        command.material = group.material;
+        command.vertexArray = quadVAO;
+        command.indexCount = 6;
+        command.indirectBuffer = drawDataRing->GetID();
+        command.indirectOffset = static_cast<GLintptr>(commandsOffset);
+        command.drawCount = static_cast<GLsizei>(group.draws.size());
+        command.materialTable = { drawDataRing->GetID(), static_cast<GLintptr>(tableOffset), static_cast<GLsizeiptr>(group.materials.size() * stride) };
+        command.drawMaterials = { drawDataRing->GetID(), static_cast<GLintptr>(drawMaterialsOffset), static_cast<GLsizeiptr>(group.drawMaterials.size() * sizeof(uint32_t)) };
+        command.gpuScope = "SpriteIndirect";
+        command.gpuScopeId = static_cast<int>(shader.GetID());
+        spriteRenderer->Submit(command);
+
+        group.material = nullptr;
+        group.draws.clear();
+        group.drawMaterials.clear();
+        group.materials.clear();
+    }
+    indirectGroupCount = 0;
 }
 
 // Il sistema di rendering di Flecs
-void RenderingSystem(flecs::iter& it, Position* p, Rotation* r, Scale* s, SpriteRef* spr, MaterialRef* mat)
+void RenderingSystem(flecs::iter& it)
 {
-    // 1. Raccogli i dati e li raggruppa per materiale
-    for (int i = 0; i < it.count(); ++i)
+    PROFILE_ZONE("RenderingSystem");
+
+    // 1. Raccogli le colonne e conta le istanze per materiale
+    size_t totalInstances = 0;
+    while (it.next())
     {
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(p[i].x, p[i].y, 0.0f));
-        model = glm::rotate(model, glm::radians(r[i].value), glm::vec3(0.0f, 0.0f, 1.0f));
-        model = glm::scale(model, glm::vec3(s[i].x, s[i].y, 1.0f));
-        batches[mat[i].materialID].push_back(model);
+        size_t count = it.count();
+        if (count == 0)
+        {
+            continue;
+        }
+
+        auto p = it.field<const Position>(0);
+        auto r = it.field<const Rotation>(1);
+        auto s = it.field<const Scale>(2);
+        auto spr = it.field<const SpriteRef>(3);
+        auto mat = it.field<const MaterialRef>(4);
+
+        chunks.push_back({ &p[0], &r[0], &s[0], &spr[0], &mat[0], count });
+        for (size_t i = 0; i < count; ++i)
+        {
+            batches[mat[i].materialID].count++;
+        }
+        totalInstances += count;
     }
 
-    // 2. Disegna i batch
-    for (auto const& [materialID, models] : batches)
+    if (totalInstances == 0)
     {
-        if (models.empty()) continue;
+        chunks.clear();
+        return;
+    }
+
+    // 2. Riserva nello slot del frame corrente un intervallo contiguo per ogni materiale
+    instanceRing->BeginFrame();
+    instanceSlotInUse = true;
 
-        // Attiva lo shader e la texture del materiale
-        Shader* shader = AssetManager::GetShader(materialID);
-        shader->use();
+    size_t requiredSize = totalInstances * sizeof(InstancedData);
+    if (requiredSize > instanceRing->GetSlotSize())
+    {
+        instanceRing->Reserve(std::max(requiredSize, instanceRing->GetSlotSize() * 2));
+    }
 
-        // Collega i dati delle trasformazioni
-        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-        glBufferData(GL_ARRAY_BUFFER, models.size() * sizeof(glm::mat4), models.data(), GL_DYNAMIC_DRAW);
+    size_t ringOffset = 0;
+    InstancedData* instances = static_cast<InstancedData*>(instanceRing->Allocate(requiredSize, sizeof(InstancedData), ringOffset));
 
-        // Draw call instanced
-        glBindVertexArray(quadVAO);
-        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, models.size());
-        glBindVertexArray(0);
+    size_t first = 0;
+    for (auto& [materialID, batch] : batches)
+    {
+        batch.first = first;
+        batch.cursor = first;
+        first += batch.count;
     }
 
-    // 3. Pulisci i batch per il prossimo frame
-    batches.clear();
-}
\ No newline at end of file
+    // 3. Scrivi i dati compatti direttamente nella memoria mappata, senza copie intermedie.
+    // Ogni sequenza di sprite con lo stesso materiale e' contigua sia nelle colonne di Flecs
+    // sia nel batch di destinazione, quindi viene convertita in blocco dal kernel SIMD.
+    const uint32_t spriteCount = static_cast<uint32_t>(spriteRects.size());
+    for (const SpriteChunk& chunk : chunks)
+    {
+        size_t runStart = 0;
+        while (runStart < chunk.count)
+        {
+            unsigned int materialID = chunk.mat[runStart].materialID;
+            size_t runEnd = runStart + 1;
+            while (runEnd < chunk.count && chunk.mat[runEnd].materialID == materialID)
+            {
+                ++runEnd;
+            }
+
+            MaterialBatch& batch = batches[materialID];
+            size_t runLength = runEnd - runStart;
+            PackSpriteInstances(chunk.p + runStart, chunk.r + runStart, chunk.s + runStart, chunk.spr + runStart,
+                runLength, spriteCount, DEFAULT_SPRITE_TINT, instances + batch.cursor);
+            batch.cursor += runLength;
+
+            runStart = runEnd;
+        }
+    }
+    chunks.clear();
+
+    if (spriteRectsDirty)
+    {
+        glNamedBufferData(spriteRectsSSBO, spriteRects.size() * sizeof(glm::vec4), spriteRects.data(), GL_STATIC_DRAW);
+        spriteRectsDirty = false;
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, SPRITE_RECTS_BINDING, spriteRectsSSBO);
+
+    // 4. Accoda i batch: una draw call instanced per materiale, eseguita da Renderer::EndFrame.
+    // Il buffer delle istanze viene agganciato al VAO con DSA, senza toccare il VAO attivo.
+    PROFILE_ZONE("RenderingSystem::Submit");
+    glVertexArrayVertexBuffer(quadVAO, INSTANCE_BINDING, instanceRing->GetID(), static_cast<GLintptr>(ringOffset), sizeof(InstancedData));
+
+    for (auto& [materialID, batch] : batches)
+    {
+        if (batch.count == 0)
+        {
+            continue;
+        }
+
+        // Attiva lo shader e le texture del materiale
+        std::shared_ptr<Material> material = AssetManager::GetInstance().GetMaterial(materialID);
+        if (!material)
+        {
+            std::cerr << "ERROR: No material registered with ID " << materialID << ", skipping " << batch.count << " sprites." << std::endl;
+            batch.count = 0;
+            continue;
+        }
+
+        // Shader a tabella: il batch diventa un comando indiretto del gruppo con stesso shader e texture
+        if (material->GetShader()->UsesMaterialTable())
+        {
+            AddToIndirectGroup(material.get(), batch);
+            batch.count = 0;
+            continue;
+        }
+
+        // Draw call instanced: baseInstance seleziona l'intervallo del materiale nello slot.
+        // Proiezione e tempo arrivano dal blocco FrameData, gia' collegato da Renderer::BeginFrame.
+        DrawCommand command;
+        command.sortKey = RenderQueue::MakeSortKey(SPRITE_LAYER, static_cast<uint16_t>(material->GetShader()->GetID()), material->GetTextureSetKey(), 0);
+        command.material = material.get();
+        command.vertexArray = quadVAO;
+        command.indexCount = 6;
+        command.instanceCount = static_cast<GLsizei>(batch.count);
+        command.baseInstance = static_cast<GLuint>(batch.first);
+        command.gpuScope = "SpriteBatch";
+        command.gpuScopeId = static_cast<int>(materialID);
+        spriteRenderer->Submit(command);
+
+        // 5. Azzera il batch per il prossimo frame
+        batch.count = 0;
+    }
+
+    SubmitIndirectGroups();
+}
+
+void EndRenderingSystemFrame()
+{
+    // Il fence va inserito dopo le draw che leggono lo slot, cioe' dopo Renderer::EndFrame
+    if (instanceSlotInUse)
+    {
+        instanceRing->EndFrame();
+        instanceSlotInUse = false;
+    }
+    if (drawDataSlotInUse)
+    {
+        drawDataRing->EndFrame();
+        drawDataSlotInUse = false;
+    }
+}
@@ -0,0 +1,51 @@
+#include "Core/RollingStatistics.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+RollingStatistics::RollingStatistics(size_t capacity) : window(std::max<size_t>(capacity, 1))
+{
+}
+
+void RollingStatistics::Add(double value)
+{
+    window[next] = value;
+    next = (next + 1) % window.size();
+    count = std::min(count + 1, window.size());
+    last = value;
+}
+
+void RollingStatistics::Clear()
+{
+    next = 0;
+    count = 0;
+    last = 0.0;
+}
+
+TimingStats RollingStatistics::Summarize(const std::string& name) const
+{
+    TimingStats stats;
+    stats.name = name;
+    stats.samples = count;
+    if (count == 0)
+    {
+        return stats;
+    }
+
+    // Until the window is full the valid samples are the first 'count' ones
+    std::vector<double> sorted(window.begin(), window.begin() + count);
+    std::sort(sorted.begin(), sorted.end());
+
+    // Nearest-rank percentile: with fewer than 100 samples p99 is the maximum
+    size_t p99Rank = static_cast<size_t>(std::ceil(0.99 * static_cast<double>(count)));
+    stats.min = sorted.front();
+    stats.avg = std::accumulate(sorted.begin(), sorted.end(), 0.0) / static_cast<double>(count);
+    stats.p99 = sorted[p99Rank - 1];
+    stats.last = last;
+    return stats;
+}
+
+size_t RollingStatistics::GetCount() const
+{
+    return count;
+}
@@ -0,0 +1,101 @@
+#include "Core/SamplerCache.h"
+#include "Core/GLStateCache.h"
+#include <algorithm>
+
+SamplerCache& SamplerCache::GetInstance()
+{
+    static SamplerCache instance;
+    return instance;
+}
+
+void SamplerCache::Initialize()
+{
+    // Core since 4.6. The null backend leaves the value untouched, which keeps anisotropy off.
+    maxAnisotropy = 1.0f;
+    glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &maxAnisotropy);
+    maxAnisotropy = std::max(maxAnisotropy, 1.0f);
+    anisotropy = std::min(anisotropy, maxAnisotropy);
+}
+
+void SamplerCache::SetAnisotropy(float value)
+{
+    anisotropy = std::clamp(value, 1.0f, maxAnisotropy);
+    for (const Entry& entry : samplers)
+    {
+        if (entry.filter == TextureFilter::SMOOTH)
+        {
+            glSamplerParameterf(entry.sampler, GL_TEXTURE_MAX_ANISOTROPY, anisotropy);
+        }
+    }
+}
+
+float SamplerCache::GetAnisotropy() const
+{
+    return anisotropy;
+}
+
+void SamplerCache::ApplyParameters(GLuint texture, TextureFilter filter) const
+{
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    if (filter == TextureFilter::PIXEL_PERFECT)
+    {
+        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    else
+    {
+        glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        if (anisotropy > 1.0f)
+        {
+            glTextureParameterf(texture, GL_TEXTURE_MAX_ANISOTROPY, anisotropy);
+        }
+    }
+}
+
+GLuint SamplerCache::Get(TextureFilter filter, float lodBias)
+{
+    if (lodBias == 0.0f)
+    {
+        return 0;
+    }
+    for (const Entry& entry : samplers)
+    {
+        if (entry.filter == filter && entry.lodBias == lodBias)
+        {
+            return entry.sampler;
+        }
+    }
+
+    GLuint sampler = 0;
+    glCreateSamplers(1, &sampler);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    if (filter == TextureFilter::PIXEL_PERFECT)
+    {
+        glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+    else
+    {
+        glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY, anisotropy);
+    }
+    glSamplerParameterf(sampler, GL_TEXTURE_LOD_BIAS, lodBias);
+
+    samplers.push_back({ filter, lodBias, sampler });
+    return sampler;
+}
+
+void SamplerCache::Shutdown()
+{
+    for (const Entry& entry : samplers)
+    {
+        glDeleteSamplers(1, &entry.sampler);
+    }
+    samplers.clear();
+    // Deleted names may be handed out again
+    GLStateCache::GetInstance().Invalidate();
+}
@@ -0,0 +1,303 @@
+#include "Core/SpriteTransform.h"
+#include <bit>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SPRITE_TRANSFORM_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#else
+#define SPRITE_TRANSFORM_X86 0
+#endif
+
+// GCC and Clang only emit SSE4/AVX2 instructions in functions that ask for them explicitly,
+// MSVC always allows the intrinsics
+#if defined(__GNUC__) || defined(__clang__)
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SIMD_TARGET(isa)
+#endif
+
+// Same constant used by glm::radians, so the SIMD multiply is bit exact with the reference path
+static const float DEG_TO_RAD = 0.01745329251994329576923690768489f;
+
+// Float to half conversion with round-half-up (F. Giesen, "float_to_half_fast3").
+// Overflow saturates to infinity and NaN stays NaN.
+static uint32_t FloatToHalf(float value)
+{
+    const uint32_t f32Infinity = 255u << 23;
+    const uint32_t f16Infinity = 31u << 23;
+    const uint32_t roundMask = ~0xFFFu;
+    const float magic = std::bit_cast<float>(15u << 23);
+
+    uint32_t bits = std::bit_cast<uint32_t>(value);
+    uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint32_t half;
+    if (bits >= f32Infinity)
+    {
+        half = (bits > f32Infinity) ? 0x7E00u : 0x7C00u;
+    }
+    else
+    {
+        bits = std::bit_cast<uint32_t>(std::bit_cast<float>(bits & roundMask) * magic) - roundMask;
+        if (bits > f16Infinity)
+        {
+            bits = f16Infinity;
+        }
+        half = bits >> 13;
+    }
+    return half | (sign >> 16);
+}
+
+static void PackSpriteInstancesScalar(const Position* positions, const Rotation* rotations, const Scale* scales, const SpriteRef* sprites,
+    size_t count, uint32_t spriteCount, uint32_t tint, InstancedData* out)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        InstancedData& instance = out[i];
+        instance.position = glm::vec2(positions[i].x, positions[i].y);
+        instance.scale = FloatToHalf(scales[i].x) | (FloatToHalf(scales[i].y) << 16);
+        instance.rotation = rotations[i].value * DEG_TO_RAD;
+        instance.spriteIndex = (sprites[i].spriteID < spriteCount) ? sprites[i].spriteID : 0;
+        instance.tint = tint;
+    }
+}
+
+#if SPRITE_TRANSFORM_X86
+
+// Four lanes of FloatToHalf, same rounding as the scalar version
+SIMD_TARGET("sse4.1")
+static inline __m128i FloatToHalfSSE(__m128 value)
+{
+    const __m128i f32Infinity = _mm_set1_epi32(255 << 23);
+    const __m128 magic = _mm_castsi128_ps(_mm_set1_epi32(15 << 23));
+    const __m128 roundMask = _mm_castsi128_ps(_mm_set1_epi32(~0xFFF));
+    const __m128 clampValue = _mm_castsi128_ps(_mm_set1_epi32((31 << 23) - 0x1000));
+
+    __m128 sign = _mm_and_ps(value, _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000u))));
+    __m128 absValue = _mm_xor_ps(value, sign);
+    __m128i absBits = _mm_castps_si128(absValue);
+
+    __m128i isNaN = _mm_cmpgt_epi32(absBits, f32Infinity);
+    __m128i isFinite = _mm_cmpgt_epi32(f32Infinity, absBits);
+    __m128i infOrNaN = _mm_or_si128(_mm_and_si128(isNaN, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7C00));
+
+    __m128 scaled = _mm_mul_ps(_mm_and_ps(absValue, roundMask), magic);
+    __m128 clamped = _mm_min_ps(scaled, clampValue);
+    __m128i rounded = _mm_sub_epi32(_mm_castps_si128(clamped), _mm_castps_si128(roundMask));
+    __m128i finite = _mm_and_si128(_mm_srli_epi32(rounded, 13), isFinite);
+
+    __m128i half = _mm_or_si128(finite, _mm_andnot_si128(isFinite, infOrNaN));
+    return _mm_or_si128(half, _mm_srli_epi32(_mm_castps_si128(sign), 16));
+}
+
+// Sprite indices outside of the table become 0
+SIMD_TARGET("sse4.1")
+static inline __m128i ClampSpriteIndexSSE(__m128i index, __m128i maxIndex)
+{
+    __m128i inRange = _mm_cmpeq_epi32(_mm_min_epu32(index, maxIndex), index);
+    return _mm_and_si128(index, inRange);
+}
+
+// Interleaves four sprites into 4 x 24 bytes: { px, py, scale, rot, index, tint }.
+// 'positions01' and 'positions23' hold the x, y pairs of two sprites each.
+SIMD_TARGET("sse4.1")
+static inline void StoreFourInstances(__m128 positions01, __m128 positions23, __m128i scale, __m128 rotation, __m128i index, __m128i tint, InstancedData* out)
+{
+    __m128 scaleRotation01 = _mm_unpacklo_ps(_mm_castsi128_ps(scale), rotation);
+    __m128 scaleRotation23 = _mm_unpackhi_ps(_mm_castsi128_ps(scale), rotation);
+    __m128 indexTint01 = _mm_unpacklo_ps(_mm_castsi128_ps(index), _mm_castsi128_ps(tint));
+    __m128 indexTint23 = _mm_unpackhi_ps(_mm_castsi128_ps(index), _mm_castsi128_ps(tint));
+
+    float* dst = reinterpret_cast<float*>(out);
+    _mm_storeu_ps(dst + 0, _mm_movelh_ps(positions01, scaleRotation01));
+    _mm_storeu_ps(dst + 4, _mm_shuffle_ps(indexTint01, positions01, _MM_SHUFFLE(3, 2, 1, 0)));
+    _mm_storeu_ps(dst + 8, _mm_movehl_ps(indexTint01, scaleRotation01));
+    _mm_storeu_ps(dst + 12, _mm_movelh_ps(positions23, scaleRotation23));
+    _mm_storeu_ps(dst + 16, _mm_shuffle_ps(indexTint23, positions23, _MM_SHUFFLE(3, 2, 1, 0)));
+    _mm_storeu_ps(dst + 20, _mm_movehl_ps(indexTint23, scaleRotation23));
+}
+
+SIMD_TARGET("sse4.1")
+static void PackSpriteInstancesSSE41(const Position* positions, const Rotation* rotations, const Scale* scales, const SpriteRef* sprites,
+    size_t count, uint32_t spriteCount, uint32_t tint, InstancedData* out)
+{
+    const __m128i maxIndex = _mm_set1_epi32(static_cast<int>(spriteCount > 0 ? spriteCount - 1 : 0));
+    const __m128i tintValue = _mm_set1_epi32(static_cast<int>(tint));
+    const __m128 degToRad = _mm_set1_ps(DEG_TO_RAD);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        for (size_t half = 0; half < 8; half += 4)
+        {
+            size_t base = i + half;
+            const float* position = reinterpret_cast<const float*>(positions + base);
+            const float* scale = reinterpret_cast<const float*>(scales + base);
+
+            __m128 positions01 = _mm_loadu_ps(position);
+            __m128 positions23 = _mm_loadu_ps(position + 4);
+
+            // Two half floats per sprite packed in one 32 bit lane, x in the low bits
+            __m128i halves01 = FloatToHalfSSE(_mm_loadu_ps(scale));
+            __m128i halves23 = FloatToHalfSSE(_mm_loadu_ps(scale + 4));
+            __m128i packedScale = _mm_packus_epi32(halves01, halves23);
+
+            __m128 rotation = _mm_mul_ps(_mm_loadu_ps(reinterpret_cast<const float*>(rotations + base)), degToRad);
+            __m128i index = ClampSpriteIndexSSE(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sprites + base)), maxIndex);
+
+            StoreFourInstances(positions01, positions23, packedScale, rotation, index, tintValue, out + base);
+        }
+    }
+
+    PackSpriteInstancesScalar(positions + i, rotations + i, scales + i, sprites + i, count - i, spriteCount, tint, out + i);
+}
+
+SIMD_TARGET("avx2,f16c")
+static void PackSpriteInstancesAVX2(const Position* positions, const Rotation* rotations, const Scale* scales, const SpriteRef* sprites,
+    size_t count, uint32_t spriteCount, uint32_t tint, InstancedData* out)
+{
+    const __m256i maxIndex = _mm256_set1_epi32(static_cast<int>(spriteCount > 0 ? spriteCount - 1 : 0));
+    const __m128i tintValue = _mm_set1_epi32(static_cast<int>(tint));
+    const __m256 degToRad = _mm256_set1_ps(DEG_TO_RAD);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const float* position = reinterpret_cast<const float*>(positions + i);
+        const float* scale = reinterpret_cast<const float*>(scales + i);
+
+        __m256 positions0123 = _mm256_loadu_ps(position);
+        __m256 positions4567 = _mm256_loadu_ps(position + 8);
+
+        // The x, y pairs convert in place to the packed half2 layout. F16C rounds to nearest even,
+        // so exact ties can differ by one ulp from FloatToHalf.
+        __m128i scale0123 = _mm256_cvtps_ph(_mm256_loadu_ps(scale), _MM_FROUND_TO_NEAREST_INT);
+        __m128i scale4567 = _mm256_cvtps_ph(_mm256_loadu_ps(scale + 8), _MM_FROUND_TO_NEAREST_INT);
+
+        __m256 rotation = _mm256_mul_ps(_mm256_loadu_ps(reinterpret_cast<const float*>(rotations + i)), degToRad);
+
+        __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sprites + i));
+        __m256i inRange = _mm256_cmpeq_epi32(_mm256_min_epu32(index, maxIndex), index);
+        index = _mm256_and_si256(index, inRange);
+
+        StoreFourInstances(_mm256_castps256_ps128(positions0123), _mm256_extractf128_ps(positions0123, 1),
+            scale0123, _mm256_castps256_ps128(rotation), _mm256_castsi256_si128(index), tintValue, out + i);
+        StoreFourInstances(_mm256_castps256_ps128(positions4567), _mm256_extractf128_ps(positions4567, 1),
+            scale4567, _mm256_extractf128_ps(rotation, 1), _mm256_extracti128_si256(index, 1), tintValue, out + i + 4);
+    }
+
+    PackSpriteInstancesScalar(positions + i, rotations + i, scales + i, sprites + i, count - i, spriteCount, tint, out + i);
+}
+
+static void CpuId(int info[4], int leaf, int subleaf)
+{
+#if defined(_MSC_VER)
+    __cpuidex(info, leaf, subleaf);
+#else
+    unsigned int a, b, c, d;
+    __cpuid_count(leaf, subleaf, a, b, c, d);
+    info[0] = static_cast<int>(a);
+    info[1] = static_cast<int>(b);
+    info[2] = static_cast<int>(c);
+    info[3] = static_cast<int>(d);
+#endif
+}
+
+static uint64_t ReadXCR0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+
+#endif // SPRITE_TRANSFORM_X86
+
+static SimdLevel DetectSimdLevel()
+{
+#if SPRITE_TRANSFORM_X86
+    int info[4];
+    CpuId(info, 0, 0);
+    int maxLeaf = info[0];
+
+    CpuId(info, 1, 0);
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    bool f16c = (info[2] & (1 << 29)) != 0;
+
+    if (!sse41)
+    {
+        return SimdLevel::Scalar;
+    }
+
+    // AVX registers are only usable if the OS saves the YMM state on context switches
+    if (osxsave && avx && f16c && maxLeaf >= 7 && (ReadXCR0() & 0x6) == 0x6)
+    {
+        CpuId(info, 7, 0);
+        if (info[1] & (1 << 5))
+        {
+            return SimdLevel::AVX2;
+        }
+    }
+    return SimdLevel::SSE41;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+SimdLevel GetSupportedSimdLevel()
+{
+    static const SimdLevel level = DetectSimdLevel();
+    return level;
+}
+
+const char* GetSimdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::AVX2:
+        return "AVX2";
+    case SimdLevel::SSE41:
+        return "SSE4.1";
+    default:
+        return "Scalar";
+    }
+}
+
+PackSpriteInstancesFunc GetPackSpriteInstances(SimdLevel level)
+{
+    if (level > GetSupportedSimdLevel())
+    {
+        level = GetSupportedSimdLevel();
+    }
+
+#if SPRITE_TRANSFORM_X86
+    switch (level)
+    {
+    case SimdLevel::AVX2:
+        return &PackSpriteInstancesAVX2;
+    case SimdLevel::SSE41:
+        return &PackSpriteInstancesSSE41;
+    default:
+        break;
+    }
+#endif
+    return &PackSpriteInstancesScalar;
+}
+
+void PackSpriteInstances(const Position* positions, const Rotation* rotations, const Scale* scales, const SpriteRef* sprites,
+    size_t count, uint32_t spriteCount, uint32_t tint, InstancedData* out)
+{
+    static const PackSpriteInstancesFunc kernel = GetPackSpriteInstances(GetSupportedSimdLevel());
+    kernel(positions, rotations, scales, sprites, count, spriteCount, tint, out);
+}
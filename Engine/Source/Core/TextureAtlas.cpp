@@ -0,0 +1,485 @@
+#include "Core/TextureAtlas.h"
+#include "Core/GLStateCache.h"
+#include "Core/Profiler.h"
+#include "Core/TextureReferences.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <iostream>
+
+// Frames a retired page is kept alive, as many as the frames the GPU may run behind
+static const uint64_t RETIRE_DELAY_FRAMES = 3;
+static const size_t PAGE_BYTES = static_cast<size_t>(ATLAS_PAGE_SIZE) * ATLAS_PAGE_SIZE * 4;
+static const int64_t PAGE_AREA = static_cast<int64_t>(ATLAS_PAGE_SIZE) * ATLAS_PAGE_SIZE;
+
+SkylinePacker::SkylinePacker(int width, int height) : width(width), height(height)
+{
+    Reset();
+}
+
+void SkylinePacker::Reset()
+{
+    skyline.clear();
+    skyline.push_back({ 0, 0, width });
+    usedArea = 0;
+}
+
+bool SkylinePacker::Insert(int width, int height, AtlasRect& rect)
+{
+    int bestTop = INT_MAX;
+    int bestWidth = INT_MAX;
+    size_t bestIndex = SIZE_MAX;
+
+    for (size_t i = 0; i < skyline.size(); ++i)
+    {
+        int y = Fit(i, width, height);
+        if (y < 0)
+        {
+            continue;
+        }
+        // Lowest top edge first, then the narrowest segment to keep wide segments for wide rectangles
+        int top = y + height;
+        if (top < bestTop || (top == bestTop && skyline[i].width < bestWidth))
+        {
+            bestTop = top;
+            bestWidth = skyline[i].width;
+            bestIndex = i;
+            rect = { skyline[i].x, y, width, height };
+        }
+    }
+
+    if (bestIndex == SIZE_MAX)
+    {
+        return false;
+    }
+
+    AddLevel(bestIndex, rect);
+    usedArea += static_cast<int64_t>(width) * height;
+    return true;
+}
+
+int64_t SkylinePacker::GetUsedArea() const
+{
+    return usedArea;
+}
+
+int SkylinePacker::Fit(size_t index, int width, int height) const
+{
+    if (skyline[index].x + width > this->width)
+    {
+        return -1;
+    }
+
+    int y = skyline[index].y;
+    int widthLeft = width;
+    for (size_t i = index; widthLeft > 0; ++i)
+    {
+        y = std::max(y, skyline[i].y);
+        if (y + height > this->height)
+        {
+            return -1;
+        }
+        widthLeft -= skyline[i].width;
+    }
+    return y;
+}
+
+void SkylinePacker::AddLevel(size_t index, const AtlasRect& rect)
+{
+    skyline.insert(skyline.begin() + index, { rect.x, rect.y + rect.height, rect.width });
+
+    // The new segment covers the start of the following ones
+    const int right = rect.x + rect.width;
+    for (size_t i = index + 1; i < skyline.size();)
+    {
+        if (skyline[i].x >= right)
+        {
+            break;
+        }
+        int covered = right - skyline[i].x;
+        if (covered < skyline[i].width)
+        {
+            skyline[i].x += covered;
+            skyline[i].width -= covered;
+            break;
+        }
+        skyline.erase(skyline.begin() + i);
+    }
+
+    // Neighbours at the same height become one segment
+    for (size_t i = 0; i + 1 < skyline.size();)
+    {
+        if (skyline[i].y == skyline[i + 1].y)
+        {
+            skyline[i].width += skyline[i + 1].width;
+            skyline.erase(skyline.begin() + i + 1);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+TextureAtlas& TextureAtlas::GetInstance()
+{
+    static TextureAtlas instance;
+    return instance;
+}
+
+void TextureAtlas::SetMaxTextureSize(int size)
+{
+    maxTextureSize = std::clamp(size, 0, ATLAS_PAGE_SIZE - 2 * ATLAS_PADDING);
+}
+
+bool TextureAtlas::CanHold(int width, int height) const
+{
+    return width > 0 && height > 0 && width <= maxTextureSize && height <= maxTextureSize;
+}
+
+void TextureAtlas::SetMemoryBudget(size_t bytes)
+{
+    memoryBudget = bytes;
+    if (memoryBudget > 0 && pages.size() * PAGE_BYTES > memoryBudget)
+    {
+        Repack();
+    }
+}
+
+bool TextureAtlas::Insert(Texture& texture, const TextureImage& image)
+{
+    if (!CanHold(image.width, image.height))
+    {
+        return false;
+    }
+
+    PROFILE_ZONE("TextureAtlas::Insert");
+
+    const int paddedWidth = image.width + 2 * ATLAS_PADDING;
+    const int paddedHeight = image.height + 2 * ATLAS_PADDING;
+
+    AtlasRect rect;
+    Page* page = Allocate(texture.filter, paddedWidth, paddedHeight, rect);
+    if (!page)
+    {
+        counters.rejected++;
+        return false;
+    }
+
+    // Extrudes the border: each padding pixel repeats the closest edge pixel
+    std::vector<unsigned char> padded(static_cast<size_t>(paddedWidth) * paddedHeight * 4);
+    for (int y = 0; y < paddedHeight; ++y)
+    {
+        int sourceY = std::clamp(y - ATLAS_PADDING, 0, image.height - 1);
+        const unsigned char* sourceRow = image.Data() + static_cast<size_t>(sourceY) * image.width * 4;
+        unsigned char* row = padded.data() + static_cast<size_t>(y) * paddedWidth * 4;
+
+        std::memcpy(row + ATLAS_PADDING * 4, sourceRow, static_cast<size_t>(image.width) * 4);
+        for (int x = 0; x < ATLAS_PADDING; ++x)
+        {
+            std::memcpy(row + x * 4, sourceRow, 4);
+            std::memcpy(row + (paddedWidth - 1 - x) * 4, sourceRow + (image.width - 1) * 4, 4);
+        }
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glTextureSubImage2D(page->id, 0, rect.x, rect.y, rect.width, rect.height, GL_RGBA, GL_UNSIGNED_BYTE, padded.data());
+    TextureReferences::GetInstance().Update(page->id, rect.x, rect.y, rect.width, rect.height);
+
+    texture.width = image.width;
+    texture.height = image.height;
+    texture.levels = 1;
+    texture.atlased = true;
+    texture.resident = true;
+    Place(texture, *page, rect);
+    page->textures.push_back(&texture);
+    page->liveArea += static_cast<int64_t>(rect.width) * rect.height;
+    return true;
+}
+
+void TextureAtlas::Remove(Texture& texture)
+{
+    Page* page = FindPage(texture.id);
+    if (!page)
+    {
+        return;
+    }
+
+    auto it = std::find(page->textures.begin(), page->textures.end(), &texture);
+    if (it == page->textures.end())
+    {
+        return;
+    }
+    page->textures.erase(it);
+    page->liveArea -= static_cast<int64_t>(texture.atlasRect.z) * texture.atlasRect.w;
+
+    if (!page->textures.empty())
+    {
+        return;
+    }
+
+    size_t sameFilter = std::count_if(pages.begin(), pages.end(),
+        [page](const std::unique_ptr<Page>& other) { return other->filter == page->filter; });
+    if (sameFilter > 1)
+    {
+        RetirePage(page->id);
+        pages.erase(std::find_if(pages.begin(), pages.end(), [page](const std::unique_ptr<Page>& other) { return other.get() == page; }));
+        counters.releasedPages++;
+    }
+    else
+    {
+        page->packer.Reset();
+        page->liveArea = 0;
+    }
+}
+
+void TextureAtlas::Transfer(Texture& from, Texture& to)
+{
+    Page* page = FindPage(from.id);
+    if (!page)
+    {
+        return;
+    }
+    std::replace(page->textures.begin(), page->textures.end(), &from, &to);
+}
+
+void TextureAtlas::Repack()
+{
+    Repack(TextureFilter::PIXEL_PERFECT);
+    Repack(TextureFilter::SMOOTH);
+}
+
+void TextureAtlas::CollectRetiredPages()
+{
+    frame++;
+    bool deleted = false;
+    for (size_t i = 0; i < retired.size();)
+    {
+        if (retired[i].releaseFrame > frame)
+        {
+            ++i;
+            continue;
+        }
+        TextureReferences::GetInstance().Release(retired[i].id);
+        glDeleteTextures(1, &retired[i].id);
+        retired[i] = retired.back();
+        retired.pop_back();
+        deleted = true;
+    }
+
+    if (deleted)
+    {
+        GLStateCache::GetInstance().Invalidate();
+    }
+}
+
+TextureAtlasStats TextureAtlas::GetStats() const
+{
+    TextureAtlasStats stats = counters;
+    stats.pages = pages.size();
+    stats.bytes = pages.size() * PAGE_BYTES;
+
+    int64_t liveArea = 0;
+    for (const std::unique_ptr<Page>& page : pages)
+    {
+        stats.textures += page->textures.size();
+        liveArea += page->liveArea;
+    }
+    if (!pages.empty())
+    {
+        stats.occupancy = static_cast<float>(static_cast<double>(liveArea) / (static_cast<double>(PAGE_AREA) * pages.size()));
+    }
+    return stats;
+}
+
+void TextureAtlas::Shutdown()
+{
+    for (const std::unique_ptr<Page>& page : pages)
+    {
+        RetirePage(page->id);
+    }
+    pages.clear();
+
+    for (RetiredPage& page : retired)
+    {
+        TextureReferences::GetInstance().Release(page.id);
+        glDeleteTextures(1, &page.id);
+    }
+    retired.clear();
+    GLStateCache::GetInstance().Invalidate();
+}
+
+TextureAtlas::Page* TextureAtlas::Allocate(TextureFilter filter, int width, int height, AtlasRect& rect)
+{
+    for (const std::unique_ptr<Page>& page : pages)
+    {
+        if (page->filter == filter && page->packer.Insert(width, height, rect))
+        {
+            return page.get();
+        }
+    }
+
+    // Over budget: compacting the pages may free enough room without a new page
+    if (!CanAddPage() && Repack(filter))
+    {
+        for (const std::unique_ptr<Page>& page : pages)
+        {
+            if (page->filter == filter && page->packer.Insert(width, height, rect))
+            {
+                return page.get();
+            }
+        }
+    }
+
+    if (!CanAddPage())
+    {
+        return nullptr;
+    }
+
+    pages.push_back(CreatePage(filter));
+    Page* page = pages.back().get();
+    return page->packer.Insert(width, height, rect) ? page : nullptr;
+}
+
+TextureAtlas::Page* TextureAtlas::FindPage(GLuint id)
+{
+    for (const std::unique_ptr<Page>& page : pages)
+    {
+        if (page->id == id)
+        {
+            return page.get();
+        }
+    }
+    return nullptr;
+}
+
+bool TextureAtlas::CanAddPage() const
+{
+    return memoryBudget == 0 || (pages.size() + 1) * PAGE_BYTES <= memoryBudget;
+}
+
+std::unique_ptr<TextureAtlas::Page> TextureAtlas::CreatePage(TextureFilter filter)
+{
+    std::unique_ptr<Page> page = std::make_unique<Page>();
+    page->filter = filter;
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &page->id);
+    glTextureStorage2D(page->id, 1, GL_RGBA8, ATLAS_PAGE_SIZE, ATLAS_PAGE_SIZE);
+    glTextureParameteri(page->id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTextureParameteri(page->id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    GLint sampling = (filter == TextureFilter::PIXEL_PERFECT) ? GL_NEAREST : GL_LINEAR;
+    glTextureParameteri(page->id, GL_TEXTURE_MIN_FILTER, sampling);
+    glTextureParameteri(page->id, GL_TEXTURE_MAG_FILTER, sampling);
+
+    // Transparent until something is packed, so a stray sample shows nothing
+    glClearTexImage(page->id, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    return page;
+}
+
+void TextureAtlas::RetirePage(GLuint id)
+{
+    retired.push_back({ id, frame + RETIRE_DELAY_FRAMES });
+}
+
+bool TextureAtlas::Repack(TextureFilter filter)
+{
+    std::vector<Texture*> live;
+    size_t oldPages = 0;
+    for (const std::unique_ptr<Page>& page : pages)
+    {
+        if (page->filter == filter)
+        {
+            live.insert(live.end(), page->textures.begin(), page->textures.end());
+            oldPages++;
+        }
+    }
+    if (oldPages < 2)
+    {
+        return false;
+    }
+
+    PROFILE_ZONE("TextureAtlas::Repack");
+
+    // Tallest first packs a skyline tightest
+    std::sort(live.begin(), live.end(), [](const Texture* a, const Texture* b)
+        {
+            return a->atlasRect.w != b->atlasRect.w ? a->atlasRect.w > b->atlasRect.w : a->atlasRect.z > b->atlasRect.z;
+        });
+
+    // Dry run on the CPU: the copies are only made if the textures need fewer pages
+    std::vector<SkylinePacker> packers;
+    std::vector<AtlasRect> placed(live.size());
+    std::vector<size_t> destination(live.size());
+    for (size_t i = 0; i < live.size(); ++i)
+    {
+        const glm::ivec4& source = live[i]->atlasRect;
+        size_t target = 0;
+        while (target < packers.size() && !packers[target].Insert(source.z, source.w, placed[i]))
+        {
+            target++;
+        }
+        if (target == packers.size())
+        {
+            packers.emplace_back();
+            packers.back().Insert(source.z, source.w, placed[i]);
+        }
+        destination[i] = target;
+    }
+    if (packers.size() >= oldPages)
+    {
+        return false;
+    }
+
+    std::vector<std::unique_ptr<Page>> repacked;
+    for (SkylinePacker& packer : packers)
+    {
+        repacked.push_back(CreatePage(filter));
+        repacked.back()->packer = packer;
+    }
+
+    for (size_t i = 0; i < live.size(); ++i)
+    {
+        Texture& texture = *live[i];
+        Page& page = *repacked[destination[i]];
+        const glm::ivec4& source = texture.atlasRect;
+        glCopyImageSubData(texture.id, GL_TEXTURE_2D, 0, source.x, source.y, 0,
+            page.id, GL_TEXTURE_2D, 0, placed[i].x, placed[i].y, 0, source.z, source.w, 1);
+
+        Place(texture, page, placed[i]);
+        page.textures.push_back(&texture);
+        page.liveArea += static_cast<int64_t>(source.z) * source.w;
+    }
+
+    for (auto it = pages.begin(); it != pages.end();)
+    {
+        if ((*it)->filter == filter)
+        {
+            RetirePage((*it)->id);
+            it = pages.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    // The new pages are copied into their array layers (or get their handles) on first use
+    for (std::unique_ptr<Page>& page : repacked)
+    {
+        pages.push_back(std::move(page));
+    }
+
+    counters.releasedPages += oldPages - packers.size();
+    counters.repacks++;
+    std::cout << "Texture atlas: repacked " << live.size() << " textures into " << packers.size() << " of " << oldPages << " pages" << std::endl;
+    return true;
+}
+
+void TextureAtlas::Place(Texture& texture, const Page& page, const AtlasRect& rect)
+{
+    texture.id = page.id;
+    texture.atlasRect = glm::ivec4(rect.x, rect.y, rect.width, rect.height);
+
+    const float scale = 1.0f / ATLAS_PAGE_SIZE;
+    texture.uvRect = glm::vec4((rect.x + ATLAS_PADDING) * scale, (rect.y + ATLAS_PADDING) * scale,
+        (rect.width - 2 * ATLAS_PADDING) * scale, (rect.height - 2 * ATLAS_PADDING) * scale);
+}
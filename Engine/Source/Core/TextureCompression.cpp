@@ -0,0 +1,439 @@
+#include "Core/TextureCompression.h"
+#include "Core/Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+// Read by Texture::Decode on the asset workers
+static std::atomic<bool> s3tcSupported = false;
+
+static bool HasExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        if (extension && std::strcmp(extension, name) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static size_t GetBlockSize(GLenum format)
+{
+    return format == COMPRESSED_RGB_S3TC_DXT1 ? 8 : 16;
+}
+
+static uint16_t PackRGB565(const int* color)
+{
+    return static_cast<uint16_t>(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+}
+
+static void UnpackRGB565(uint16_t packed, int* color)
+{
+    int r = (packed >> 11) & 31;
+    int g = (packed >> 5) & 63;
+    int b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// Writes the 8 byte color part of a BC1/BC3 block. color0 > color1 keeps BC1 in the four color
+// mode (no transparent index); BC3 always decodes four colors.
+static void EncodeColorBlock(const unsigned char* block, unsigned char* output)
+{
+    int minColor[3] = { 255, 255, 255 };
+    int maxColor[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; ++i)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            minColor[c] = std::min(minColor[c], static_cast<int>(block[i * 4 + c]));
+            maxColor[c] = std::max(maxColor[c], static_cast<int>(block[i * 4 + c]));
+        }
+    }
+
+    // The bounding box diagonal that follows the texels: green and blue are flipped when they
+    // decrease while red increases
+    int center[3];
+    for (int c = 0; c < 3; ++c)
+    {
+        center[c] = (minColor[c] + maxColor[c]) / 2;
+    }
+    int covarianceRG = 0;
+    int covarianceRB = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        int r = block[i * 4] - center[0];
+        covarianceRG += r * (block[i * 4 + 1] - center[1]);
+        covarianceRB += r * (block[i * 4 + 2] - center[2]);
+    }
+    if (covarianceRG < 0)
+    {
+        std::swap(minColor[1], maxColor[1]);
+    }
+    if (covarianceRB < 0)
+    {
+        std::swap(minColor[2], maxColor[2]);
+    }
+
+    // Inset by 1/16 of the range: the endpoints sit on the extremes, the palette is wasted there
+    for (int c = 0; c < 3; ++c)
+    {
+        int inset = (maxColor[c] - minColor[c]) / 16;
+        minColor[c] = std::clamp(minColor[c] + inset, 0, 255);
+        maxColor[c] = std::clamp(maxColor[c] - inset, 0, 255);
+    }
+
+    uint16_t color0 = PackRGB565(maxColor);
+    uint16_t color1 = PackRGB565(minColor);
+    if (color0 < color1)
+    {
+        std::swap(color0, color1);
+    }
+
+    uint32_t indices = 0;
+    if (color0 != color1)
+    {
+        int palette[4][3];
+        UnpackRGB565(color0, palette[0]);
+        UnpackRGB565(color1, palette[1]);
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for (int i = 0; i < 16; ++i)
+        {
+            int bestIndex = 0;
+            int bestDistance = INT32_MAX;
+            for (int p = 0; p < 4; ++p)
+            {
+                int dr = block[i * 4] - palette[p][0];
+                int dg = block[i * 4 + 1] - palette[p][1];
+                int db = block[i * 4 + 2] - palette[p][2];
+                int distance = dr * dr + dg * dg + db * db;
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    bestIndex = p;
+                }
+            }
+            indices |= static_cast<uint32_t>(bestIndex) << (i * 2);
+        }
+    }
+
+    output[0] = static_cast<unsigned char>(color0);
+    output[1] = static_cast<unsigned char>(color0 >> 8);
+    output[2] = static_cast<unsigned char>(color1);
+    output[3] = static_cast<unsigned char>(color1 >> 8);
+    for (int i = 0; i < 4; ++i)
+    {
+        output[4 + i] = static_cast<unsigned char>(indices >> (i * 8));
+    }
+}
+
+static void DecodeColorBlock(const unsigned char* input, unsigned char* block, bool allowTransparent)
+{
+    uint16_t color0 = static_cast<uint16_t>(input[0] | (input[1] << 8));
+    uint16_t color1 = static_cast<uint16_t>(input[2] | (input[3] << 8));
+    uint32_t indices = input[4] | (input[5] << 8) | (input[6] << 16) | (static_cast<uint32_t>(input[7]) << 24);
+
+    int palette[4][4];
+    UnpackRGB565(color0, palette[0]);
+    UnpackRGB565(color1, palette[1]);
+    palette[0][3] = palette[1][3] = palette[2][3] = palette[3][3] = 255;
+    if (color0 > color1 || !allowTransparent)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+    }
+    else
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+        palette[3][3] = 0;
+    }
+
+    for (int i = 0; i < 16; ++i)
+    {
+        const int* color = palette[(indices >> (i * 2)) & 3];
+        for (int c = 0; c < 4; ++c)
+        {
+            block[i * 4 + c] = static_cast<unsigned char>(color[c]);
+        }
+    }
+}
+
+void TextureCompression::Initialize()
+{
+    s3tcSupported = HasExtension("GL_EXT_texture_compression_s3tc");
+}
+
+bool TextureCompression::IsSupported()
+{
+    return s3tcSupported;
+}
+
+void TextureCompression::EncodeBC1Block(const unsigned char* block, unsigned char* output)
+{
+    EncodeColorBlock(block, output);
+}
+
+void TextureCompression::EncodeBC3Block(const unsigned char* block, unsigned char* output)
+{
+    int minAlpha = 255;
+    int maxAlpha = 0;
+    for (int i = 0; i < 16; ++i)
+    {
+        minAlpha = std::min(minAlpha, static_cast<int>(block[i * 4 + 3]));
+        maxAlpha = std::max(maxAlpha, static_cast<int>(block[i * 4 + 3]));
+    }
+
+    // alpha0 > alpha1 selects the eight value mode, which also keeps 0 and 255 exact when they
+    // are the extremes
+    uint64_t indices = 0;
+    if (maxAlpha != minAlpha)
+    {
+        int palette[8];
+        palette[0] = maxAlpha;
+        palette[1] = minAlpha;
+        for (int p = 1; p < 7; ++p)
+        {
+            palette[p + 1] = ((7 - p) * maxAlpha + p * minAlpha) / 7;
+        }
+
+        for (int i = 0; i < 16; ++i)
+        {
+            int alpha = block[i * 4 + 3];
+            int bestIndex = 0;
+            int bestDistance = INT32_MAX;
+            for (int p = 0; p < 8; ++p)
+            {
+                int distance = std::abs(alpha - palette[p]);
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    bestIndex = p;
+                }
+            }
+            indices |= static_cast<uint64_t>(bestIndex) << (i * 3);
+        }
+    }
+
+    output[0] = static_cast<unsigned char>(maxAlpha);
+    output[1] = static_cast<unsigned char>(minAlpha);
+    for (int i = 0; i < 6; ++i)
+    {
+        output[2 + i] = static_cast<unsigned char>(indices >> (i * 8));
+    }
+    EncodeColorBlock(block, output + 8);
+}
+
+void TextureCompression::DecodeBC1Block(const unsigned char* input, unsigned char* block)
+{
+    DecodeColorBlock(input, block, true);
+}
+
+void TextureCompression::DecodeBC3Block(const unsigned char* input, unsigned char* block)
+{
+    DecodeColorBlock(input + 8, block, false);
+
+    int alpha0 = input[0];
+    int alpha1 = input[1];
+    int palette[8] = { alpha0, alpha1 };
+    if (alpha0 > alpha1)
+    {
+        for (int p = 1; p < 7; ++p)
+        {
+            palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+        }
+    }
+    else
+    {
+        for (int p = 1; p < 5; ++p)
+        {
+            palette[p + 1] = ((5 - p) * alpha0 + p * alpha1) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; ++i)
+    {
+        indices |= static_cast<uint64_t>(input[2 + i]) << (i * 8);
+    }
+    for (int i = 0; i < 16; ++i)
+    {
+        block[i * 4 + 3] = static_cast<unsigned char>(palette[(indices >> (i * 3)) & 7]);
+    }
+}
+
+size_t TextureCompression::GetLevelSize(GLenum format, int width, int height)
+{
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(format);
+}
+
+static void EncodeLevel(const unsigned char* pixels, int width, int height, GLenum format, unsigned char* output)
+{
+    const size_t blockSize = GetBlockSize(format);
+    unsigned char block[64];
+
+    for (int blockY = 0; blockY < height; blockY += 4)
+    {
+        for (int blockX = 0; blockX < width; blockX += 4)
+        {
+            // Texels past the edge repeat the last row or column
+            for (int y = 0; y < 4; ++y)
+            {
+                int sourceY = std::min(blockY + y, height - 1);
+                for (int x = 0; x < 4; ++x)
+                {
+                    int sourceX = std::min(blockX + x, width - 1);
+                    std::memcpy(block + (y * 4 + x) * 4, pixels + (static_cast<size_t>(sourceY) * width + sourceX) * 4, 4);
+                }
+            }
+
+            if (format == COMPRESSED_RGB_S3TC_DXT1)
+            {
+                TextureCompression::EncodeBC1Block(block, output);
+            }
+            else
+            {
+                TextureCompression::EncodeBC3Block(block, output);
+            }
+            output += blockSize;
+        }
+    }
+}
+
+std::vector<unsigned char> TextureCompression::Encode(const TextureImage& image)
+{
+    PROFILE_ZONE("TextureCompression::Encode");
+
+    bool opaque = true;
+    const unsigned char* pixels = image.Data();
+    for (size_t i = 3; i < image.GetSize(); i += 4)
+    {
+        if (pixels[i] != 255)
+        {
+            opaque = false;
+            break;
+        }
+    }
+
+    CompressedTextureHeader header = {};
+    std::memcpy(header.magic, COMPRESSED_TEXTURE_MAGIC, sizeof(COMPRESSED_TEXTURE_MAGIC));
+    header.format = opaque ? COMPRESSED_RGB_S3TC_DXT1 : COMPRESSED_RGBA_S3TC_DXT5;
+    header.width = static_cast<uint32_t>(image.width);
+    header.height = static_cast<uint32_t>(image.height);
+
+    // Same chain the worker would build for an RGBA8 texture, levels[0] is the image itself
+    TextureImage chain;
+    chain.width = image.width;
+    chain.height = image.height;
+    chain.mapped = image.Data();
+    Texture::GenerateMipmaps(chain);
+
+    uint32_t offset = sizeof(CompressedTextureHeader);
+    header.levels = static_cast<uint32_t>(std::min<size_t>(chain.levels.size(), MAX_COMPRESSED_LEVELS));
+    for (uint32_t i = 0; i < header.levels; ++i)
+    {
+        header.levelOffsets[i] = offset;
+        header.levelSizes[i] = static_cast<uint32_t>(GetLevelSize(header.format, std::max(image.width >> i, 1), std::max(image.height >> i, 1)));
+        offset += header.levelSizes[i];
+    }
+
+    std::vector<unsigned char> output(offset);
+    std::memcpy(output.data(), &header, sizeof(header));
+    for (uint32_t i = 0; i < header.levels; ++i)
+    {
+        EncodeLevel(chain.Data() + chain.levels[i].offset, std::max(image.width >> i, 1), std::max(image.height >> i, 1), header.format,
+            output.data() + header.levelOffsets[i]);
+    }
+    return output;
+}
+
+bool TextureCompression::Read(const unsigned char* data, size_t size, TextureImage& image)
+{
+    if (size < sizeof(CompressedTextureHeader))
+    {
+        return false;
+    }
+    CompressedTextureHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, COMPRESSED_TEXTURE_MAGIC, sizeof(COMPRESSED_TEXTURE_MAGIC)) != 0 ||
+        (header.format != COMPRESSED_RGB_S3TC_DXT1 && header.format != COMPRESSED_RGBA_S3TC_DXT5) ||
+        header.levels == 0 || header.levels > MAX_COMPRESSED_LEVELS || header.width == 0 || header.height == 0)
+    {
+        return false;
+    }
+
+    image = TextureImage();
+    image.width = static_cast<int>(header.width);
+    image.height = static_cast<int>(header.height);
+    image.compressedFormat = header.format;
+    image.mapped = data;
+    for (uint32_t i = 0; i < header.levels; ++i)
+    {
+        int width = std::max(image.width >> i, 1);
+        int height = std::max(image.height >> i, 1);
+        if (header.levelSizes[i] != GetLevelSize(header.format, width, height) ||
+            static_cast<size_t>(header.levelOffsets[i]) + header.levelSizes[i] > size)
+        {
+            return false;
+        }
+        image.levels.push_back({ header.levelOffsets[i], header.levelSizes[i] });
+    }
+    return true;
+}
+
+TextureImage TextureCompression::Decompress(const TextureImage& image)
+{
+    PROFILE_ZONE("TextureCompression::Decompress");
+
+    TextureImage decoded;
+    decoded.width = image.width;
+    decoded.height = image.height;
+    decoded.pixels.resize(decoded.GetSize());
+
+    const unsigned char* input = image.Data() + image.levels[0].offset;
+    const size_t blockSize = GetBlockSize(image.compressedFormat);
+    unsigned char block[64];
+    for (int blockY = 0; blockY < image.height; blockY += 4)
+    {
+        for (int blockX = 0; blockX < image.width; blockX += 4)
+        {
+            if (image.compressedFormat == COMPRESSED_RGB_S3TC_DXT1)
+            {
+                DecodeBC1Block(input, block);
+            }
+            else
+            {
+                DecodeBC3Block(input, block);
+            }
+            input += blockSize;
+
+            for (int y = 0; y < 4 && blockY + y < image.height; ++y)
+            {
+                for (int x = 0; x < 4 && blockX + x < image.width; ++x)
+                {
+                    std::memcpy(decoded.pixels.data() + (static_cast<size_t>(blockY + y) * image.width + blockX + x) * 4, block + (y * 4 + x) * 4, 4);
+                }
+            }
+        }
+    }
+    return decoded;
+}
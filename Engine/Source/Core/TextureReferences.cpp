@@ -0,0 +1,249 @@
+#include "Core/TextureReferences.h"
+#include "Core/GLStateCache.h"
+#include "Core/SamplerCache.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// GL_ARB_bindless_texture entry points, not generated by glad
+typedef GLuint64 (GLAD_API_PTR *PFNGLGETTEXTUREHANDLEARBPROC)(GLuint texture);
+typedef void (GLAD_API_PTR *PFNGLMAKETEXTUREHANDLERESIDENTARBPROC)(GLuint64 handle);
+typedef void (GLAD_API_PTR *PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC)(GLuint64 handle);
+
+static PFNGLGETTEXTUREHANDLEARBPROC getTextureHandle = nullptr;
+static PFNGLMAKETEXTUREHANDLERESIDENTARBPROC makeTextureHandleResident = nullptr;
+static PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC makeTextureHandleNonResident = nullptr;
+
+// Layers allocated for a new array, doubled when it fills up. Arrays of large textures (atlas
+// pages) start with fewer layers, so the first one stays within INITIAL_ARRAY_BYTES.
+static const uint32_t INITIAL_ARRAY_LAYERS = 16;
+static const size_t INITIAL_ARRAY_BYTES = 16 * 1024 * 1024;
+
+static bool HasExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        if (extension && std::strcmp(extension, name) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+TextureReferences& TextureReferences::GetInstance()
+{
+    static TextureReferences instance;
+    return instance;
+}
+
+void TextureReferences::Initialize(GLADloadfunc load)
+{
+    mode = TextureReferenceMode::TextureArrays;
+    if (load && HasExtension("GL_ARB_bindless_texture"))
+    {
+        getTextureHandle = reinterpret_cast<PFNGLGETTEXTUREHANDLEARBPROC>(load("glGetTextureHandleARB"));
+        makeTextureHandleResident = reinterpret_cast<PFNGLMAKETEXTUREHANDLERESIDENTARBPROC>(load("glMakeTextureHandleResidentARB"));
+        makeTextureHandleNonResident = reinterpret_cast<PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC>(load("glMakeTextureHandleNonResidentARB"));
+        if (getTextureHandle && makeTextureHandleResident && makeTextureHandleNonResident)
+        {
+            mode = TextureReferenceMode::Bindless;
+        }
+    }
+
+    std::cout << "Texture references: " << (mode == TextureReferenceMode::Bindless ? "bindless handles" : "texture arrays") << std::endl;
+}
+
+TextureReferenceMode TextureReferences::GetMode() const
+{
+    return mode;
+}
+
+TextureReference TextureReferences::Resolve(GLuint texture, int width, int height, GLsizei levels, TextureFilter filter, GLenum format)
+{
+    auto it = references.find(texture);
+    if (it != references.end())
+    {
+        return it->second;
+    }
+
+    TextureReference reference;
+    if (mode == TextureReferenceMode::Bindless)
+    {
+        // The handle freezes the texture parameters: it is only requested once the texture is complete
+        reference.handle = getTextureHandle(texture);
+        makeTextureHandleResident(reference.handle);
+    }
+    else
+    {
+        ArrayBucket* bucket = FindBucket(width, height, levels, filter, format, reference.array);
+        if (!bucket)
+        {
+            if (!reportedArrayLimit)
+            {
+                std::cerr << "ERROR: More than " << MAX_TEXTURE_ARRAYS << " texture sizes in use, extra textures will sample array 0." << std::endl;
+                reportedArrayLimit = true;
+            }
+            return reference;
+        }
+
+        if (!bucket->freeLayers.empty())
+        {
+            reference.layer = bucket->freeLayers.back();
+            bucket->freeLayers.pop_back();
+        }
+        else
+        {
+            if (bucket->used == bucket->capacity)
+            {
+                GrowBucket(*bucket);
+            }
+            reference.layer = bucket->used++;
+        }
+
+        for (GLsizei level = 0; level < levels; ++level)
+        {
+            glCopyImageSubData(texture, GL_TEXTURE_2D, level, 0, 0, 0,
+                bucket->id, GL_TEXTURE_2D_ARRAY, level, 0, 0, static_cast<GLint>(reference.layer),
+                std::max(width >> level, 1), std::max(height >> level, 1), 1);
+        }
+    }
+
+    references.emplace(texture, reference);
+    return reference;
+}
+
+void TextureReferences::Release(GLuint texture)
+{
+    auto it = references.find(texture);
+    if (it == references.end())
+    {
+        return;
+    }
+
+    if (mode == TextureReferenceMode::Bindless)
+    {
+        makeTextureHandleNonResident(it->second.handle);
+    }
+    else if (it->second.array < buckets.size())
+    {
+        buckets[it->second.array].freeLayers.push_back(it->second.layer);
+    }
+    references.erase(it);
+}
+
+void TextureReferences::Update(GLuint texture, int x, int y, int width, int height)
+{
+    if (mode != TextureReferenceMode::TextureArrays)
+    {
+        return;
+    }
+
+    auto it = references.find(texture);
+    if (it == references.end() || it->second.array >= buckets.size())
+    {
+        return;
+    }
+    glCopyImageSubData(texture, GL_TEXTURE_2D, 0, x, y, 0,
+        buckets[it->second.array].id, GL_TEXTURE_2D_ARRAY, 0, x, y, static_cast<GLint>(it->second.layer), width, height, 1);
+}
+
+TextureReferences::ArrayBucket* TextureReferences::FindBucket(int width, int height, GLsizei levels, TextureFilter filter, GLenum format, uint32_t& index)
+{
+    for (size_t i = 0; i < buckets.size(); ++i)
+    {
+        ArrayBucket& bucket = buckets[i];
+        if (bucket.width == width && bucket.height == height && bucket.levels == levels && bucket.filter == filter &&
+            bucket.format == format)
+        {
+            index = static_cast<uint32_t>(i);
+            return &bucket;
+        }
+    }
+
+    if (buckets.size() == MAX_TEXTURE_ARRAYS)
+    {
+        return nullptr;
+    }
+
+    ArrayBucket bucket;
+    bucket.width = width;
+    bucket.height = height;
+    bucket.levels = levels;
+    bucket.filter = filter;
+    bucket.format = format;
+    index = static_cast<uint32_t>(buckets.size());
+    buckets.push_back(bucket);
+    return &buckets.back();
+}
+
+// Allocates a bigger array and copies the layers already in use. The bucket index, which is what
+// materials store, does not change.
+void TextureReferences::GrowBucket(ArrayBucket& bucket)
+{
+    uint32_t capacity = bucket.capacity * 2;
+    if (capacity == 0)
+    {
+        // RGBA8 size, an upper bound for the compressed formats
+        size_t layerBytes = static_cast<size_t>(bucket.width) * bucket.height * 4;
+        capacity = static_cast<uint32_t>(std::clamp<size_t>(INITIAL_ARRAY_BYTES / layerBytes, 1, INITIAL_ARRAY_LAYERS));
+    }
+
+    GLuint id = 0;
+    glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &id);
+    glTextureStorage3D(id, bucket.levels, bucket.format, bucket.width, bucket.height, static_cast<GLsizei>(capacity));
+    SamplerCache::GetInstance().ApplyParameters(id, bucket.filter);
+
+    if (bucket.id != 0)
+    {
+        for (GLsizei level = 0; level < bucket.levels; ++level)
+        {
+            glCopyImageSubData(bucket.id, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+                id, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+                std::max(bucket.width >> level, 1), std::max(bucket.height >> level, 1), static_cast<GLsizei>(bucket.used));
+        }
+        glDeleteTextures(1, &bucket.id);
+        // The old name may be handed out again, the cache must not trust it
+        GLStateCache::GetInstance().Invalidate();
+    }
+
+    bucket.id = id;
+    bucket.capacity = capacity;
+}
+
+void TextureReferences::BindArrays()
+{
+    if (mode != TextureReferenceMode::TextureArrays)
+    {
+        return;
+    }
+    for (size_t i = 0; i < buckets.size(); ++i)
+    {
+        GLStateCache::GetInstance().BindTextureUnit(TEXTURE_ARRAY_FIRST_UNIT + static_cast<GLuint>(i), buckets[i].id);
+    }
+}
+
+void TextureReferences::Shutdown()
+{
+    if (mode == TextureReferenceMode::Bindless)
+    {
+        for (const auto& [texture, reference] : references)
+        {
+            makeTextureHandleNonResident(reference.handle);
+        }
+    }
+    references.clear();
+
+    for (ArrayBucket& bucket : buckets)
+    {
+        if (bucket.id != 0)
+        {
+            glDeleteTextures(1, &bucket.id);
+        }
+    }
+    buckets.clear();
+    reportedArrayLimit = false;
+}
@@ -0,0 +1,221 @@
+#include "Core/TextureUploader.h"
+#include "Core/PersistentRingBuffer.h"
+#include "Core/Profiler.h"
+#include "Core/TextureAtlas.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+// Staging slot used when the byte budget is disabled
+static const size_t UNLIMITED_SLOT_SIZE = 16 * 1024 * 1024;
+
+TextureUploader::TextureUploader() = default;
+
+TextureUploader::~TextureUploader() = default;
+
+void TextureUploader::Enqueue(const std::shared_ptr<Texture>& texture, TextureImage&& image)
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+    queue.push_back({ texture, std::move(image), 0, 0 });
+}
+
+void TextureUploader::ProcessUploads()
+{
+    PROFILE_ZONE("TextureUploader::ProcessUploads");
+
+    bytesUploadedLastFrame = 0;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (queue.empty())
+        {
+            return;
+        }
+    }
+
+    if (!stagingRing)
+    {
+        stagingRing = std::make_unique<PersistentRingBuffer>(bytesPerFrame > 0 ? bytesPerFrame : UNLIMITED_SLOT_SIZE);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    stagingRing->BeginFrame();
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingRing->GetID());
+
+    while (true)
+    {
+        PendingUpload upload;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (queue.empty())
+            {
+                break;
+            }
+            upload = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        std::shared_ptr<Texture> texture = upload.texture.lock();
+        if (!texture)
+        {
+            continue;
+        }
+
+        // Small images go into an atlas page in one piece, straight from the decoded pixels.
+        // With the byte budget spent they fall through to UploadRows, which defers them.
+        const bool budgetLeft = bytesPerFrame == 0 || bytesUploadedLastFrame < bytesPerFrame;
+        if (upload.image.IsCompressed())
+        {
+            // Cooked blocks are already a fraction of the RGBA8 size and come with their mips:
+            // the whole chain goes in one piece, read in place from the pack mapping
+            if (!budgetLeft)
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                queue.push_front(std::move(upload));
+                break;
+            }
+            texture->UploadCompressed(upload.image);
+            bytesUploadedLastFrame += upload.image.GetSize();
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingRing->GetID());
+        }
+        else if (budgetLeft && upload.level == 0 && upload.rowsUploaded == 0 && texture->GetPacking() == TexturePacking::Atlas &&
+            TextureAtlas::GetInstance().Insert(*texture, upload.image))
+        {
+            bytesUploadedLastFrame += upload.image.GetSize();
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingRing->GetID());
+        }
+        else
+        {
+            // One band per call, mip levels precomputed by the worker follow level 0
+            size_t copied = 0;
+            do
+            {
+                size_t available = SIZE_MAX;
+                if (bytesPerFrame > 0)
+                {
+                    available = (bytesUploadedLastFrame < bytesPerFrame) ? bytesPerFrame - bytesUploadedLastFrame : 0;
+                }
+                copied = UploadRows(upload, *texture, available);
+                bytesUploadedLastFrame += copied;
+            } while (copied > 0 && !IsComplete(upload));
+
+            if (!IsComplete(upload))
+            {
+                // Budget or staging slot exhausted: resume from the next row band next frame
+                std::lock_guard<std::mutex> lock(queueMutex);
+                queue.push_front(std::move(upload));
+                break;
+            }
+
+            texture->FinishUpload(upload.image.levels.empty());
+        }
+
+        if (millisecondsPerFrame > 0.0)
+        {
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            if (elapsed.count() >= millisecondsPerFrame)
+            {
+                break;
+            }
+        }
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    stagingRing->EndFrame();
+}
+
+bool TextureUploader::IsComplete(const PendingUpload& upload)
+{
+    const int levelCount = std::max(static_cast<int>(upload.image.levels.size()), 1);
+    return upload.level == levelCount - 1 && upload.rowsUploaded == std::max(upload.image.height >> upload.level, 1);
+}
+
+size_t TextureUploader::UploadRows(PendingUpload& upload, Texture& texture, size_t maxBytes)
+{
+    const TextureImage& image = upload.image;
+    if (IsComplete(upload))
+    {
+        return 0;
+    }
+    if (upload.rowsUploaded == std::max(image.height >> upload.level, 1))
+    {
+        upload.level++;
+        upload.rowsUploaded = 0;
+    }
+
+    const int levelWidth = std::max(image.width >> upload.level, 1);
+    const int levelHeight = std::max(image.height >> upload.level, 1);
+    const unsigned char* levelData = image.Data() + (image.levels.empty() ? 0 : image.levels[upload.level].offset);
+    const size_t rowBytes = static_cast<size_t>(levelWidth) * 4;
+    const size_t rowsLeft = static_cast<size_t>(levelHeight - upload.rowsUploaded);
+
+    // The first band of the frame always goes through, otherwise a row larger than the
+    // budget would never be uploaded
+    size_t rows = std::min(rowsLeft, maxBytes / rowBytes);
+    if (rows == 0)
+    {
+        if (bytesUploadedLastFrame > 0)
+        {
+            return 0;
+        }
+        rows = 1;
+    }
+
+    if (stagingRing->GetSlotSize() < rowBytes)
+    {
+        // Rare: a single row does not fit a staging slot
+        stagingRing->Reserve(rowBytes);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stagingRing->GetID());
+    }
+    rows = std::min(rows, stagingRing->GetSlotSize() / rowBytes);
+
+    size_t offset = 0;
+    void* staging = stagingRing->Allocate(rows * rowBytes, 4, offset);
+    if (!staging)
+    {
+        return 0;
+    }
+
+    if (upload.level == 0 && upload.rowsUploaded == 0)
+    {
+        texture.CreateStorage(image.width, image.height);
+    }
+
+    std::memcpy(staging, levelData + upload.rowsUploaded * rowBytes, rows * rowBytes);
+    glTextureSubImage2D(texture.id, upload.level, 0, upload.rowsUploaded, levelWidth, static_cast<GLsizei>(rows), GL_RGBA, GL_UNSIGNED_BYTE,
+        reinterpret_cast<const void*>(offset));
+
+    upload.rowsUploaded += static_cast<int>(rows);
+    return rows * rowBytes;
+}
+
+void TextureUploader::SetBudget(size_t bytesPerFrame, double millisecondsPerFrame)
+{
+    this->bytesPerFrame = bytesPerFrame;
+    this->millisecondsPerFrame = millisecondsPerFrame;
+
+    if (stagingRing && bytesPerFrame > 0)
+    {
+        stagingRing->Reserve(bytesPerFrame);
+    }
+}
+
+size_t TextureUploader::GetPendingCount()
+{
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return queue.size();
+}
+
+size_t TextureUploader::GetBytesUploadedLastFrame() const
+{
+    return bytesUploadedLastFrame;
+}
+
+void TextureUploader::Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue.clear();
+    }
+    stagingRing.reset();
+    Texture::DestroyPlaceholder();
+}
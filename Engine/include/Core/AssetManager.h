@@ -4,11 +4,14 @@
 #include <unordered_map>
 #include <memory>
 #include <mutex>
-#include <atomic>
 #include <thread>
 #include <condition_variable>
 #include <functional>
 #include <vector>
+#include <deque>
+#include <array>
+#include <future>
+#include <filesystem>
 #include <glm/glm.hpp>
 
 #include "Core/Assets/Asset.h"
@@ -16,6 +19,50 @@
 #include "Core/Assets/Texture.h"
 #include "Core/Assets/Material.h"
 #include "Core/Assets/MaterialAsset.h"
+#include "Core/TextureUploader.h"
+#include "Core/AssetPack.h"
+#include "Core/FileWatcher.h"
+
+// Materiale disegnato al posto di quelli con gli shader ancora in compilazione, se il loro JSON
+// non ne indica uno con "fallback". Usa il quad con la matrice "model" (vedi Renderer).
+const char* const DEFAULT_FALLBACK_MATERIAL = "Resources/Assets/Materials/MM_fallback.json";
+
+// Cartella da cui gli asset vengono letti a runtime: CMake la copia accanto all'eseguibile al
+// momento del configure, quindi chi modifica gli asset nei sorgenti non tocca questa copia
+const char* const HOT_RELOAD_DIRECTORY = "Resources";
+
+// Cartella osservata dall'hot reload, vedi EnableHotReload. L'Engine lo attiva solo nelle build
+// Debug con l'opzione CMake ENGINE_HOT_RELOAD, che definisce ENGINE_HOT_RELOAD_ENABLED ed
+// ENGINE_SOURCE_RESOURCES_DIR con la cartella Resources dei sorgenti. Un gioco che chiama
+// EnableHotReload in altre build osserva la copia: le modifiche fatte nei sorgenti si vedono
+// solo dopo un nuovo configure.
+#ifdef ENGINE_SOURCE_RESOURCES_DIR
+const char* const HOT_RELOAD_SOURCE_DIRECTORY = ENGINE_SOURCE_RESOURCES_DIR;
+#else
+const char* const HOT_RELOAD_SOURCE_DIRECTORY = HOT_RELOAD_DIRECTORY;
+#endif
+
+// Priorita' dei caricamenti asincroni, dalla piu' urgente alla meno urgente
+enum class AssetLoadPriority
+{
+    Blocking,   // qualcuno sta aspettando il risultato
+    Visible,    // serve a breve per il rendering
+    Prefetch,   // caricamento anticipato, solo se i worker sono liberi
+    Count
+};
+
+// Contatori dell'AssetManager, vedi GetStats
+struct AssetStats
+{
+    size_t assets = 0;                  // texture e materiali in cache
+    size_t shaderPrograms = 0;          // programmi distinti per contenuto
+    size_t shaderVariants = 0;          // nomi di variante risolti, ognuno punta a un programma
+    size_t deduplicatedPrograms = 0;    // varianti che condividono il programma di un'altra variante
+    size_t reloads = 0;                 // shader, texture e materiali sostituiti dall'hot reload
+};
+
+using AssetLoadCallback = std::function<void(const std::shared_ptr<Asset>&)>;
+using AssetFuture = std::shared_future<std::shared_ptr<Asset>>;
 
 // Task per il caricamento asincrono
 struct AsyncLoadTask
@@ -23,6 +70,7 @@ struct AsyncLoadTask
     std::string name;
     std::string path;
     std::function<std::shared_ptr<Asset>()> loadFunction;
+    std::shared_ptr<std::promise<std::shared_ptr<Asset>>> promise;
 };
 
 class AssetManager
@@ -30,19 +78,76 @@ class AssetManager
 public:
     static AssetManager& GetInstance();
 
-    // Metodi per ottenere asset
-    std::shared_ptr<Shader> GetShader(const std::string& name, const std::map<unsigned int, std::string>& shaderPaths);
-    std::shared_ptr<Texture> GetTexture(const std::string& name, const std::string& path, TextureFilter filter = TextureFilter::SMOOTH);
+    // Metodi per ottenere asset. I programmi sono indicizzati per contenuto (Shader::GetContentKey):
+    // sorgenti identici danno un solo programma anche se letti da percorsi diversi. 'name'
+    // (vedi GetShaderVariantName) evita solo di rileggere i file a ogni richiesta.
+    // La compilazione avviene fuori da assetsMutex; con ShaderCompileMode::Parallel lo shader
+    // restituito puo' non essere ancora pronto (Shader::IsReady), con Blocking si aspetta anche
+    // uno shader gia' in cache ancora in compilazione.
+    std::shared_ptr<Shader> GetShader(const std::string& name, const std::map<unsigned int, std::string>& shaderPaths,
+        const std::vector<std::string>& defines = {}, ShaderCompileMode mode = ShaderCompileMode::Blocking);
+    // Nome in cache della variante: percorsi di tutti gli stadi e define, che devono essere
+    // gia' ordinati (come in MaterialAsset::GetDefines)
+    static std::string GetShaderVariantName(const std::map<unsigned int, std::string>& shaderPaths, const std::vector<std::string>& defines);
+    // Le immagini piccole finiscono in una pagina del TextureAtlas, salvo TexturePacking::Standalone
+    std::shared_ptr<Texture> GetTexture(const std::string& name, const std::string& path, TextureFilter filter = TextureFilter::SMOOTH,
+        TexturePacking packing = TexturePacking::Atlas);
+
+    // Restituisce subito una texture valida che mostra il placeholder: la decodifica avviene
+    // su un worker e l'upload sul thread OpenGL, nel budget di ProcessUploads del TextureUploader
+    std::shared_ptr<Texture> GetTextureAsync(const std::string& name, const std::string& path, TextureFilter filter = TextureFilter::SMOOTH,
+        AssetLoadPriority priority = AssetLoadPriority::Visible, TexturePacking packing = TexturePacking::Atlas);
+    TextureUploader& GetTextureUploader();
     std::shared_ptr<MaterialAsset> GetMaterialAsset(const std::string& path);
+    // Crea sempre il Material vero: se lo shader e' ancora in compilazione lo aspetta
     std::shared_ptr<Material> CreateMaterialFromAsset(const std::shared_ptr<MaterialAsset>& materialAsset);
 
-    // Metodi per il caricamento asincrono
-    void LoadAssetAsync(const std::string& name, const std::string& path, const std::function<std::shared_ptr<Asset>()>& loadFunction);
+    // Restituisce il Material in cache per l'asset, creandolo solo al primo uso
+    // o quando la versione dell'asset cambia. Non aspetta il compilatore del driver: finche'
+    // lo shader non e' pronto restituisce il materiale di fallback (vedi GetFallbackPath).
+    std::shared_ptr<Material> GetMaterial(const std::shared_ptr<MaterialAsset>& materialAsset);
+
+    // Registra un materiale per il rendering ECS e restituisce l'ID da usare in MaterialRef.
+    // L'ID 0 e' riservato e indica un materiale non valido. Lo shader viene solo inviato al
+    // driver: registrando tutti i materiali di un livello le compilazioni procedono in parallelo.
+    unsigned int RegisterMaterial(const std::string& path);
+    std::shared_ptr<Material> GetMaterial(unsigned int materialID);
+
+    // Metodi per il caricamento asincrono. Le richieste per un nome gia' caricato o in coda
+    // restituiscono lo stesso future. 'onComplete' viene chiamato sul thread del worker
+    // (con nullptr se il caricamento fallisce), o subito se l'asset e' gia' caricato.
+    AssetFuture LoadAssetAsync(const std::string& name, const std::string& path, const std::function<std::shared_ptr<Asset>()>& loadFunction,
+        AssetLoadPriority priority = AssetLoadPriority::Visible, const AssetLoadCallback& onComplete = nullptr);
     void WaitForAllLoads();
 
     // Clean up all unused assets
     void GarbageCollect();
 
+    AssetStats GetStats();
+
+    // Hot reload: osserva 'root' (vedi FileWatcher) e ricarica shader, texture e materiali in
+    // cache quando i loro file cambiano. Lettura e decodifica avvengono sui worker, compilazione
+    // e upload senza aspettare il driver; ProcessReloads sostituisce poi il contenuto degli asset
+    // al loro posto, cosi' chi tiene uno shared_ptr vede il nuovo contenuto dal frame successivo.
+    // Un file che sta in un AssetPack montato viene riletto dal pack: va usato con i file sciolti.
+    // Se 'root' non e' HOT_RELOAD_DIRECTORY un file cambiato viene prima copiato nel percorso
+    // corrispondente sotto HOT_RELOAD_DIRECTORY, da cui gli asset vengono letti.
+    bool EnableHotReload(const std::string& root = HOT_RELOAD_SOURCE_DIRECTORY);
+    // Ferma l'osservazione e scarta i ricaricamenti in corso. Con il contesto OpenGL ancora vivo.
+    void DisableHotReload();
+    // Una volta per frame sul thread principale, prima di disegnare: accoda i file cambiati e
+    // applica i ricaricamenti pronti. Non aspetta worker ne' compilatore: un programma ancora in
+    // compilazione viene controllato al frame successivo, uno che non compila lascia in uso il
+    // vecchio. Senza GL_KHR_parallel_shader_compile e' il driver a decidere se il link blocca.
+    void ProcessReloads();
+
+    // Mappa un pack creato dall'AssetCooker: da quel momento gli asset che contiene vengono letti
+    // dal pack invece che dai file sciolti. I pack montati dopo hanno la precedenza.
+    // I pack restano mappati fino alla chiusura, le viste sui loro dati non scadono.
+    bool MountPack(const std::string& path);
+    // Thread safe. Cerca il percorso nei pack montati.
+    bool FindPackedAsset(const std::string& path, PackedAsset& asset);
+
 private:
     AssetManager();
     ~AssetManager();
@@ -51,15 +156,118 @@ private:
     std::unordered_map<std::string, std::shared_ptr<Asset>> assets;
     std::mutex assetsMutex;
 
-    // Per il caricamento asincrono
-    std::vector<AsyncLoadTask> asyncTasks;
-    std::thread asyncWorker;
+    // Variante gia' risolta: la chiave del programma e quanto serve per ricompilarla
+    struct ShaderVariant
+    {
+        uint64_t key;
+        std::map<unsigned int, std::string> shaderPaths;
+        std::vector<std::string> defines;
+        // Stadi e file inclusi, normalizzati con AssetPack::NormalizePath
+        std::vector<std::string> files;
+    };
+
+    // Programmi per chiave di contenuto e varianti gia' risolte, sotto assetsMutex
+    std::unordered_map<uint64_t, std::shared_ptr<Shader>> shaders;
+    std::unordered_map<std::string, ShaderVariant> shaderVariants;
+    size_t reloads = 0;
+
+    // Cache dei Material, indicizzata per identita' del MaterialAsset. Con 'pendingShader'
+    // impostato 'material' e' il fallback, da sostituire quando lo shader e' pronto.
+    struct CachedMaterial
+    {
+        std::weak_ptr<MaterialAsset> asset;
+        unsigned int version;
+        std::shared_ptr<Material> material;
+        std::shared_ptr<Shader> pendingShader;
+    };
+    std::unordered_map<const MaterialAsset*, CachedMaterial> materialCache;
+
+    // Asset dei materiali indicizzati per ID (vedi RegisterMaterial)
+    std::vector<std::shared_ptr<MaterialAsset>> materialAssets;
+    std::unordered_map<std::string, unsigned int> materialIDs;
+    std::mutex materialsMutex;
+
+    // Per il caricamento asincrono: una coda FIFO per priorita' e un pool di worker
+    std::array<std::deque<AsyncLoadTask>, static_cast<size_t>(AssetLoadPriority::Count)> asyncTasks;
+    struct PendingLoad
+    {
+        AssetFuture future;
+        AssetLoadPriority priority;
+        std::vector<AssetLoadCallback> callbacks;
+    };
+    std::unordered_map<std::string, PendingLoad> pendingLoads;
+    std::vector<std::thread> asyncWorkers;
     std::mutex taskMutex;
     std::condition_variable taskCondition;
-    std::atomic<bool> stopWorker = false;
-    std::atomic<int> activeTasks = 0;
+    std::condition_variable loadsFinishedCondition;
+    bool stopWorkers = false;
+    int activeTasks = 0;
+
+    TextureUploader textureUploader;
+
+    std::vector<std::unique_ptr<AssetPack>> packs;
+    std::mutex packsMutex;
+
+    // Hot reload: i worker depositano sotto reloadsMutex sorgenti, JSON e copie delle texture,
+    // ProcessReloads li applica tra due frame
+    struct ShaderSourcesReload
+    {
+        std::string variant;
+        ShaderSources sources;
+        uint64_t key;
+        std::vector<std::string> files;
+    };
+    struct MaterialReload
+    {
+        std::string path;
+        nlohmann::json data;
+    };
+    // 'replacement' viene caricata dal TextureUploader, poi cede i pixel a 'target'
+    struct TextureReload
+    {
+        std::weak_ptr<Texture> target;
+        std::shared_ptr<Texture> replacement;
+    };
+    FileWatcher fileWatcher;
+    // Cartella osservata, vuota quando coincide con HOT_RELOAD_DIRECTORY (nessuna copia)
+    std::filesystem::path hotReloadSource;
+    std::vector<ShaderSourcesReload> loadedShaderSources;
+    std::vector<MaterialReload> loadedMaterials;
+    std::vector<TextureReload> textureReloads;
+    std::mutex reloadsMutex;
+
+    // Programmi ricompilati, uno per contenuto, con le varianti che li useranno. Solo sul thread principale.
+    struct ShaderBuild
+    {
+        std::shared_ptr<Shader> shader;
+        std::vector<std::string> variants;
+    };
+    std::unordered_map<uint64_t, ShaderBuild> shaderBuilds;
+
+    std::shared_ptr<Material> GetMaterial(const std::shared_ptr<MaterialAsset>& materialAsset, ShaderCompileMode mode);
+    std::shared_ptr<Shader> GetMaterialShader(const MaterialAsset& materialAsset, ShaderCompileMode mode);
+    // Materiale di fallback dell'asset, con gli shader compilati subito. nullptr per il fallback stesso.
+    std::shared_ptr<Material> GetFallbackMaterial(const MaterialAsset& materialAsset);
+
+    // Decodifica per il TextureUploader, con le mipmap calcolate sul worker quando servono
+    static TextureImage DecodeTexture(const std::string& path, TextureFilter filter, TexturePacking packing);
+
+    // Hot reload
+    std::string CopyToAssetDirectory(const std::string& changedPath);
+    void QueueReload(const std::string& path);
+    void QueueTextureReload(const std::string& name, const std::shared_ptr<Texture>& texture);
+    void QueueMaterialReload(const std::string& path);
+    void QueueShaderReload(const std::string& variant, const ShaderVariant& source);
+    void ApplyMaterialReload(MaterialReload& reload);
+    void ApplyShaderSources(ShaderSourcesReload& reload);
+    void ApplyShaderBuild(uint64_t key, ShaderBuild& build);
+    // Toglie dalla cache i Material costruiti sugli shader indicati, ricostruiti al prossimo GetMaterial
+    void InvalidateMaterials(const std::vector<std::shared_ptr<Shader>>& replaced);
 
     void AsyncWorkerThread();
+    // Mette in coda il caricamento senza controllare gli asset gia' caricati
+    AssetFuture QueueLoad(const std::string& name, const std::string& path, const std::function<std::shared_ptr<Asset>()>& loadFunction,
+        AssetLoadPriority priority, const AssetLoadCallback& onComplete);
 
     template<typename T, typename... Args>
     std::shared_ptr<T> FindOrLoad(const std::string& name, const std::string& path, Args&&... args);
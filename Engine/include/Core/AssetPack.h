@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Pack file written by the AssetCooker tool: every asset of a resource folder in one file,
+// mapped in memory and read in place.
+//
+// Layout (little endian, offsets from the start of the file):
+//   PackHeader
+//   PackEntry[entryCount]
+//   uint32_t slots[slotCount]   open addressing table on PackEntry::hash, entry index + 1, 0 = empty
+//   path strings                not terminated, see PackEntry::pathOffset/pathLength
+//   data                        each blob aligned to PACK_DATA_ALIGNMENT
+const char PACK_MAGIC[4] = { 'C', 'E', 'P', 'K' };
+const uint32_t PACK_VERSION = 1;
+const uint64_t PACK_DATA_ALIGNMENT = 64;
+
+// Name of the pack mounted by the Engine at startup when it exists in the working directory
+const char* const DEFAULT_ASSET_PACK = "Resources.pack";
+
+enum class PackEntryType : uint32_t
+{
+    Raw,
+    Material,       // MessagePack encoding of the material JSON (nlohmann::json::to_msgpack)
+    Texture,        // RGBA8 pixels, first row at the bottom, as returned by Texture::Decode
+    ShaderSource,       // GLSL text
+    CompressedTexture   // BC1/BC3 blocks with the mip chain, see TextureCompression.h
+};
+
+struct PackHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t slotCount;
+    uint64_t entriesOffset;
+    uint64_t slotsOffset;
+    uint64_t stringsOffset;
+};
+static_assert(sizeof(PackHeader) == 40, "PackHeader is part of the file format");
+
+struct PackEntry
+{
+    uint64_t hash;
+    uint64_t dataOffset;
+    uint64_t dataSize;
+    uint32_t pathOffset;
+    uint32_t pathLength;
+    PackEntryType type;
+    uint32_t width;
+    uint32_t height;
+    uint32_t reserved;
+};
+static_assert(sizeof(PackEntry) == 48, "PackEntry is part of the file format");
+
+// An asset found in a mounted pack. 'data' points into the mapping and stays valid while the
+// pack is mounted.
+struct PackedAsset
+{
+    PackEntryType type = PackEntryType::Raw;
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    int width = 0;
+    int height = 0;
+};
+
+// Read-only view of a pack file mapped in memory. Thread safe once opened.
+class AssetPack
+{
+public:
+    ~AssetPack();
+
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+
+    // Maps the file and validates the header. Returns nullptr if the file is missing or invalid.
+    static std::unique_ptr<AssetPack> Open(const std::string& path);
+
+    // Looks up an asset by the path it would be loaded from (e.g. "Resources/Assets/...")
+    bool Find(std::string_view path, PackedAsset& asset) const;
+
+    size_t GetEntryCount() const;
+    const std::string& GetPath() const;
+
+    // Same path written different ways ("./a\\b", "a/b") gives the same key
+    static std::string NormalizePath(std::string_view path);
+    // FNV-1a 64 of the normalized path
+    static uint64_t HashPath(std::string_view normalizedPath);
+
+private:
+    AssetPack() = default;
+
+    std::string path;
+    const unsigned char* base = nullptr;
+    size_t size = 0;
+    const PackHeader* header = nullptr;
+    const PackEntry* entries = nullptr;
+    const uint32_t* slots = nullptr;
+
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#endif
+};
+
+// Collects assets in memory and writes them as a pack file. Used by the AssetCooker tool.
+class AssetPackWriter
+{
+public:
+    // Adding the same path twice replaces the first entry
+    void Add(const std::string& path, PackEntryType type, std::vector<unsigned char> data, int width = 0, int height = 0);
+    size_t GetEntryCount() const;
+
+    // Returns false and prints the reason if the file cannot be written
+    bool Write(const std::string& outputPath) const;
+
+private:
+    struct Item
+    {
+        std::string path;
+        PackEntryType type;
+        std::vector<unsigned char> data;
+        int width;
+        int height;
+    };
+    std::vector<Item> items;
+};
@@ -12,6 +12,13 @@ const std::string& GetPath() const
         return path;
     }
 
+    // Incremented every time the asset content changes, so derived data can be invalidated
+    unsigned int GetVersion() const
+    {
+        return version;
+    }
+
 protected:
     std::string path;
+    unsigned int version = 0;
 };
\ No newline at end of file
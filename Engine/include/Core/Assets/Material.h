@@ -1,9 +1,10 @@
 #pragma once
 
 #include <glm/glm.hpp>
-#include <map>
 #include <string>
 #include <memory>
+#include <vector>
+#include <cstdint>
 #include "Core/Assets/Shader.h"
 #include "Core/Assets/Texture.h"
 
@@ -13,11 +14,18 @@ public:
     // Costruttore che accetta un shared_ptr allo shader
     Material(const std::shared_ptr<Shader>& shader);
 
-    // Distruttore di default. I shared_ptr si gestiscono da soli.
-    ~Material() = default;
+    // Rilascia l'uniform buffer del materiale. Gli shared_ptr si gestiscono da soli.
+    ~Material();
 
-    // Metodi per impostare i parametri del materiale
-    void SetTexture(const std::string& uniformName, const std::shared_ptr<Texture>& texture);
+    Material(const Material&) = delete;
+    Material& operator=(const Material&) = delete;
+
+    // Metodi per impostare i parametri del materiale. Il nome viene risolto una volta sola
+    // in un UniformHandle, Use() lavora solo su handle e dati contigui.
+    // lodBias sposta la scelta del livello di mipmap (negativo = piu' nitido). Con le unita'
+    // di texture si applica con un sampler condiviso (SamplerCache), con gli shader a tabella
+    // va nel membro <nome>LodBias della riga.
+    void SetTexture(const std::string& uniformName, const std::shared_ptr<Texture>& texture, float lodBias = 0.0f);
     void SetFloat(const std::string& uniformName, float value);
     void SetVec3(const std::string& uniformName, const glm::vec3& value);
     void SetVec4(const std::string& uniformName, const glm::vec4& value);
@@ -26,13 +34,71 @@ public:
     // Metodo che applica lo stato del materiale per il rendering
     void Use() const;
 
+    const std::shared_ptr<Shader>& GetShader() const;
+
+    // Chiave a 16 bit dell'insieme di texture, per le sort key di RenderQueue
+    uint16_t GetTextureSetKey() const;
+
+    // Riga della MaterialTable del frame per gli shader a tabella (Shader::UsesMaterialTable):
+    // i parametri nel layout std140 dello shader, con i riferimenti alle texture aggiornati.
+    // Solo sul thread OpenGL.
+    const std::vector<unsigned char>& GetTableRow() const;
+    // Vero se i due materiali possono condividere una draw: stesse texture sulle stesse unita',
+    // oppure texture lette tramite riferimenti nella tabella
+    bool SharesTexturesWith(const Material& other) const;
+
 private:
+    // Tipi dei parametri fuori dal blocco MaterialParams
+    enum class ParameterType : unsigned char
+    {
+        Float,
+        Vec3,
+        Vec4,
+        Mat4
+    };
+
+    // Parametro nel blocco piatto: 'offset' e' l'indice del primo float in parameterData
+    struct Parameter
+    {
+        UniformHandle handle;
+        ParameterType type;
+        unsigned int offset;
+    };
+
+    // Con gli shader a riferimenti 'handle' non e' valido e la texture finisce nella riga della
+    // tabella, agli offset dei membri <nome>Handle, <nome>Array e <nome>Layer (-1 se assenti).
+    // Il rettangolo UV (Texture::GetUVRect) va nel membro <nome>Rect della tabella oppure
+    // nell'uniform <nome>Rect.
+    struct TextureBinding
+    {
+        UniformHandle handle;
+        UniformHandle rectHandle;
+        std::shared_ptr<Texture> texture;
+        // Sampler con il LOD bias del materiale, 0 per i parametri della texture
+        GLuint sampler = 0;
+        std::string name;
+        GLint handleOffset = -1;
+        GLint arrayOffset = -1;
+        GLint layerOffset = -1;
+        GLint rectOffset = -1;
+    };
+
     std::shared_ptr<Shader> shader;
 
-    // Mappe per memorizzare i parametri
-    std::map<std::string, std::shared_ptr<Texture>> textures;
-    std::map<std::string, float> floatUniforms;
-    std::map<std::string, glm::vec3> vec3Uniforms;
-    std::map<std::string, glm::vec4> vec4Uniforms;
-    std::map<std::string, glm::mat4> mat4Uniforms;
+    // Copia CPU del blocco std140 MaterialParams. Viene caricata nell'UBO solo quando cambia.
+    std::vector<unsigned char> blockData;
+    // Riga della tabella: blockData con i riferimenti alle texture, riscritti a ogni GetTableRow
+    mutable std::vector<unsigned char> tableRow;
+    unsigned int blockUBO = 0;
+    mutable bool blockDirty = false;
+
+    // Parametri che non fanno parte del blocco (uniform singoli), in memoria contigua
+    std::vector<Parameter> parameters;
+    std::vector<float> parameterData;
+    std::vector<TextureBinding> textures;
+
+    // Scrive il valore nel blocco se lo shader dichiara il membro con quel tipo
+    bool WriteBlockMember(const std::string& uniformName, GLenum type, const void* data, size_t size);
+    // Scrive il valore nel blocco piatto, aggiungendo il parametro al primo utilizzo
+    void WriteParameter(const std::string& uniformName, ParameterType type, const float* data, unsigned int floatCount);
 };
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <string>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 #include <glm/glm.hpp>
 #include <nlohmann/json.hpp>
 
@@ -13,6 +14,17 @@ class MaterialAsset : public Asset
 {
 public:
     MaterialAsset(const std::string& path);
+    // Costruisce l'asset da dati gia' letti con ReadData, senza rileggere il file
+    MaterialAsset(const std::string& path, const nlohmann::json& data);
+
+    // Legge il JSON del materiale: dal pack montato (MessagePack) se c'e', altrimenti dal file
+    static bool ReadData(const std::string& path, nlohmann::json& data);
+
+    // Hot reload: sostituisce il contenuto con i dati riletti e incrementa la versione, cosi'
+    // GetMaterial ricostruisce il Material. 'parent' serve solo alle istanze.
+    // Sul thread principale, tra due frame. Lancia nlohmann::json::exception se un campo ha il
+    // tipo sbagliato, lasciando l'asset invariato.
+    virtual void Reload(const nlohmann::json& data, const std::shared_ptr<MaterialAsset>& parent);
 
     const nlohmann::json& GetShaderPaths() const
     {
@@ -22,14 +34,35 @@ public:
     {
         return uniforms;
     }
+    // Define della variante dello shader ("defines" nel JSON), ordinati e senza duplicati
+    const std::vector<std::string>& GetDefines() const
+    {
+        return defines;
+    }
+    // Materiale da usare finche' gli shader non sono compilati ("fallback" nel JSON).
+    // Vuoto se non indicato: l'AssetManager usa DEFAULT_FALLBACK_MATERIAL.
+    const std::string& GetFallbackPath() const
+    {
+        return fallbackPath;
+    }
+    // Genitore di un'istanza ("parent" nel JSON), vuoto per i master material
+    const std::string& GetParentPath() const
+    {
+        return parentPath;
+    }
 
 protected:
     nlohmann::json shaderPaths;
+    std::vector<std::string> defines;
+    std::string fallbackPath;
+    std::string parentPath;
     nlohmann::json uniforms;
     nlohmann::json textureInfo;
 
     void LoadUniformsFromJson(const nlohmann::json& data);
     void LoadShaderPathsFromJson(const nlohmann::json& data);
+    void SortDefines();
+    void TakeContents(MaterialAsset& loaded);
 };
 
 // MaterialInstanceAsset  un'istanza che eredita da un MaterialAsset
@@ -37,4 +70,10 @@ class MaterialInstanceAsset : public MaterialAsset
 {
 public:
     MaterialInstanceAsset(const std::string& path, const std::shared_ptr<MaterialAsset>& parent);
+    MaterialInstanceAsset(const std::string& path, const nlohmann::json& data, const std::shared_ptr<MaterialAsset>& parent);
+
+    void Reload(const nlohmann::json& data, const std::shared_ptr<MaterialAsset>& parent) override;
+
+private:
+    void InheritFrom(const nlohmann::json& data, const std::shared_ptr<MaterialAsset>& parent);
 };
\ No newline at end of file
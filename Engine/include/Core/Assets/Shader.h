@@ -1,27 +1,141 @@
 #pragma once
 
 #include <glad/gl.h>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <map>
+#include <utility>
+#include <unordered_map>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <stdexcept>
 #include "Core/Assets/Asset.h"
 
+// Binding points of the uniform blocks shared by every shader
+const unsigned int FRAME_DATA_BINDING = 0;
+const unsigned int MATERIAL_PARAMS_BINDING = 1;
+
+// Names of the shared uniform blocks: per-frame constants (see Renderer) and per-material values (see Material)
+const char* const FRAME_DATA_BLOCK = "FrameData";
+const char* const MATERIAL_PARAMS_BLOCK = "MaterialParams";
+
+// Storage blocks of the multi-draw-indirect path. Instead of MaterialParams a shader can declare
+//     layout (std140, binding = 2) readonly buffer MaterialTable { Params materials[]; };
+//     layout (std430, binding = 3) readonly buffer DrawMaterials { uint drawMaterials[]; };
+// and read its parameters from materials[drawMaterials[gl_DrawID]], so draws of different
+// materials can share one glMultiDrawElementsIndirect call. Params follows the std140 rules, so an
+// entry has the layout a MaterialParams block with the same members would have.
+const unsigned int MATERIAL_TABLE_BINDING = 2;
+const unsigned int DRAW_MATERIALS_BINDING = 3;
+const char* const MATERIAL_TABLE_BLOCK = "MaterialTable";
+
+// GL_KHR_parallel_shader_compile (and its ARB twin): the driver compiles and links on its own
+// threads, and the status of a shader or program can be polled without waiting for them.
+// Not part of the core profile, so the generated GL header does not define it.
+const GLenum COMPLETION_STATUS_KHR = 0x91B1;
+
+// Final source of each stage (includes and defines applied), ordered by stage type
+using ShaderSources = std::vector<std::pair<GLenum, std::string>>;
+
+// How the constructor builds the program
+enum class ShaderCompileMode
+{
+    Blocking,   // compiled, linked and checked before the constructor returns
+    Parallel    // submitted to the driver and finished later, see Shader::IsReady
+};
+
+// Member of a std140 uniform block, as reported by program introspection
+struct UniformBlockMember
+{
+    GLint offset;
+    GLenum type;
+};
+
+// Layout of a uniform block. An empty layout (size 0) means the block is not used by the program.
+struct UniformBlockLayout
+{
+    GLint size = 0;
+    std::unordered_map<std::string, UniformBlockMember> members;
+};
+
+// Compact handle to a uniform, resolved once by name with Shader::GetUniformHandle.
+// Setting a uniform through a handle costs no lookup and no string work.
+struct UniformHandle
+{
+    GLint location = -1;
+
+    bool IsValid() const
+    {
+        return location != -1;
+    }
+};
+
 class Shader : public Asset
 {
 public:
-    // Maps shader paths per type (ie. GL_VERTEX_SHADER, GL_FRAGMENT_SHADER)
-    Shader(const std::map<unsigned int, std::string>& shaderPaths);
+    // Maps shader paths per type (ie. GL_VERTEX_SHADER, GL_FRAGMENT_SHADER). 'defines' select the
+    // permutation: each one becomes "#define <define>" in every stage, so "NAME VALUE" works too.
+    // Sources may use #include "file", see ResolveIncludes.
+    // Sources that cannot be read throw in both modes; compile and link errors throw here only in
+    // Blocking mode.
+    Shader(const std::map<unsigned int, std::string>& shaderPaths, const std::vector<std::string>& defines = {},
+        ShaderCompileMode mode = ShaderCompileMode::Blocking);
+    // Builds the program from sources already prepared with LoadSources
+    Shader(const ShaderSources& sources, ShaderCompileMode mode = ShaderCompileMode::Blocking);
     ~Shader();
 
+    // Reads every stage and applies includes and defines. Throws if a file cannot be read.
+    // 'files', if given, receives every file read: the stages and the files they include.
+    static ShaderSources LoadSources(const std::map<unsigned int, std::string>& shaderPaths, const std::vector<std::string>& defines,
+        std::vector<std::string>* files = nullptr);
+    // Hash (XXH64) of the stage types and final sources: programs with the same key are identical
+    // whatever paths they were loaded from
+    static uint64_t ComputeContentKey(const ShaderSources& sources);
+    uint64_t GetContentKey() const;
+
+    // Polls a Parallel build without blocking when the driver supports parallel compilation; the
+    // first call that finds the program linked checks it and runs the introspection below.
+    // Without the extension the first call waits for the driver. Render thread only.
+    // False while the driver is still working and after a failed build.
+    bool IsReady();
+    // Waits for the build to end. Throws if a stage does not compile or the program does not link.
+    void WaitUntilReady();
+    bool HasFailed() const;
+
+    // Checks GL_KHR_parallel_shader_compile once, after the GL loader and before any shader.
+    // Without it (or on the null GL backend) Parallel builds finish on the first IsReady call.
+    static void InitializeParallelCompile(GLADloadfunc load);
+    static bool IsParallelCompileSupported();
+
+    // Hot reload: takes the program of 'source', which must be ready, and hands it the current
+    // one, released with 'source'. Everyone holding this shader draws with the new program from
+    // the next bind; the version is incremented because the material block layout may have
+    // changed. Render thread only, between two frames.
+    void TakeProgram(Shader& source);
+
     // Activates the shader
     void Use() const;
     // Getter function for shader ID
     unsigned int GetID() const;
 
     GLint GetUniformLocation(const std::string& name) const;
+    UniformHandle GetUniformHandle(const std::string& name) const;
+
+    // Handle of the per-draw "model" matrix, resolved after linking
+    UniformHandle GetModelHandle() const;
+
+    // Layout of the MaterialParams block, queried once after linking. For shaders that use the
+    // material table it is the layout of one table entry, 'size' being the array stride.
+    const UniformBlockLayout& GetMaterialBlockLayout() const;
+    // True if the parameters come from the MaterialTable storage block
+    bool UsesMaterialTable() const;
+    // True if the table entry references its textures ("<sampler>Handle", "<sampler>Array" and
+    // "<sampler>Layer" members, see TextureReferences) instead of sampler uniforms
+    bool UsesTextureReferences() const;
+
+    // Adds "#define name" after the #version line of every shader compiled from now on
+    static void AddGlobalDefine(const std::string& name);
 
     // API to set the uniforms
 
@@ -33,13 +147,43 @@ public:
     void SetVec4(const std::string& name, const glm::vec4& value) const;
     void SetMat4(const std::string& name, const glm::mat4& mat) const;
 
+    // Same API through resolved handles, meant for per-draw code
+    void SetInt(UniformHandle handle, int value) const;
+    void SetFloat(UniformHandle handle, float value) const;
+    void SetVec3(UniformHandle handle, const glm::vec3& value) const;
+    void SetVec4(UniformHandle handle, const glm::vec4& value) const;
+    void SetMat4(UniformHandle handle, const glm::mat4& mat) const;
+
 private:
     unsigned int id;
 
-    std::string LoadShaderSource(const std::string& path) const;
+    // Build state: the stages stay attached until the link has been checked
+    std::vector<std::pair<GLenum, unsigned int>> pendingStages;
+    uint64_t contentKey = 0;
+    bool ready = false;
+    bool failed = false;
+
+    static std::string LoadShaderSource(const std::string& path);
+    static std::string ResolveIncludes(const std::string& source, const std::string& path, int sourceIndex, std::vector<std::string>& included);
+    static std::string ApplyDefines(std::string source, const std::vector<std::string>& defines);
+    void SubmitStages(const ShaderSources& sources);
+    void FinishBuild();
+    void ReleaseStages();
+    void QueryProgramInterface();
     unsigned int CompileShader(unsigned int type, const std::string& source) const;
     void CheckErrors(unsigned int shader, const std::string& type) const;
+    void BindUniformBlock(const std::string& blockName, unsigned int binding) const;
+    UniformBlockLayout QueryUniformBlockLayout(const std::string& blockName) const;
+    UniformBlockLayout QueryMaterialTableLayout() const;
+
+    UniformBlockLayout materialBlockLayout;
+    bool usesMaterialTable = false;
+    bool usesTextureReferences = false;
+
+    static std::vector<std::string> globalDefines;
+    static bool parallelCompile;
+    UniformHandle modelHandle;
 
     // Caches the location of uniforms for performance optimization
-    mutable std::map<std::string, GLint> uniformCache;
+    mutable std::unordered_map<std::string, GLint> uniformCache;
 };
\ No newline at end of file
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <atomic>
 #include <string>
+#include <vector>
 #include "Core/Assets/Asset.h"
 
 enum class TextureFilter
@@ -10,14 +13,76 @@ enum class TextureFilter
     SMOOTH
 };
 
+// Modalita' di caricamento di una texture
+enum class TextureLoad
+{
+    Immediate,  // decodifica e upload nel costruttore, solo sul thread OpenGL
+    Streamed    // nessuna chiamata GL: i pixel arrivano dopo tramite il TextureUploader
+};
+
+// Dove finiscono i pixel di una texture
+enum class TexturePacking
+{
+    Standalone, // una texture OpenGL propria
+    Atlas       // se e' abbastanza piccola, un rettangolo in una pagina del TextureAtlas
+};
+
+struct TextureReference;
+
+// Un livello di mipmap di un'immagine, offset rispetto a TextureImage::Data()
+struct TextureLevel
+{
+    size_t offset;
+    size_t size;
+};
+
+// Pixel decodificati in memoria di staging, RGBA8 con la prima riga in basso, oppure blocchi
+// BC1/BC3 gia' cotti dall'AssetCooker (vedi TextureCompression)
+struct TextureImage
+{
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> pixels;
+    // Pixel letti sul posto da un AssetPack mappato in memoria: in questo caso 'pixels' e' vuoto
+    const unsigned char* mapped = nullptr;
+    // Formato dei blocchi, 0 per i pixel RGBA8
+    GLenum compressedFormat = 0;
+    // Catena di mipmap gia' calcolata, livello 0 compreso, uno dopo l'altro nello stesso buffer.
+    // Sempre presente per le immagini compresse; vuota se esiste solo il livello 0 (le mipmap
+    // vengono allora generate sulla GPU, vedi Texture::GenerateMipmaps).
+    std::vector<TextureLevel> levels;
+
+    const unsigned char* Data() const
+    {
+        return mapped ? mapped : pixels.data();
+    }
+    size_t GetSize() const
+    {
+        if (!levels.empty())
+        {
+            return levels.back().offset + levels.back().size;
+        }
+        return static_cast<size_t>(width) * height * 4;
+    }
+    bool IsCompressed() const
+    {
+        return compressedFormat != 0;
+    }
+};
+
 class Texture : public Asset
 {
 public:
     /**
      * @brief Carica una texture da un file immagine.
      * @param path Percorso del file immagine.
+     * @param load Con TextureLoad::Streamed il costruttore non tocca OpenGL e la texture
+     *             mostra il placeholder finche' il TextureUploader non ha caricato i pixel.
+     * @param packing Con TexturePacking::Atlas le immagini piccole vengono copiate in una pagina
+     *                condivisa: GetID restituisce la pagina e GetUVRect il rettangolo.
      */
-    Texture(const std::string& path, TextureFilter filter = TextureFilter::SMOOTH);
+    Texture(const std::string& path, TextureFilter filter = TextureFilter::SMOOTH, TextureLoad load = TextureLoad::Immediate,
+        TexturePacking packing = TexturePacking::Standalone);
 
     /**
      * @brief Distruttore che dealloca la risorsa OpenGL.
@@ -25,10 +90,103 @@ public:
     ~Texture();
 
     /**
-     * @brief Restituisce l'ID della texture OpenGL.
+     * @brief Restituisce l'ID della texture OpenGL, o quello del placeholder se l'upload non e' finito.
      */
     unsigned int GetID() const;
 
+    /**
+     * @brief True quando tutti i pixel sono stati caricati sulla GPU.
+     */
+    bool IsResident() const;
+
+    /**
+     * @brief True se la decodifica in streaming e' fallita: la texture resta sul placeholder
+     * e non ricevera' altri upload. Si puo' chiamare da qualsiasi thread.
+     */
+    bool HasLoadFailed() const;
+
+    TextureFilter GetFilter() const;
+    TexturePacking GetPacking() const;
+
+    /**
+     * @brief Vero se i pixel stanno in una pagina del TextureAtlas.
+     */
+    bool IsAtlased() const;
+
+    /**
+     * @brief Rettangolo UV della texture dentro GetID() (offset in xy, dimensione in zw).
+     * (0, 0, 1, 1) per le texture non in atlas e per il placeholder. Gli shader lo applicano
+     * alle coordinate tramite l'uniform o il membro della tabella "<sampler>Rect".
+     * Puo' cambiare quando il TextureAtlas ricompatta le pagine.
+     */
+    glm::vec4 GetUVRect() const;
+
+    /**
+     * @brief Handle bindless o layer di una texture array per gli shader a tabella (vedi TextureReferences).
+     * Finche' l'upload non e' finito restituisce quello del placeholder. Solo sul thread OpenGL.
+     */
+    TextureReference GetReference() const;
+
+    /**
+     * @brief Decodifica un file immagine in RGBA8. Non usa OpenGL, quindi si puo' chiamare dai worker.
+     * Se il percorso sta in un AssetPack montato restituisce i pixel gia' decodificati, senza copia.
+     * Le texture compresse dal cooker restano in blocchi BC1/BC3 se il driver supporta S3TC,
+     * altrimenti vengono decompresse qui in RGBA8.
+     * Lancia std::runtime_error se il file non si puo' leggere.
+     */
+    static TextureImage Decode(const std::string& path);
+
+    /**
+     * @brief Prende i pixel di 'source', gia' residente, al posto dei propri (hot reload).
+     * Chi tiene questa texture vede la nuova immagine dal frame successivo, 'source' resta vuota.
+     * Filtro e packing devono essere gli stessi. Solo sul thread OpenGL, tra due frame.
+     */
+    void TakeContents(Texture& source);
+
+    /**
+     * @brief Calcola sulla CPU la catena di mipmap fino a 1x1 con un filtro box 2x2 e la accoda
+     * ai pixel. Pensata per i worker: il thread OpenGL carica i livelli gia' pronti invece di
+     * chiamare glGenerateTextureMipmap. Non fa nulla sulle immagini che hanno gia' i livelli.
+     */
+    static void GenerateMipmaps(TextureImage& image);
+
+    /**
+     * @brief Texture 2x2 a scacchi mostrata al posto delle texture non ancora caricate.
+     * Creata al primo uso sul thread OpenGL.
+     */
+    static unsigned int GetPlaceholderID();
+    static void DestroyPlaceholder();
+
 private:
-    unsigned int id;
-};
\ No newline at end of file
+    friend class AssetManager;
+    friend class TextureUploader;
+    friend class TextureAtlas;
+
+    unsigned int id = 0;
+    int width = 0;
+    int height = 0;
+    GLsizei levels = 1;
+    GLenum internalFormat = GL_RGBA8;
+    TextureFilter filter;
+    TexturePacking packing;
+    bool resident = false;
+    // Scritto dal worker che decodifica, letto dal thread OpenGL
+    std::atomic<bool> loadFailed = false;
+
+    // In atlas 'id' e' la pagina, che appartiene al TextureAtlas. 'atlasRect' e' il rettangolo
+    // in pixel con il bordo, 'uvRect' la parte visibile in coordinate della pagina.
+    bool atlased = false;
+    glm::ivec4 atlasRect = glm::ivec4(0);
+    glm::vec4 uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+
+    // Libera la texture OpenGL o il rettangolo nella pagina dell'atlas
+    void ReleaseStorage();
+    // Alloca lo storage immutabile e imposta i parametri di campionamento. Con levelCount 0
+    // la catena di mipmap e' completa per il filtro SMOOTH.
+    void CreateStorage(int width, int height, GLenum internalFormat = GL_RGBA8, GLsizei levelCount = 0);
+    // Chiamato dopo l'ultima riga caricata. Senza la catena di mipmap dall'immagine le mipmap
+    // del filtro SMOOTH vengono generate qui sulla GPU.
+    void FinishUpload(bool generateMipmaps = true);
+    // Carica in una volta tutti i livelli di un'immagine compressa, niente glGenerateTextureMipmap
+    void UploadCompressed(const TextureImage& image);
+};
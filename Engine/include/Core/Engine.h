@@ -6,6 +6,7 @@
 #include "Core/Renderer.h"
 
 #include <iostream>
+#include <string>
 
 // Componenti di base per la trasformazione e la grafica
 struct Position
@@ -31,25 +32,63 @@ struct SpriteRef
     unsigned int spriteID;
 };
 
+// Modalita' di esecuzione del motore
+enum class EngineMode
+{
+    Windowed,   // finestra GLFW e contesto OpenGL reale
+    Headless    // nessuna finestra ne' GPU: il backend GL nullo conta le chiamate (vedi NullGL.h)
+};
+
 class Engine
 {
 public:
-    Engine(int width, int height, const char* title);
+    Engine(int width, int height, const char* title, EngineMode mode = EngineMode::Windowed);
     ~Engine();
 
+    // Esegue frame finche' la finestra non viene chiusa. Solo in modalita' Windowed.
     void Run();
+    // Esegue esattamente 'frameCount' frame. In modalita' Headless il tempo avanza a passo fisso,
+    // cosi' due esecuzioni producono lo stesso lavoro.
+    void RunFrames(unsigned int frameCount);
+
     flecs::world& GetWorld();
+    bool IsHeadless() const;
+
+    // Scrive la traccia del profiler (formato Chrome trace, vedi Profiler.h) alla fine del frame
+    // corrente. Con un percorso vuoto usa "profile_<frame>.json". In finestra si attiva con F12.
+    void RequestProfilerCapture(const std::string& path = "");
+
+    // Statistiche mobili (min/media/p99 in ms) sugli ultimi frame. Confrontando il tempo CPU
+    // di RenderFrame con lo scope GPU "Frame" si capisce se il frame e' limitato da CPU o GPU.
+    // I tempi GPU arrivano con qualche frame di ritardo (vedi GpuTimer).
+    TimingStats GetCpuFrameStatistics() const;
+    std::vector<TimingStats> GetGpuStatistics() const;
+    // Draw e cambi di stato dell'ultimo frame, con quelli evitati dall'ordinamento della RenderQueue
+    const RenderQueueStats& GetRenderQueueStats() const;
+    // Stampa le statistiche CPU e GPU, una riga per scope, seguite dai programmi in cache
+    void LogFrameStatistics(std::ostream& out = std::cout) const;
 
 private:
-    GLFWwindow* window;
+    GLFWwindow* window = nullptr;
     flecs::world world;
     Renderer* renderer;
 
+    EngineMode mode;
+    int width, height;
+    unsigned long long frameIndex = 0;
+    std::string pendingProfilerCapture;
+    bool profilerCaptureRequested = false;
+    RollingStatistics cpuFrameStatistics;
+
     double lastFrameTime = 0.0;
     int frameCount = 0;
     double frameRate = 0.0;
     
     void MainLoop();
+    void RenderFrame();
+    void SwapAndPollEvents();
+    void FinishFrame();
+    float GetFrameTime() const;
     void UpdateStats();
     void RegisterEngineComponents();
 };
\ No newline at end of file
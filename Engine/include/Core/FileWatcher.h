@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Watches a directory tree on a background thread and collects the files written in it.
+// On Linux the kernel reports the changes through inotify: a file counts as changed when it is
+// closed after writing (IN_CLOSE_WRITE) or renamed into place (IN_MOVED_TO, the way many editors
+// save), so a half-written file is never reported. Elsewhere the thread compares modification
+// times every POLL_INTERVAL_MS.
+class FileWatcher
+{
+public:
+    static const int POLL_INTERVAL_MS = 250;
+
+    FileWatcher() = default;
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Watches 'root' and every directory under it, including directories created later.
+    // Returns false and prints the reason if the directory cannot be watched.
+    bool Start(const std::string& root);
+    void Stop();
+    bool IsWatching() const;
+
+    // Thread safe. Files changed since the last call, each reported once, as 'root' joined with
+    // the relative path in generic form (e.g. "Resources/Shaders/Basic/Quad.frag").
+    std::vector<std::string> TakeChanges();
+
+private:
+    std::filesystem::path root;
+    std::thread thread;
+    std::atomic<bool> stopRequested = false;
+
+    std::set<std::string> changes;
+    std::mutex changesMutex;
+
+#ifdef __linux__
+    int descriptor = -1;
+    // Directory of each watch descriptor
+    std::unordered_map<int, std::filesystem::path> watches;
+
+    void AddWatches(const std::filesystem::path& directory, bool reportFiles);
+    void ReadEvents();
+#else
+    // Last write time of every file, compared at each scan
+    std::unordered_map<std::string, std::filesystem::file_time_type> writeTimes;
+
+    void Scan(bool reportChanges);
+#endif
+
+    void WatchThread();
+    void AddChange(const std::filesystem::path& path);
+};
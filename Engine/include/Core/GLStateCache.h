@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <cstdint>
+
+// Shadow copy of the GL bindings changed most often while drawing. A bind that matches the
+// cached value is skipped.
+// The cache only knows about binds that go through it: Invalidate must be called after code
+// that binds these objects directly, or deletes an object that may still be cached (GL can
+// hand out the same name again). Renderer::BeginFrame invalidates it once per frame.
+// Render thread only.
+class GLStateCache
+{
+public:
+    static const unsigned int MAX_TEXTURE_UNITS = 32;
+
+    static GLStateCache& GetInstance();
+
+    void UseProgram(GLuint program);
+    // DSA bind (glBindTextureUnit), no glActiveTexture needed
+    void BindTextureUnit(GLuint unit, GLuint texture);
+    // 0 restores the sampling parameters of the texture itself
+    void BindSampler(GLuint unit, GLuint sampler);
+    void BindVertexArray(GLuint vao);
+
+    // Forgets every cached binding, the next bind of each kind always reaches GL
+    void Invalidate();
+
+    // Binds that reached GL and binds skipped since the last ResetCounters
+    uint64_t GetIssuedCount() const;
+    uint64_t GetElidedCount() const;
+    void ResetCounters();
+
+private:
+    GLStateCache();
+
+    static const GLuint UNKNOWN = ~0u;
+
+    GLuint program = UNKNOWN;
+    GLuint vertexArray = UNKNOWN;
+    GLuint textures[MAX_TEXTURE_UNITS];
+    GLuint samplers[MAX_TEXTURE_UNITS];
+
+    uint64_t issued = 0;
+    uint64_t elided = 0;
+};
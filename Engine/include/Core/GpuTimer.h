@@ -0,0 +1,99 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+#include "Core/RollingStatistics.h"
+
+// GPU timings of render passes and batches through GL_TIMESTAMP queries.
+// A scope writes a timestamp when it begins and one when it ends, so scopes can nest (a batch
+// inside its pass inside the frame), which GL_TIME_ELAPSED queries cannot.
+// Queries are pooled per frame in flight: the results of a frame are read when its slot comes
+// around again, framesInFlight frames later, and only if the GPU already wrote them. A frame
+// whose results are not ready is dropped instead of stalling the CPU.
+class GpuTimer
+{
+public:
+    static const unsigned int INVALID_SCOPE = ~0u;
+
+    GpuTimer(unsigned int framesInFlight = 3, size_t historySize = 240);
+    ~GpuTimer();
+
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+    // Collects the results of the frame that last used the current slot and opens the "Frame" scope
+    void BeginFrame();
+    // Closes the "Frame" scope and moves to the next slot
+    void EndFrame();
+
+    // 'name' must outlive the timer, in practice a string literal. A non negative 'id' is appended
+    // to the name ("SpriteBatch #3") to tell apart the instances of the same scope.
+    unsigned int BeginScope(const char* name, int id = -1);
+    void EndScope(unsigned int scope);
+
+    // Rolling min/avg/p99 of every scope seen so far, in milliseconds, sorted by name
+    std::vector<TimingStats> GetStatistics() const;
+    // Statistics of one scope; samples is 0 if it was never measured
+    TimingStats GetStatistics(const std::string& name) const;
+
+    // Frames whose results were not ready when their slot was reused
+    size_t GetDroppedFrameCount() const;
+
+    // A disabled timer issues no queries; statistics collected so far are kept
+    void SetEnabled(bool enabled);
+    bool IsEnabled() const;
+
+private:
+    struct Scope
+    {
+        const char* name;
+        int id;
+        unsigned int beginQuery;
+        unsigned int endQuery;
+    };
+
+    struct FrameSlot
+    {
+        std::vector<GLuint> queries;
+        unsigned int usedQueries = 0;
+        std::vector<Scope> scopes;
+    };
+
+    std::vector<FrameSlot> frames;
+    unsigned int currentFrame = 0;
+    unsigned int frameScope = INVALID_SCOPE;
+    bool enabled = true;
+    size_t historySize;
+    size_t droppedFrames = 0;
+
+    std::map<std::string, RollingStatistics, std::less<>> statistics;
+    std::vector<GLuint64> timestamps;
+    std::string nameBuffer;
+
+    unsigned int IssueTimestamp(FrameSlot& frame);
+    void CollectResults(FrameSlot& frame);
+};
+
+// Times the enclosing scope on the GPU
+class GpuZone
+{
+public:
+    GpuZone(GpuTimer& timer, const char* name, int id = -1) : timer(timer), scope(timer.BeginScope(name, id))
+    {
+    }
+
+    ~GpuZone()
+    {
+        timer.EndScope(scope);
+    }
+
+    GpuZone(const GpuZone&) = delete;
+    GpuZone& operator=(const GpuZone&) = delete;
+
+private:
+    GpuTimer& timer;
+    unsigned int scope;
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// XXH64: fast non-cryptographic 64-bit hash, several GB/s on small inputs like shader sources.
+// Matches the reference implementation, so keys can be checked with the xxhsum tool.
+// Not suitable when an attacker chooses the input.
+uint64_t Hash64(const void* data, size_t size, uint64_t seed = 0);
+
+inline uint64_t Hash64(std::string_view text, uint64_t seed = 0)
+{
+    return Hash64(text.data(), text.size(), seed);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+// Counters collected by the null GL backend
+struct GLCallStats
+{
+    uint64_t calls = 0;             // every GL entry point, including the ones that are plain no-ops
+    uint64_t drawCalls = 0;
+    uint64_t instances = 0;         // instances submitted by the draw calls, 1 for non instanced draws
+    uint64_t stateChanges = 0;      // program, VAO, buffer, texture and sampler bindings, fixed function state
+    uint64_t uniformUpdates = 0;    // glUniform* and glProgramUniform*
+    uint64_t bytesUploaded = 0;     // buffer and texture data passed to the API; writes to mapped memory are not counted
+};
+
+// Fills the glad function table with a GL 4.6 implementation that never touches a GPU.
+// Calls are counted, objects get unique names, compile and link always succeed and buffer
+// storage is backed by system memory so persistent mappings stay writable. Uniform locations
+// are handed out for any name; uniform block introspection reports no blocks.
+// Only the entry points the engine uses are implemented, each with its exact signature; the
+// others stay null.
+// Lets the engine run headless on machines without a GPU or a display.
+bool LoadNullGL();
+
+const GLCallStats& GetNullGLStats();
+void ResetNullGLStats();
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <cstddef>
+#include <vector>
+
+// GPU buffer created with immutable storage and mapped once for the lifetime of the object.
+// The storage is split in one slot per frame in flight: the CPU writes the current slot while
+// the GPU reads the previous ones, and a fence per slot keeps the two from overlapping.
+class PersistentRingBuffer
+{
+public:
+    PersistentRingBuffer(size_t slotSize, unsigned int slotCount = 3);
+    ~PersistentRingBuffer();
+
+    PersistentRingBuffer(const PersistentRingBuffer&) = delete;
+    PersistentRingBuffer& operator=(const PersistentRingBuffer&) = delete;
+
+    // Waits until the GPU is done with the current slot and rewinds it
+    void BeginFrame();
+    // Fences the commands that read the current slot and moves to the next one
+    void EndFrame();
+
+    // Reserves 'size' bytes in the current slot at an absolute buffer offset that is a multiple
+    // of 'alignment'. Returns the mapped pointer and writes that offset to 'offset', or returns
+    // nullptr if the slot is full.
+    void* Allocate(size_t size, size_t alignment, size_t& offset);
+
+    // Grows every slot to at least 'slotSize' bytes. Waits for all frames in flight and
+    // recreates the storage, so previous allocations are invalidated.
+    void Reserve(size_t slotSize);
+
+    unsigned int GetID() const;
+    size_t GetSlotSize() const;
+
+private:
+    unsigned int id = 0;
+    size_t slotSize;
+    unsigned int slotCount;
+    unsigned int currentSlot = 0;
+    size_t slotHead = 0;
+    unsigned char* mapped = nullptr;
+    std::vector<GLsync> fences;
+
+    void CreateStorage();
+    void DestroyStorage();
+    void WaitForSlot(unsigned int slot);
+};
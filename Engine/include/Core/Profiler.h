@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Scoped-zone CPU profiler.
+// Each thread records completed zones into its own fixed-size ring, so recording takes no lock
+// and never allocates after the first zone of a thread. When a ring is full the oldest zones are
+// overwritten: a capture always holds the most recent history of every thread.
+// Timestamps are nanoseconds from a steady clock. WriteChromeTrace dumps every ring as Chrome
+// trace JSON, which chrome://tracing, Perfetto and Speedscope can open.
+//
+// Zones are compiled in when ENGINE_PROFILER_ENABLED is defined (CMake option ENGINE_PROFILER,
+// on by default in every configuration) and can be switched off at runtime with SetEnabled.
+class Profiler
+{
+public:
+    // Nanoseconds elapsed since the profiler was first used
+    static int64_t Now();
+
+    // Records a completed zone on the calling thread. 'name' must outlive the profiler,
+    // in practice a string literal.
+    static void Record(const char* name, int64_t start, int64_t end);
+
+    // Name shown for the calling thread in the trace
+    static void SetThreadName(const std::string& name);
+
+    static void SetEnabled(bool enabled);
+    static bool IsEnabled();
+
+    // Writes the zones currently held by all threads. Safe to call while other threads are
+    // recording; zones overwritten during the copy are dropped. Returns false on I/O errors.
+    static bool WriteChromeTrace(const std::string& path);
+
+    // Drops every recorded zone
+    static void Clear();
+};
+
+// Records the lifetime of the enclosing scope
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char* name) : name(name), start(Profiler::Now())
+    {
+    }
+
+    ~ProfileZone()
+    {
+        Profiler::Record(name, start, Profiler::Now());
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* name;
+    int64_t start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#ifdef ENGINE_PROFILER_ENABLED
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#endif
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <cstdint>
+#include <string>
+
+// Folder of the program binaries, relative to the working directory of the game
+const char* const PROGRAM_BINARY_CACHE_DIRECTORY = "ShaderCache";
+
+// File of a cached program: this header followed by 'size' bytes of glGetProgramBinary output
+const char PROGRAM_BINARY_MAGIC[4] = { 'C', 'E', 'P', 'B' };
+const uint32_t PROGRAM_BINARY_VERSION = 1;
+
+struct ProgramBinaryHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t size;
+};
+static_assert(sizeof(ProgramBinaryHeader) == 24, "ProgramBinaryHeader is part of the file format");
+
+// Persistent cache of linked programs. An entry is keyed by the content key of the program (see
+// Shader::ComputeContentKey) and the driver vendor, renderer and version strings: an edited
+// shader or a driver update is a plain miss and the program is compiled again.
+// Render thread only.
+class ProgramBinaryCache
+{
+public:
+    static ProgramBinaryCache& GetInstance();
+
+    // Enables the cache in 'directory' (created on the first store) if the driver exposes at
+    // least one program binary format. Call once after the GL loader, before the first shader.
+    void Initialize(const std::string& directory);
+    bool IsEnabled() const;
+
+    uint64_t ComputeKey(uint64_t contentKey) const;
+
+    // Loads the cached binary into 'program'. Returns false on a miss or when the driver rejects
+    // the binary; the program must then be built from source.
+    bool Load(uint64_t key, GLuint program);
+    // Saves a linked program. Set GL_PROGRAM_BINARY_RETRIEVABLE_HINT before linking it.
+    void Store(uint64_t key, GLuint program);
+
+    uint64_t GetHitCount() const;
+    uint64_t GetMissCount() const;
+
+private:
+    ProgramBinaryCache() = default;
+
+    std::string GetEntryPath(uint64_t key) const;
+
+    std::string directory;
+    uint64_t driverHash = 0;
+    bool enabled = false;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Material;
+class GpuTimer;
+
+// Layout of one command in a GL_DRAW_INDIRECT_BUFFER for glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+static_assert(sizeof(DrawElementsIndirectCommand) == 20, "DrawElementsIndirectCommand must match the GL layout");
+
+// Range of a buffer bound to an indexed GL_SHADER_STORAGE_BUFFER binding; buffer 0 binds nothing
+struct StorageRange
+{
+    GLuint buffer = 0;
+    GLintptr offset = 0;
+    GLsizeiptr size = 0;
+};
+
+// One deferred indexed draw of 'indexCount' GL_UNSIGNED_INT indices from the VAO's element buffer,
+// or, when drawCount is not zero, 'drawCount' DrawElementsIndirectCommands read from
+// 'indirectBuffer' at 'indirectOffset'
+struct DrawCommand
+{
+    uint64_t sortKey = 0;
+    // Must stay alive until the queue is flushed; the AssetManager material cache keeps it
+    const Material* material = nullptr;
+    GLuint vertexArray = 0;
+    GLsizei indexCount = 0;
+    GLsizei instanceCount = 1;
+    GLuint baseInstance = 0;
+    // Per draw "model" uniform of the material shader, only set when hasModel is true
+    bool hasModel = false;
+    glm::mat4 model = glm::mat4(1.0f);
+    // Multi draw indirect
+    GLuint indirectBuffer = 0;
+    GLintptr indirectOffset = 0;
+    GLsizei drawCount = 0;
+    // Material table and per draw material indices, see MATERIAL_TABLE_BLOCK in Shader.h
+    StorageRange materialTable;
+    StorageRange drawMaterials;
+    // GpuTimer scope around the draw, nullptr for an untimed draw
+    const char* gpuScope = nullptr;
+    int gpuScopeId = -1;
+};
+
+// What the last Flush submitted and what it avoided
+struct RenderQueueStats
+{
+    size_t commands = 0;
+    size_t draws = 0;                   // draws executed by the GPU, each indirect command counts
+    size_t materialChanges = 0;         // Material::Use calls
+    size_t materialChangesSaved = 0;    // draws that reused the material of the previous draw
+    uint64_t stateChanges = 0;          // program, texture and VAO binds that reached GL
+    uint64_t stateChangesSaved = 0;     // binds skipped by GLStateCache
+};
+
+// Deferred draw queue. Systems submit draws during the frame, Flush sorts them by key and
+// replays them, so draws sharing a shader, textures and VAO run back to back and the
+// redundant binds between them are skipped.
+class RenderQueue
+{
+public:
+    // Key layout, most significant first: layer (8 bits), shader (16), texture set (16),
+    // depth (24). Draws are ordered by layer first, so a layer is the unit of draw order for
+    // blending; inside a layer the state comes before depth.
+    static uint64_t MakeSortKey(uint8_t layer, uint16_t shader, uint16_t textureSet, uint32_t depth);
+
+    void Submit(const DrawCommand& command);
+
+    // Sorts, draws and clears the queue. Each timed command gets its own scope in 'gpuTimer',
+    // which may be null.
+    void Flush(GpuTimer* gpuTimer);
+
+    size_t GetPendingCount() const;
+    const RenderQueueStats& GetLastFlushStats() const;
+
+private:
+    struct SortEntry
+    {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    std::vector<DrawCommand> commands;
+    std::vector<SortEntry> entries;
+    std::vector<SortEntry> scratch;
+    RenderQueueStats lastStats;
+
+    // Stable LSD radix sort of 'entries' by key, one byte per pass
+    void SortEntries();
+};
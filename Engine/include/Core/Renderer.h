@@ -6,6 +6,20 @@
 #include "Assets/Texture.h"
 #include "Assets/MaterialAsset.h"
 #include "AssetManager.h"
+#include "GpuTimer.h"
+#include "RenderQueue.h"
+
+// Content of the std140 FrameData block shared by every shader
+struct FrameData
+{
+    glm::mat4 projection;
+    float time;
+    float padding[3];
+};
+
+// Layers of the render queue sort key, drawn in this order
+const uint8_t SPRITE_LAYER = 0;
+const uint8_t OVERLAY_LAYER = 1;
 
 // Basic class that manages rendering pipeline
 class Renderer
@@ -14,10 +28,28 @@ public:
     Renderer();
     ~Renderer();
 
+    // Uploads the per-frame constants and binds them for the whole frame.
+    // width and height are the framebuffer size in pixels, used for the projection.
+    void BeginFrame(float time, int width, int height);
+    // Draws everything submitted during the frame, then closes the GPU timings of the frame
+    void EndFrame();
+
+    // Queues a quad on the overlay layer, drawn by EndFrame
     void DrawSingleColoredQuad(const std::shared_ptr<MaterialAsset>& materialAsset, const glm::vec2& position, float scale);
 
+    // Queues a draw, see RenderQueue::MakeSortKey for the ordering
+    void Submit(const DrawCommand& command);
+    // Commands and state changes of the last frame, including the binds the queue saved
+    const RenderQueueStats& GetRenderQueueStats() const;
+
+    // Timestamp queries of the frame, the passes and the material batches
+    GpuTimer& GetGpuTimer();
+
 private:
     unsigned int quadVAO, quadVBO, EBO;
+    unsigned int frameUBO;
+    GpuTimer gpuTimer;
+    RenderQueue renderQueue;
 
     void InitBuffers();
 };
\ No newline at end of file
@@ -4,14 +4,36 @@
 #include <glm/glm.hpp>
 #include <vector>
 #include <map>
+#include <cstdint>
 #include "Engine.h"
 
-// Struttura dei dati per l'instancing
+// Struttura dei dati per l'instancing (24 byte). La matrice di trasformazione viene
+// ricostruita nel vertex shader a partire da posizione, scala e rotazione.
 struct InstancedData
 {
-    glm::mat4 model;
-    unsigned int textureID;
+    glm::vec2 position;
+    uint32_t scale;         // due half float, x nei 16 bit bassi
+    float rotation;         // radianti
+    uint32_t spriteIndex;   // indice nella tabella dei rettangoli UV (vedi RegisterSprite)
+    uint32_t tint;          // RGBA8, R nel byte basso
 };
+static_assert(sizeof(InstancedData) == 24, "InstancedData must stay tightly packed");
+
+// Colore di default per le istanze senza tinta
+const uint32_t DEFAULT_SPRITE_TINT = 0xFFFFFFFFu;
+
+// Crea e distrugge le risorse GPU condivise dal rendering instanced.
+// I batch per materiale vengono accodati nella RenderQueue di 'renderer'.
+void InitRenderingSystem(Renderer& renderer);
+void ShutdownRenderingSystem();
+
+// Chiude lo slot del ring delle istanze usato nel frame. Va chiamata dopo Renderer::EndFrame,
+// quando le draw che leggono lo slot sono state inviate.
+void EndRenderingSystemFrame();
+
+// Registra un rettangolo UV (offset in xy, dimensione in zw) e restituisce l'indice da usare in SpriteRef.
+// Lo sprite 0 e' sempre l'intera texture.
+unsigned int RegisterSprite(const glm::vec4& uvRect);
 
 // Sistemi di rendering
-void RenderingSystem(flecs::iter& it, Position* p, Rotation* r, Scale* s, SpriteRef* spr, MaterialRef* mat);
\ No newline at end of file
+void RenderingSystem(flecs::iter& it);
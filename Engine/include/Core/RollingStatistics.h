@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Summary of the samples currently held by a RollingStatistics window, in milliseconds
+struct TimingStats
+{
+    std::string name;
+    double min = 0.0;
+    double avg = 0.0;
+    double p99 = 0.0;
+    double last = 0.0;
+    size_t samples = 0;
+};
+
+// Fixed-size window over the most recent samples. Add is O(1); Summarize sorts a copy of the
+// window, so it is meant for logging and graphing, not for every draw.
+class RollingStatistics
+{
+public:
+    explicit RollingStatistics(size_t capacity = 240);
+
+    void Add(double value);
+    void Clear();
+
+    TimingStats Summarize(const std::string& name) const;
+    size_t GetCount() const;
+
+private:
+    std::vector<double> window;
+    size_t next = 0;
+    size_t count = 0;
+    double last = 0.0;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <vector>
+#include "Core/Assets/Texture.h"
+
+// Sampling state of the engine textures. SMOOTH textures get trilinear filtering plus the
+// anisotropy set here; materials that need a LOD bias bind one of the shared sampler objects
+// over their textures. Render thread only.
+class SamplerCache
+{
+public:
+    static SamplerCache& GetInstance();
+
+    // Reads GL_MAX_TEXTURE_MAX_ANISOTROPY. Call once after the GL loader.
+    void Initialize();
+
+    // Anisotropic filtering of SMOOTH textures, clamped to the driver limit; 1 disables it.
+    // Samplers are updated at once, textures pick it up when their storage is created.
+    void SetAnisotropy(float anisotropy);
+    float GetAnisotropy() const;
+
+    // Filters, wrapping and anisotropy of a 2D or array texture with mipmaps for 'filter'
+    void ApplyParameters(GLuint texture, TextureFilter filter) const;
+
+    // Sampler with the ApplyParameters state and 'lodBias'. A zero bias returns 0: the
+    // parameters of the texture already match and the unit needs no sampler.
+    GLuint Get(TextureFilter filter, float lodBias);
+
+    // Deletes the samplers while the context is still alive
+    void Shutdown();
+
+private:
+    SamplerCache() = default;
+
+    struct Entry
+    {
+        TextureFilter filter;
+        float lodBias;
+        GLuint sampler;
+    };
+
+    std::vector<Entry> samplers;
+    float anisotropy = 1.0f;
+    float maxAnisotropy = 1.0f;
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "Core/Rendering.h"
+
+// Instruction sets the sprite transform kernel can be compiled for
+enum class SimdLevel
+{
+    Scalar,
+    SSE41,
+    AVX2
+};
+
+// Packs 'count' sprites from the flecs column arrays into the compact instance stream.
+// Sprite indices greater or equal to 'spriteCount' are replaced by sprite 0.
+using PackSpriteInstancesFunc = void (*)(const Position* positions, const Rotation* rotations, const Scale* scales, const SpriteRef* sprites,
+    size_t count, uint32_t spriteCount, uint32_t tint, InstancedData* out);
+
+// Best instruction set supported by the CPU and the OS, detected once
+SimdLevel GetSupportedSimdLevel();
+const char* GetSimdLevelName(SimdLevel level);
+
+// Kernel for a given level, clamped to what the CPU supports
+PackSpriteInstancesFunc GetPackSpriteInstances(SimdLevel level);
+
+// Runs the fastest kernel available on this CPU
+void PackSpriteInstances(const Position* positions, const Rotation* rotations, const Scale* scales, const SpriteRef* sprites,
+    size_t count, uint32_t spriteCount, uint32_t tint, InstancedData* out);
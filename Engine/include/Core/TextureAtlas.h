@@ -0,0 +1,144 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Core/Assets/Texture.h"
+
+// Pages are square GL_RGBA8 textures with a single mip level
+const int ATLAS_PAGE_SIZE = 2048;
+// Every texture is surrounded by a copy of its edge pixels, so filtering never reads a neighbour
+const int ATLAS_PADDING = 1;
+
+// Rectangle in pixels inside a page, padding included
+struct AtlasRect
+{
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
+
+// Bottom-left skyline packer: the used area is described by its top outline, each rectangle goes
+// where its top edge ends lowest. Space freed under the outline is only reclaimed by Reset.
+class SkylinePacker
+{
+public:
+    SkylinePacker(int width = ATLAS_PAGE_SIZE, int height = ATLAS_PAGE_SIZE);
+
+    void Reset();
+    // False if the rectangle does not fit anywhere
+    bool Insert(int width, int height, AtlasRect& rect);
+
+    // Area covered by the rectangles inserted since the last Reset
+    int64_t GetUsedArea() const;
+
+private:
+    struct Node
+    {
+        int x;
+        int y;
+        int width;
+    };
+
+    int width;
+    int height;
+    int64_t usedArea = 0;
+    std::vector<Node> skyline;
+
+    // Lowest y at which the rectangle fits with its left edge on node 'index', -1 if it does not
+    int Fit(size_t index, int width, int height) const;
+    void AddLevel(size_t index, const AtlasRect& rect);
+};
+
+struct TextureAtlasStats
+{
+    size_t pages = 0;
+    size_t textures = 0;
+    size_t bytes = 0;
+    // Live texture area over page area, padding included
+    float occupancy = 0.0f;
+    size_t repacks = 0;
+    size_t releasedPages = 0;
+    // Textures that fit the size limit but found no room within the budget
+    size_t rejected = 0;
+};
+
+// Packs small textures into shared pages, so sprites with different images can be drawn
+// with the same texture bound (and the same multi-draw, see Material::SharesTexturesWith).
+// A packed Texture reports the page as its ID and the sub-rectangle through GetUVRect, which
+// shaders apply to their texture coordinates. Pages are split by filter; SMOOTH pages are
+// linear without mipmaps, mip levels would bleed across neighbours.
+// Render thread only.
+class TextureAtlas
+{
+public:
+    static TextureAtlas& GetInstance();
+
+    // Textures with both sides up to 'size' pixels are packed; 0 disables the atlas.
+    // CanHold may be called from the asset workers.
+    void SetMaxTextureSize(int size);
+    bool CanHold(int width, int height) const;
+
+    // Upper bound of page memory, 0 for no limit. Lowering it repacks and releases pages.
+    void SetMemoryBudget(size_t bytes);
+
+    // Copies the image into a page and turns 'texture' into a resident view of it. Returns false
+    // when the image is too big or no page has room within the budget: the caller then gives the
+    // texture its own storage.
+    bool Insert(Texture& texture, const TextureImage& image);
+    // Called by ~Texture. A page left empty is released unless it is the last of its filter.
+    void Remove(Texture& texture);
+    // Called by Texture::TakeContents: the rectangle of 'from' now belongs to 'to'
+    void Transfer(Texture& from, Texture& to);
+
+    // Moves the live textures of each filter into as few pages as possible, if that saves a page.
+    // Called on its own when a new page would exceed the budget.
+    void Repack();
+
+    // Pages retired by Repack may still be read by frames in flight: they are deleted here,
+    // a few frames later. Once per frame.
+    void CollectRetiredPages();
+
+    TextureAtlasStats GetStats() const;
+
+    // Deletes every page while the context is still alive. Textures that still point to the
+    // atlas must not be drawn afterwards.
+    void Shutdown();
+
+private:
+    TextureAtlas() = default;
+
+    struct Page
+    {
+        GLuint id = 0;
+        TextureFilter filter = TextureFilter::SMOOTH;
+        SkylinePacker packer;
+        std::vector<Texture*> textures;
+        int64_t liveArea = 0;
+    };
+
+    struct RetiredPage
+    {
+        GLuint id;
+        uint64_t releaseFrame;
+    };
+
+    std::vector<std::unique_ptr<Page>> pages;
+    std::vector<RetiredPage> retired;
+    uint64_t frame = 0;
+    std::atomic<int> maxTextureSize = 256;
+    size_t memoryBudget = 64ull * 1024 * 1024;
+    TextureAtlasStats counters;
+
+    Page* Allocate(TextureFilter filter, int width, int height, AtlasRect& rect);
+    Page* FindPage(GLuint id);
+    bool CanAddPage() const;
+    std::unique_ptr<Page> CreatePage(TextureFilter filter);
+    void RetirePage(GLuint id);
+    bool Repack(TextureFilter filter);
+    void Place(Texture& texture, const Page& page, const AtlasRect& rect);
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Core/Assets/Texture.h"
+
+// GL_EXT_texture_compression_s3tc formats. S3TC is on every desktop driver but not in the core
+// profile, so the generated GL header does not define them.
+const GLenum COMPRESSED_RGB_S3TC_DXT1 = 0x83F0;   // BC1, opaque textures
+const GLenum COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;  // BC3, textures with alpha
+
+// Container of a compressed texture in an asset pack (PackEntryType::CompressedTexture): this
+// header followed by the blocks of every mip level, largest first. Offsets are from the start
+// of the header.
+const char COMPRESSED_TEXTURE_MAGIC[4] = { 'C', 'E', 'T', 'X' };
+const uint32_t MAX_COMPRESSED_LEVELS = 16;
+
+struct CompressedTextureHeader
+{
+    char magic[4];
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t levels;
+    uint32_t reserved;
+    uint32_t levelOffsets[MAX_COMPRESSED_LEVELS];
+    uint32_t levelSizes[MAX_COMPRESSED_LEVELS];
+};
+static_assert(sizeof(CompressedTextureHeader) == 152, "CompressedTextureHeader is part of the pack format");
+
+// CPU encoder and decoder for BC1/BC3 (DXT1/DXT5) blocks. The encoder fits the endpoints to
+// the bounding box of each 4x4 block along its dominant diagonal, the same approach as the
+// real-time DXT encoders: much faster than a cluster fit, a little lower quality.
+class TextureCompression
+{
+public:
+    // Checks GL_EXT_texture_compression_s3tc once, on the render thread after the GL loader.
+    // Without it (or on the null GL backend) compressed textures are decoded on the CPU.
+    static void Initialize();
+    static bool IsSupported();
+
+    // Builds the mip chain with a 2x2 box filter and encodes every level. BC1 is used when the
+    // image is fully opaque, BC3 otherwise. The result is the container described above.
+    static std::vector<unsigned char> Encode(const TextureImage& image);
+
+    // Reads a container without copying: the image points into 'data', which must stay alive.
+    // Returns false if the container is malformed.
+    static bool Read(const unsigned char* data, size_t size, TextureImage& image);
+
+    // Decodes level 0 of a compressed image into RGBA8 pixels
+    static TextureImage Decompress(const TextureImage& image);
+
+    // Size in bytes of one level
+    static size_t GetLevelSize(GLenum format, int width, int height);
+
+    // 'block' holds 16 RGBA8 texels, row by row
+    static void EncodeBC1Block(const unsigned char* block, unsigned char* output);
+    static void EncodeBC3Block(const unsigned char* block, unsigned char* output);
+    static void DecodeBC1Block(const unsigned char* input, unsigned char* block);
+    static void DecodeBC3Block(const unsigned char* input, unsigned char* block);
+};
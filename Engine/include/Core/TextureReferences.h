@@ -0,0 +1,86 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "Core/Assets/Texture.h"
+
+// How shaders that read their textures from the material table reach a texture. Bindless gives
+// a GL_ARB_bindless_texture handle; without it the texture is copied into a layer of a
+// GL_TEXTURE_2D_ARRAY and the shader samples textureArrays[array] at 'layer'.
+struct TextureReference
+{
+    uint64_t handle = 0;
+    uint32_t array = 0;
+    uint32_t layer = 0;
+};
+
+enum class TextureReferenceMode
+{
+    Bindless,
+    TextureArrays
+};
+
+// Array textures are bound to these units, read by "uniform sampler2DArray textureArrays[8]"
+const unsigned int TEXTURE_ARRAY_FIRST_UNIT = 16;
+const unsigned int MAX_TEXTURE_ARRAYS = 8;
+const char* const TEXTURE_ARRAYS_UNIFORM = "textureArrays";
+
+// Define added to every shader when the bindless path is active
+const char* const BINDLESS_TEXTURES_DEFINE = "ENGINE_BINDLESS_TEXTURES";
+
+// Resolves textures to TextureReferences. Render thread only.
+class TextureReferences
+{
+public:
+    static TextureReferences& GetInstance();
+
+    // Picks the mode. GL_ARB_bindless_texture is not part of the generated GL loader, so its
+    // entry points are loaded here through 'load'; with a null 'load' (e.g. the null GL backend)
+    // or without the extension the texture array fallback is used. Call once after the GL
+    // loader and before the first shader is compiled.
+    void Initialize(GLADloadfunc load);
+    TextureReferenceMode GetMode() const;
+
+    // Reference of a texture with 'levels' mip levels. Bindless handles are made resident on
+    // first use; in array mode the texture content is copied once into an array of the same
+    // internal format (compressed textures get their own arrays).
+    TextureReference Resolve(GLuint texture, int width, int height, GLsizei levels, TextureFilter filter, GLenum format = GL_RGBA8);
+    // Must be called before the texture is deleted
+    void Release(GLuint texture);
+    // Level 0 texels in the rectangle changed (e.g. an atlas page got a new texture): array
+    // mode copies them into the layer again. Nothing to do for bindless or unresolved textures.
+    void Update(GLuint texture, int x, int y, int width, int height);
+
+    // Array mode: binds the arrays to their units, once per frame before the draws
+    void BindArrays();
+
+    // Releases every handle and array while the context is still alive
+    void Shutdown();
+
+private:
+    TextureReferences() = default;
+
+    // Textures of the same size, mip count, filter and format share an array
+    struct ArrayBucket
+    {
+        GLuint id = 0;
+        int width = 0;
+        int height = 0;
+        GLsizei levels = 0;
+        TextureFilter filter = TextureFilter::SMOOTH;
+        GLenum format = GL_RGBA8;
+        uint32_t capacity = 0;
+        uint32_t used = 0;
+        std::vector<uint32_t> freeLayers;
+    };
+
+    TextureReferenceMode mode = TextureReferenceMode::TextureArrays;
+    std::unordered_map<GLuint, TextureReference> references;
+    std::vector<ArrayBucket> buckets;
+    bool reportedArrayLimit = false;
+
+    ArrayBucket* FindBucket(int width, int height, GLsizei levels, TextureFilter filter, GLenum format, uint32_t& index);
+    void GrowBucket(ArrayBucket& bucket);
+};
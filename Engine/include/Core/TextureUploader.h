@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include "Core/Assets/Texture.h"
+
+class PersistentRingBuffer;
+
+// Second stage of texture streaming. Worker threads hand over decoded pixels with Enqueue,
+// the render thread copies them to the GPU through a persistently mapped pixel unpack buffer.
+// Each frame uploads at most a byte and a time budget; large images are split in row bands
+// and completed over several frames instead of stalling one. Mip levels computed by the worker
+// (Texture::GenerateMipmaps) are streamed the same way after level 0.
+class TextureUploader
+{
+public:
+    TextureUploader();
+    ~TextureUploader();
+
+    TextureUploader(const TextureUploader&) = delete;
+    TextureUploader& operator=(const TextureUploader&) = delete;
+
+    // Thread safe. The uploader only keeps a weak reference: textures released before their
+    // upload are skipped.
+    void Enqueue(const std::shared_ptr<Texture>& texture, TextureImage&& image);
+
+    // Render thread only, once per frame
+    void ProcessUploads();
+
+    // A zero value disables that limit. At least one row band is uploaded per frame either way,
+    // so a tiny budget slows streaming down but never stops it.
+    void SetBudget(size_t bytesPerFrame, double millisecondsPerFrame);
+
+    size_t GetPendingCount();
+    size_t GetBytesUploadedLastFrame() const;
+
+    // Releases the staging buffer and the placeholder texture. Must run while the GL context
+    // is still alive; pending uploads are dropped.
+    void Shutdown();
+
+private:
+    struct PendingUpload
+    {
+        std::weak_ptr<Texture> texture;
+        TextureImage image;
+        int level = 0;
+        int rowsUploaded = 0;   // in 'level'
+    };
+
+    std::deque<PendingUpload> queue;
+    std::mutex queueMutex;
+
+    std::unique_ptr<PersistentRingBuffer> stagingRing;
+    size_t bytesPerFrame = 4 * 1024 * 1024;
+    double millisecondsPerFrame = 2.0;
+    size_t bytesUploadedLastFrame = 0;
+
+    // Uploads up to 'maxBytes' of rows of one level. Returns the number of bytes copied.
+    size_t UploadRows(PendingUpload& upload, Texture& texture, size_t maxBytes);
+    // Every row of every level is on the GPU
+    static bool IsComplete(const PendingUpload& upload);
+};
@@ -1,4 +1,5 @@
 #include "Core/Engine.h"
+#include "Core/AssetManager.h"
 
 int main()
 {
@@ -16,6 +17,21 @@ int main()
         world.entity("Player")
             .set<Position>({ 640.0f, 360.0f });
 
+        // Griglia di sprite che condividono lo stesso materiale: una sola draw call instanced
+        unsigned int spriteMaterial = AssetManager::GetInstance().RegisterMaterial("Resources/Assets/Materials/MM_sprite.json");
+        for (int y = 0; y < 32; ++y)
+        {
+            for (int x = 0; x < 32; ++x)
+            {
+                world.entity()
+                    .set<Position>({ 100.0f + x * 24.0f, 100.0f + y * 24.0f })
+                    .set<Rotation>({ static_cast<float>((x + y) * 10) })
+                    .set<Scale>({ 16.0f, 16.0f })
+                    .set<SpriteRef>({ 0 })
+                    .set<MaterialRef>({ spriteMaterial });
+            }
+        }
+
         engine.Run();
     }
     catch (const std::exception& e)
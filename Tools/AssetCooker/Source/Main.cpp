@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <nlohmann/json.hpp>
+#include "Core/AssetPack.h"
+#include "Core/Assets/Texture.h"
+#include "Core/TextureCompression.h"
+
+// Cuoce una cartella di risorse in un unico AssetPack:
+//   - i materiali JSON diventano MessagePack, senza parsing del testo a runtime
+//   - le immagini vengono decodificate in RGBA8, pronte per l'upload; quelle grandi vengono
+//     compresse in BC1/BC3 con tutta la catena di mipmap
+//   - i sorgenti degli shader vengono copiati cosi' come sono
+// Le chiavi sono i percorsi come li vede il gioco: va lanciato dalla cartella di lavoro del gioco,
+// ad esempio "AssetCooker Resources Resources.pack".
+//
+// Opzioni:
+//   --compress-all  comprime anche le immagini piccole, che cosi' non finiscono nel TextureAtlas
+//   --no-compress   lascia tutte le immagini in RGBA8
+
+// Lato oltre il quale un'immagine viene compressa: e' la dimensione massima predefinita del
+// TextureAtlas, le immagini piu' piccole restano RGBA8 per poter essere copiate nelle pagine
+static const int COMPRESS_MIN_SIZE = 256;
+
+static const char* const TEXTURE_EXTENSIONS[] = { ".png", ".jpg", ".jpeg", ".bmp", ".tga" };
+static const char* const SHADER_EXTENSIONS[] = { ".vert", ".frag", ".geom", ".comp", ".tesc", ".tese", ".glsl" };
+
+template<size_t N>
+static bool HasExtension(const std::string& extension, const char* const (&list)[N])
+{
+    for (const char* candidate : list)
+    {
+        if (extension == candidate)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static std::vector<unsigned char> ReadFile(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+int main(int argc, char** argv)
+{
+    bool compressAll = false;
+    bool compress = true;
+    int argument = 1;
+    for (; argument < argc && argv[argument][0] == '-'; ++argument)
+    {
+        if (std::strcmp(argv[argument], "--compress-all") == 0)
+        {
+            compressAll = true;
+        }
+        else if (std::strcmp(argv[argument], "--no-compress") == 0)
+        {
+            compress = false;
+        }
+        else
+        {
+            std::cerr << "ERROR: Unknown option: " << argv[argument] << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (argc - argument != 2)
+    {
+        std::cerr << "Usage: AssetCooker [--compress-all | --no-compress] <resource folder> <output pack>" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const char* const outputPath = argv[argument + 1];
+
+    const std::filesystem::path root = argv[argument];
+    if (!std::filesystem::is_directory(root))
+    {
+        std::cerr << "ERROR: Resource folder not found: " << root.string() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    AssetPackWriter writer;
+    size_t sourceBytes = 0;
+    size_t cookedBytes = 0;
+    int compressedTextures = 0;
+    int failures = 0;
+
+    for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator(root))
+    {
+        if (!entry.is_regular_file())
+        {
+            continue;
+        }
+
+        const std::string path = entry.path().generic_string();
+        std::string extension = entry.path().extension().string();
+        for (char& c : extension)
+        {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        sourceBytes += static_cast<size_t>(entry.file_size());
+
+        try
+        {
+            if (HasExtension(extension, TEXTURE_EXTENSIONS))
+            {
+                TextureImage image = Texture::Decode(path);
+                if (compress && (compressAll || std::max(image.width, image.height) > COMPRESS_MIN_SIZE))
+                {
+                    std::vector<unsigned char> blocks = TextureCompression::Encode(image);
+                    cookedBytes += blocks.size();
+                    compressedTextures++;
+                    writer.Add(path, PackEntryType::CompressedTexture, std::move(blocks), image.width, image.height);
+                }
+                else
+                {
+                    cookedBytes += image.pixels.size();
+                    writer.Add(path, PackEntryType::Texture, std::move(image.pixels), image.width, image.height);
+                }
+            }
+            else if (HasExtension(extension, SHADER_EXTENSIONS))
+            {
+                std::vector<unsigned char> source = ReadFile(entry.path());
+                cookedBytes += source.size();
+                writer.Add(path, PackEntryType::ShaderSource, std::move(source));
+            }
+            else if (extension == ".json")
+            {
+                std::ifstream file(entry.path());
+                std::vector<unsigned char> material = nlohmann::json::to_msgpack(nlohmann::json::parse(file));
+                cookedBytes += material.size();
+                writer.Add(path, PackEntryType::Material, std::move(material));
+            }
+            else
+            {
+                std::vector<unsigned char> data = ReadFile(entry.path());
+                cookedBytes += data.size();
+                writer.Add(path, PackEntryType::Raw, std::move(data));
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "ERROR: Failed to cook " << path << ": " << e.what() << std::endl;
+            failures++;
+        }
+    }
+
+    if (failures > 0 || !writer.Write(outputPath))
+    {
+        return EXIT_FAILURE;
+    }
+
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Cooked " << writer.GetEntryCount() << " assets (" << sourceBytes << " bytes of sources, "
+              << cookedBytes << " bytes cooked, " << compressedTextures << " compressed textures) into " << outputPath
+              << " in " << elapsed.count() << " ms" << std::endl;
+    return EXIT_SUCCESS;
+}